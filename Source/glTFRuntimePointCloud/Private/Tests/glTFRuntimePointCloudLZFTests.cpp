@@ -0,0 +1,139 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#include "glTFRuntimePointCloudLZF.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/* Compresses in a buffer of exactly GetCompressBound bytes (as the TArray64 overload of Compress does) and checks the round trip */
+	bool TestLZFRoundTrip(FAutomationTestBase& Test, const TArray64<uint8>& Input, const FString& What)
+	{
+		TArray64<uint8> Compressed;
+		Compressed.SetNumUninitialized(FglTFRuntimePointCloudLZF::GetCompressBound(Input.Num()));
+		const int64 CompressedSize = FglTFRuntimePointCloudLZF::Compress(Input.GetData(), Input.Num(), Compressed.GetData(), Compressed.Num());
+		if (!Test.TestTrue(FString::Printf(TEXT("%s compresses in the bound"), *What), CompressedSize >= 0))
+		{
+			return false;
+		}
+
+		TArray64<uint8> Decompressed;
+		Decompressed.SetNumZeroed(Input.Num());
+		const int64 DecompressedSize = FglTFRuntimePointCloudLZF::Decompress(Compressed.GetData(), CompressedSize, Decompressed.GetData(), Decompressed.Num());
+		if (!Test.TestEqual(FString::Printf(TEXT("%s decompressed size"), *What), DecompressedSize, Input.Num()))
+		{
+			return false;
+		}
+
+		return Test.TestTrue(FString::Printf(TEXT("%s round trip"), *What), FMemory::Memcmp(Decompressed.GetData(), Input.GetData(), Input.Num()) == 0);
+	}
+
+	TArray64<uint8> MakeLZFInput(const ANSICHAR* String)
+	{
+		TArray64<uint8> Input;
+		Input.Append(reinterpret_cast<const uint8*>(String), FCStringAnsi::Strlen(String));
+		return Input;
+	}
+
+	/* Small alphabets with sparse noise: plenty of short matches, some of them ending the input */
+	void MakeRandomLZFInput(FRandomStream& Random, const int32 MaxSize, TArray64<uint8>& Input)
+	{
+		const int32 Size = Random.RandRange(0, MaxSize);
+		const int32 Alphabet = Random.RandRange(1, 4);
+		Input.SetNumUninitialized(Size);
+		for (int32 Index = 0; Index < Size; Index++)
+		{
+			Input[Index] = static_cast<uint8>(Random.RandRange(0, Alphabet - 1) + (Random.RandRange(0, 7) == 0 ? Random.RandRange(0, 255) : 0));
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FglTFRuntimePointCloudLZFRoundTripTest, "glTFRuntimePointCloud.LZF.RoundTrip", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FglTFRuntimePointCloudLZFRoundTripTest::RunTest(const FString& Parameters)
+{
+	// short inputs and matches at the very end of the input
+	const ANSICHAR* Strings[] = { "", "a", "ab", "abc", "aaaa", "abcabc", "abcdabcd", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "xyzxyzxyzxyzxyzxyzxyz", "0123456789abcdef0123456789abcdef0123456789abcdefg" };
+	for (const ANSICHAR* String : Strings)
+	{
+		TestLZFRoundTrip(*this, MakeLZFInput(String), FString::Printf(TEXT("\"%s\""), ANSI_TO_TCHAR(String)));
+	}
+
+	// literal runs on the 32 bytes boundaries
+	FRandomStream Random(1234);
+	for (int32 Size : { 31, 32, 33, 63, 64, 65, 4096 })
+	{
+		TArray64<uint8> Input;
+		Input.SetNumUninitialized(Size);
+		for (int32 Index = 0; Index < Size; Index++)
+		{
+			Input[Index] = static_cast<uint8>(Random.RandRange(0, 255));
+		}
+		TestLZFRoundTrip(*this, Input, FString::Printf(TEXT("%d incompressible bytes"), Size));
+	}
+
+	TArray64<uint8> Input;
+	for (int32 Iteration = 0; Iteration < 20000; Iteration++)
+	{
+		MakeRandomLZFInput(Random, 300, Input);
+		if (!TestLZFRoundTrip(*this, Input, FString::Printf(TEXT("random buffer %d"), Iteration)))
+		{
+			break;
+		}
+	}
+
+	// corrupted data never writes past the output
+	TArray64<uint8> Compressed;
+	TestTrue(TEXT("Compress"), FglTFRuntimePointCloudLZF::Compress(MakeLZFInput("abcabcabcabc").GetData(), 12, Compressed));
+	uint8 Output[4];
+	TestEqual(TEXT("Decompress in a short output"), FglTFRuntimePointCloudLZF::Decompress(Compressed.GetData(), Compressed.Num(), Output, 4), -1LL);
+	const uint8 BadReference[] = { 0x20, 0x10 };
+	TestEqual(TEXT("Decompress of a reference before the output"), FglTFRuntimePointCloudLZF::Decompress(BadReference, 2, Output, 4), -1LL);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FglTFRuntimePointCloudLZFThroughputTest, "glTFRuntimePointCloud.LZF.Throughput", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FglTFRuntimePointCloudLZFThroughputTest::RunTest(const FString& Parameters)
+{
+	// point like records: slowly changing floats and a few repeated colors
+	constexpr int32 NumRecords = 4 * 1024 * 1024;
+	TArray64<uint8> Input;
+	Input.SetNumUninitialized(static_cast<int64>(NumRecords) * 16);
+	FRandomStream Random(42);
+	for (int32 Index = 0; Index < NumRecords; Index++)
+	{
+		const float Location[3] = { Index * 0.01f, FMath::Sin(Index * 0.001f), static_cast<float>(Random.RandRange(0, 15)) };
+		const uint32 Color = 0xFF000000 | (Random.RandRange(0, 3) * 0x404040);
+		FMemory::Memcpy(Input.GetData() + Index * 16, Location, sizeof(Location));
+		FMemory::Memcpy(Input.GetData() + Index * 16 + 12, &Color, sizeof(Color));
+	}
+
+	TArray64<uint8> Compressed;
+	const double CompressStart = FPlatformTime::Seconds();
+	if (!TestTrue(TEXT("Compress"), FglTFRuntimePointCloudLZF::Compress(Input.GetData(), Input.Num(), Compressed)))
+	{
+		return false;
+	}
+	const double CompressTime = FPlatformTime::Seconds() - CompressStart;
+
+	TArray64<uint8> Decompressed;
+	Decompressed.SetNumUninitialized(Input.Num());
+	const double DecompressStart = FPlatformTime::Seconds();
+	const int64 DecompressedSize = FglTFRuntimePointCloudLZF::Decompress(Compressed.GetData(), Compressed.Num(), Decompressed.GetData(), Decompressed.Num());
+	const double DecompressTime = FPlatformTime::Seconds() - DecompressStart;
+
+	TestEqual(TEXT("Decompressed size"), DecompressedSize, Input.Num());
+	TestTrue(TEXT("Round trip"), FMemory::Memcmp(Decompressed.GetData(), Input.GetData(), Input.Num()) == 0);
+
+	const double MegaBytes = Input.Num() / (1024.0 * 1024.0);
+	AddInfo(FString::Printf(TEXT("LZF %.1f MB -> %.1f MB, compress %.1f MB/s, decompress %.1f MB/s"),
+		MegaBytes, Compressed.Num() / (1024.0 * 1024.0), MegaBytes / FMath::Max(CompressTime, 1e-6), MegaBytes / FMath::Max(DecompressTime, 1e-6)));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,203 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#include "glTFRuntimePointCloudBenchmark.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	constexpr int64 LoaderTestNumPoints = 1000;
+	constexpr uint64 LoaderTestSeed = 1;
+
+	/* Keeps in the ground truth only the points accepted by the decimation (by input index) and by the filters, ranges are evaluated on the synthetic X */
+	void ApplyConfigToExpected(const FglTFRuntimePointCloudConfig& Config, const TArray64<FLidarPointCloudPoint>& Points, glTFRuntimePointCloud::FBenchmarkInput& Input)
+	{
+		const int64 NumPoints = Points.Num();
+		const int64 Stride = FMath::Max(1, Config.DecimationStride);
+		const int64 TargetPointCount = Config.DecimationTargetPointCount;
+
+		TArray64<FLidarPointCloudPoint> Expected;
+		for (int64 PointIndex = 0; PointIndex < NumPoints; PointIndex++)
+		{
+			if (Config.Decimation == EglTFRuntimePointCloudDecimation::Stride && PointIndex % Stride != 0)
+			{
+				continue;
+			}
+
+			if (Config.Decimation == EglTFRuntimePointCloudDecimation::TargetPointCount && TargetPointCount < NumPoints && (PointIndex * TargetPointCount) % NumPoints >= TargetPointCount)
+			{
+				continue;
+			}
+
+			const FLidarPointCloudPoint& ExpectedPoint = Input.Expected[PointIndex];
+			if (Config.CropBox.IsValid && !Config.CropBox.IsInsideOrOn(Config.CropBoxTransform.InverseTransformPosition(FVector(ExpectedPoint.Location))))
+			{
+				continue;
+			}
+
+			bool bInRanges = true;
+			for (const FglTFRuntimePointCloudRangeFilter& RangeFilter : Config.RangeFilters)
+			{
+				bInRanges &= Points[PointIndex].Location.X >= RangeFilter.Min && Points[PointIndex].Location.X <= RangeFilter.Max;
+			}
+
+			if (bInRanges)
+			{
+				Expected.Add(ExpectedPoint);
+			}
+		}
+
+		Input.Expected = MoveTemp(Expected);
+	}
+
+	/* Number of voxels of the ground truth, computed as the sink does */
+	int64 CountExpectedVoxels(const FglTFRuntimePointCloudConfig& Config, const glTFRuntimePointCloud::FBenchmarkInput& Input)
+	{
+		const double InvVoxelSize = 1.0 / Config.DecimationVoxelSize;
+		TSet<FIntVector> Voxels;
+		for (const FLidarPointCloudPoint& Point : Input.Expected)
+		{
+			Voxels.Add(FIntVector(
+				FMath::FloorToInt(Point.Location.X * InvVoxelSize),
+				FMath::FloorToInt(Point.Location.Y * InvVoxelSize),
+				FMath::FloorToInt(Point.Location.Z * InvVoxelSize)));
+		}
+		return Voxels.Num();
+	}
+
+	/* Loads the synthetic points in every format with Config and compares them with the ground truth (only the number of points for voxels and streamed formats) */
+	void TestLoaders(FAutomationTestBase& Test, const FglTFRuntimePointCloudConfig& Config)
+	{
+		TArray64<FLidarPointCloudPoint> Points;
+		glTFRuntimePointCloud::GenerateSyntheticPoints(LoaderTestSeed, LoaderTestNumPoints, Points);
+
+		for (const TCHAR* Format : glTFRuntimePointCloud::BenchmarkFormats)
+		{
+			// glTF range filters select attributes, the others fields or columns
+			FglTFRuntimePointCloudConfig FormatConfig = Config;
+			for (FglTFRuntimePointCloudRangeFilter& RangeFilter : FormatConfig.RangeFilters)
+			{
+				RangeFilter.Column = 0;
+				RangeFilter.Field = FCString::Strcmp(Format, TEXT("gltf")) == 0 ? TEXT("POSITION") : TEXT("x");
+			}
+
+			glTFRuntimePointCloud::FBenchmarkInput Input;
+			if (!Test.TestTrue(FString::Printf(TEXT("%s input"), Format), glTFRuntimePointCloud::CreateBenchmarkInput(Format, Points, Input)))
+			{
+				continue;
+			}
+
+			const bool bVoxels = FormatConfig.Decimation == EglTFRuntimePointCloudDecimation::VoxelGrid;
+			if (bVoxels)
+			{
+				FglTFRuntimePointCloudConfig FilterConfig = FormatConfig;
+				FilterConfig.Decimation = EglTFRuntimePointCloudDecimation::None;
+				ApplyConfigToExpected(FilterConfig, Points, Input);
+			}
+			else
+			{
+				ApplyConfigToExpected(FormatConfig, Points, Input);
+			}
+
+			FglTFRuntimePointCloudLoadContext Context(FormatConfig);
+			TArray64<FLidarPointCloudPoint> LoadedPoints;
+			int64 NumStreamedPoints = 0;
+			const bool bLoaded = glTFRuntimePointCloud::LoadBenchmarkPoints(Format, Input, Context, LoadedPoints, NumStreamedPoints);
+
+			if (!Input.Filename.IsEmpty())
+			{
+				IFileManager::Get().Delete(*Input.Filename);
+			}
+
+			if (!Test.TestTrue(FString::Printf(TEXT("%s loaded"), Format), bLoaded))
+			{
+				continue;
+			}
+
+			const int64 NumLoadedPoints = Input.Filename.IsEmpty() ? LoadedPoints.Num() : NumStreamedPoints;
+			if (bVoxels)
+			{
+				Test.TestEqual(FString::Printf(TEXT("%s voxels"), Format), NumLoadedPoints, CountExpectedVoxels(FormatConfig, Input));
+			}
+			else if (Input.Filename.IsEmpty())
+			{
+				Test.TestEqual(FString::Printf(TEXT("%s mismatches"), Format), glTFRuntimePointCloud::CountMismatches(LoadedPoints, Input), static_cast<int64>(0));
+			}
+			else
+			{
+				Test.TestEqual(FString::Printf(TEXT("%s streamed points"), Format), NumLoadedPoints, Input.Expected.Num());
+			}
+
+			if (FormatConfig.Decimation == EglTFRuntimePointCloudDecimation::None)
+			{
+				Test.TestEqual(FString::Printf(TEXT("%s rejected points"), Format), Context.NumRejectedPoints.load(), LoaderTestNumPoints - Input.Expected.Num());
+			}
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FglTFRuntimePointCloudLoadersTest, "glTFRuntimePointCloud.Loaders.Formats", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FglTFRuntimePointCloudLoadersTest::RunTest(const FString& Parameters)
+{
+	TestLoaders(*this, FglTFRuntimePointCloudConfig());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FglTFRuntimePointCloudDecimationTest, "glTFRuntimePointCloud.Loaders.Decimation", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FglTFRuntimePointCloudDecimationTest::RunTest(const FString& Parameters)
+{
+	FglTFRuntimePointCloudConfig Config;
+
+	Config.Decimation = EglTFRuntimePointCloudDecimation::Stride;
+	Config.DecimationStride = 3;
+	TestLoaders(*this, Config);
+
+	Config.Decimation = EglTFRuntimePointCloudDecimation::TargetPointCount;
+	Config.DecimationTargetPointCount = 333;
+	TestLoaders(*this, Config);
+
+	// more than the input: every point is kept
+	Config.DecimationTargetPointCount = LoaderTestNumPoints * 2;
+	TestLoaders(*this, Config);
+
+	// the cell size is never a multiple of the synthetic coordinates step
+	Config.Decimation = EglTFRuntimePointCloudDecimation::VoxelGrid;
+	Config.DecimationVoxelSize = 10000.3f;
+	TestLoaders(*this, Config);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FglTFRuntimePointCloudFiltersTest, "glTFRuntimePointCloud.Loaders.Filters", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FglTFRuntimePointCloudFiltersTest::RunTest(const FString& Parameters)
+{
+	FglTFRuntimePointCloudConfig CropConfig;
+	CropConfig.CropBox = FBox(FVector(-20000, -40000, -30000), FVector(30000, 20000, 40000));
+	CropConfig.CropBoxTransform = FTransform(FVector(1024, 0, -512));
+	TestLoaders(*this, CropConfig);
+
+	FglTFRuntimePointCloudConfig RangeConfig;
+	FglTFRuntimePointCloudRangeFilter RangeFilter;
+	RangeFilter.Min = -1000;
+	RangeFilter.Max = 30000;
+	RangeConfig.RangeFilters.Add(RangeFilter);
+	TestLoaders(*this, RangeConfig);
+
+	FglTFRuntimePointCloudConfig CombinedConfig = CropConfig;
+	CombinedConfig.RangeFilters = RangeConfig.RangeFilters;
+	TestLoaders(*this, CombinedConfig);
+
+	// filters are applied to the decimated points
+	CombinedConfig.Decimation = EglTFRuntimePointCloudDecimation::Stride;
+	CombinedConfig.DecimationStride = 2;
+	TestLoaders(*this, CombinedConfig);
+
+	return true;
+}
+
+#endif
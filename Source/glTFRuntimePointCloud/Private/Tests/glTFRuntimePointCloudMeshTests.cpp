@@ -0,0 +1,210 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#include "glTFRuntimePointCloudBenchmark.h"
+#include "glTFRuntimePointCloudMeshopt.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/*
+	 * 20 vertices of 4 bytes (2 groups per byte stream): byte 0 uses 2 bit groups (with an escape), byte 1 4 bit groups (with an escape),
+	 * byte 2 zero groups and byte 3 raw groups, followed by the 32 bytes tail ending with the first vertex.
+	 */
+	const uint8 MeshoptEncoded[] =
+	{
+		0xa0, 0x05, 0x2a, 0xaa, 0xaa, 0xba, 0x50, 0xaa, 0x00, 0x00, 0x00, 0x0a, 0x06, 0x3a, 0x92, 0x0d,
+		0x84, 0x1c, 0x50, 0x4f, 0x12, 0x72, 0x6b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x00,
+		0x9a, 0xfa, 0x9c, 0x1a, 0x16, 0xe9, 0xc4, 0xa0, 0xb3, 0x32, 0x9b, 0x0f, 0x9a, 0xb0, 0x99, 0xa9,
+		0x8a, 0x42, 0x66, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x80, 0x42, 0x00
+	};
+
+	const uint8 MeshoptDecoded[] =
+	{
+		0x10, 0x80, 0x42, 0x00, 0x11, 0x83, 0x42, 0x4d, 0x12, 0x81, 0x42, 0xca, 0x13, 0x86, 0x42, 0x18,
+		0x14, 0x81, 0x42, 0x25, 0x15, 0x82, 0x42, 0x30, 0x16, 0x82, 0x42, 0xbb, 0x17, 0x7b, 0x42, 0x1d,
+		0x18, 0x7f, 0x42, 0x6d, 0x19, 0x81, 0x42, 0x13, 0x1a, 0x80, 0x42, 0x2c, 0x1b, 0x86, 0x42, 0xde,
+		0x1c, 0x83, 0x42, 0xd6, 0x44, 0x83, 0x42, 0x23, 0x45, 0x85, 0x42, 0x7b, 0x46, 0x8e, 0x42, 0x2e,
+		0x47, 0x8a, 0x42, 0xd9, 0x48, 0x8b, 0x42, 0x1e, 0x49, 0x8e, 0x42, 0x3f, 0x4a, 0x88, 0x42, 0x72
+	};
+
+	constexpr int64 MeshoptVertexSize = 4;
+	constexpr int64 MeshoptVertexCount = sizeof(MeshoptDecoded) / MeshoptVertexSize;
+
+	/* int16 positions padded to 8 bytes, the minimum of each component is in the second vertex */
+	const int16 QuantizedPositions[4][4] =
+	{
+		{ 100, -200, 300, 0 },
+		{ -32768, -32767, -1, 0 },
+		{ 32767, 16384, 0, 0 },
+		{ 1, 2, -3, 0 }
+	};
+
+	/* int8 normals padded to 4 bytes */
+	const int8 QuantizedNormals[4][4] =
+	{
+		{ 127, 0, 0, 0 },
+		{ 0, -128, 0, 0 },
+		{ 0, 0, -127, 0 },
+		{ -90, 90, 0, 0 }
+	};
+
+	const uint8 QuantizedIndices[4] = { 3, 2, 1, 0 };
+
+	/*
+	 * Mesh 0: normalized POSITION without indices (column decoding) and with indices (per point decoding),
+	 * mesh 1: unnormalized POSITION (the KHR_mesh_quantization dequantization transform would live in the node).
+	 */
+	void WriteQuantizedGLB(TArray64<uint8>& Blob)
+	{
+		TArray64<uint8> Binary;
+		Binary.Append(reinterpret_cast<const uint8*>(QuantizedPositions), sizeof(QuantizedPositions));
+		Binary.Append(reinterpret_cast<const uint8*>(QuantizedNormals), sizeof(QuantizedNormals));
+		Binary.Append(QuantizedIndices, sizeof(QuantizedIndices));
+
+		const FString Json = FString::Printf(TEXT("{\"asset\":{\"version\":\"2.0\"},\"extensionsUsed\":[\"KHR_mesh_quantization\"],")
+			TEXT("\"scene\":0,\"scenes\":[{\"nodes\":[0,1]}],\"nodes\":[{\"mesh\":0},{\"mesh\":1}],")
+			TEXT("\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":2},\"mode\":0},{\"attributes\":{\"POSITION\":0,\"NORMAL\":2},\"indices\":3,\"mode\":0}]},")
+			TEXT("{\"primitives\":[{\"attributes\":{\"POSITION\":1,\"NORMAL\":2},\"mode\":0}]}],")
+			TEXT("\"buffers\":[{\"byteLength\":%lld}],")
+			TEXT("\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":32,\"byteStride\":8},{\"buffer\":0,\"byteOffset\":32,\"byteLength\":16,\"byteStride\":4},{\"buffer\":0,\"byteOffset\":48,\"byteLength\":4}],")
+			TEXT("\"accessors\":[{\"bufferView\":0,\"componentType\":5122,\"normalized\":true,\"count\":4,\"type\":\"VEC3\",\"min\":[-1,-1,-1],\"max\":[1,0.5,1]},")
+			TEXT("{\"bufferView\":0,\"componentType\":5122,\"count\":4,\"type\":\"VEC3\",\"min\":[-32768,-32767,-3],\"max\":[32767,16384,300]},")
+			TEXT("{\"bufferView\":1,\"componentType\":5120,\"normalized\":true,\"count\":4,\"type\":\"VEC3\"},")
+			TEXT("{\"bufferView\":2,\"componentType\":5121,\"count\":4,\"type\":\"SCALAR\"}]}"),
+			Binary.Num());
+		FTCHARToUTF8 JsonUTF8(*Json);
+
+		const int64 JsonChunkSize = Align(JsonUTF8.Length(), 4);
+
+		auto AppendUInt32 = [&Blob](const uint32 Value)
+			{
+				Blob.Append(reinterpret_cast<const uint8*>(&Value), sizeof(uint32));
+			};
+
+		Blob.Reset();
+		AppendUInt32(0x46546C67); // glTF
+		AppendUInt32(2);
+		AppendUInt32(static_cast<uint32>(12 + 8 + JsonChunkSize + 8 + Binary.Num()));
+
+		AppendUInt32(static_cast<uint32>(JsonChunkSize));
+		AppendUInt32(0x4E4F534A); // JSON
+		Blob.Append(reinterpret_cast<const uint8*>(JsonUTF8.Get()), JsonUTF8.Length());
+		while (Blob.Num() < 20 + JsonChunkSize)
+		{
+			Blob.Add(' ');
+		}
+
+		AppendUInt32(static_cast<uint32>(Binary.Num()));
+		AppendUInt32(0x004E4942); // BIN
+		Blob.Append(Binary);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FglTFRuntimePointCloudMeshoptTest, "glTFRuntimePointCloud.Meshopt.DecodeVertexBuffer", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FglTFRuntimePointCloudMeshoptTest::RunTest(const FString& Parameters)
+{
+	using namespace glTFRuntimePointCloud;
+
+	TArray<uint8> Decoded;
+	Decoded.SetNumZeroed(sizeof(MeshoptDecoded));
+	if (TestTrue(TEXT("Decoded"), Meshopt::DecodeVertexBuffer(Decoded.GetData(), MeshoptVertexCount, MeshoptVertexSize, MeshoptEncoded, sizeof(MeshoptEncoded))))
+	{
+		TestTrue(TEXT("Decoded vertices"), FMemory::Memcmp(Decoded.GetData(), MeshoptDecoded, sizeof(MeshoptDecoded)) == 0);
+	}
+
+	// the tail must be exactly where the blocks end: any truncation (or trailing byte) is malformed data
+	int32 NumAcceptedTruncations = 0;
+	for (int64 DataSize = 0; DataSize < static_cast<int64>(sizeof(MeshoptEncoded)); DataSize++)
+	{
+		NumAcceptedTruncations += Meshopt::DecodeVertexBuffer(Decoded.GetData(), MeshoptVertexCount, MeshoptVertexSize, MeshoptEncoded, DataSize) ? 1 : 0;
+	}
+	TestEqual(TEXT("Accepted truncations"), NumAcceptedTruncations, 0);
+
+	TArray<uint8> Encoded(MeshoptEncoded, sizeof(MeshoptEncoded));
+	Encoded.Add(0);
+	TestFalse(TEXT("Trailing byte"), Meshopt::DecodeVertexBuffer(Decoded.GetData(), MeshoptVertexCount, MeshoptVertexSize, Encoded.GetData(), Encoded.Num()));
+
+	Encoded.Pop();
+	Encoded[0] = 0xa1;
+	TestFalse(TEXT("Unsupported version"), Meshopt::DecodeVertexBuffer(Decoded.GetData(), MeshoptVertexCount, MeshoptVertexSize, Encoded.GetData(), Encoded.Num()));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FglTFRuntimePointCloudQuantizedTest, "glTFRuntimePointCloud.Loaders.Quantized", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FglTFRuntimePointCloudQuantizedTest::RunTest(const FString& Parameters)
+{
+	using namespace glTFRuntimePointCloud;
+
+	FBenchmarkInput Input;
+	WriteQuantizedGLB(Input.Blob);
+
+	Input.Parser = CreateBenchmarkParser(Input.Blob, false);
+	if (!TestNotNull(TEXT("Parser"), Input.Parser.Get()))
+	{
+		return false;
+	}
+
+	FPointBasis Basis;
+	Basis.Init(*Input.Parser);
+
+	// normalized signed values are clamped to -1, unnormalized ones keep their value
+	TArray64<FVector3f> ExpectedNormals;
+	auto AddExpected = [&](const int32 Vertex, const bool bNormalized)
+		{
+			float Location[3];
+			float Normal[3];
+			for (int32 Component = 0; Component < 3; Component++)
+			{
+				const float Position = QuantizedPositions[Vertex][Component];
+				Location[Component] = bNormalized ? FMath::Max(Position / 32767.0f, -1.0f) : Position;
+				Normal[Component] = FMath::Max(QuantizedNormals[Vertex][Component] / 127.0f, -1.0f);
+			}
+
+			FLidarPointCloudPoint ExpectedPoint;
+			ExpectedPoint.Location = Basis.TransformPosition(Location);
+			Input.Expected.Add(ExpectedPoint);
+			ExpectedNormals.Add(Basis.TransformNormal(Normal));
+		};
+
+	for (int32 Vertex = 0; Vertex < 4; Vertex++)
+	{
+		AddExpected(Vertex, true);
+	}
+	for (const uint8 Vertex : QuantizedIndices)
+	{
+		AddExpected(Vertex, true);
+	}
+	for (int32 Vertex = 0; Vertex < 4; Vertex++)
+	{
+		AddExpected(Vertex, false);
+	}
+
+	FglTFRuntimePointCloudLoadContext Context;
+	TArray64<FLidarPointCloudPoint> Points;
+	if (!TestTrue(TEXT("Loaded"), UglTFRuntimePointCloudLibrary::LoadPointsFromMeshes(Input.Parser.ToSharedRef(), { 0, 1 }, Points, Context)))
+	{
+		return false;
+	}
+
+	TestEqual(TEXT("Mismatches"), CountMismatches(Points, Input), static_cast<int64>(0));
+
+	if (Points.Num() == ExpectedNormals.Num())
+	{
+		for (int64 PointIndex = 0; PointIndex < Points.Num(); PointIndex++)
+		{
+			// FLidarPointCloudNormal keeps 8 bits per component
+			TestTrue(FString::Printf(TEXT("Normal %lld"), PointIndex), Points[PointIndex].Normal.ToVector().Equals(ExpectedNormals[PointIndex], 0.02f));
+		}
+	}
+
+	return true;
+}
+
+#endif
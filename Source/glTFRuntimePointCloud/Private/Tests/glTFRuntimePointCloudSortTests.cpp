@@ -0,0 +1,119 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#include "glTFRuntimePointCloudSort.h"
+#include "glTFRuntimePointCloudSynthetic.h"
+#include "Algo/StableSort.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/* more than a block, the last one is partial */
+	constexpr int64 SortTestNumPoints = glTFRuntimePointCloud::SortPointsPerBlock * 3 + 123;
+	constexpr uint64 SortTestSeed = 2;
+
+	/* Points on a GridSize^3 grid (many of them share a key), the color stores the input index to check the stability */
+	void GenerateSortTestPoints(const int64 NumPoints, const int32 GridSize, TArray64<FLidarPointCloudPoint>& Points)
+	{
+		Points.SetNumUninitialized(NumPoints);
+		for (int64 PointIndex = 0; PointIndex < NumPoints; PointIndex++)
+		{
+			const uint64 Bits = glTFRuntimePointCloud::SyntheticHash(SortTestSeed ^ glTFRuntimePointCloud::SyntheticHash(PointIndex));
+
+			FLidarPointCloudPoint Point;
+			Point.Location = FVector3f((Bits % GridSize) * 100.0f, ((Bits >> 20) % GridSize) * 100.0f, ((Bits >> 40) % GridSize) * 100.0f);
+			Point.Color = FColor(static_cast<uint8>(PointIndex), static_cast<uint8>(PointIndex >> 8), static_cast<uint8>(PointIndex >> 16), static_cast<uint8>(PointIndex >> 24));
+			Points[PointIndex] = Point;
+		}
+	}
+
+	/* Number of points not in the position given by a stable sort of the Morton keys of Input */
+	int64 CountSortMismatches(const TArray64<FLidarPointCloudPoint>& Input, const TArray64<FLidarPointCloudPoint>& Sorted, const FBox3f& Bounds)
+	{
+		if (Input.Num() != Sorted.Num())
+		{
+			return FMath::Abs(Input.Num() - Sorted.Num());
+		}
+
+		const float Scale = glTFRuntimePointCloud::GetMortonScale(Bounds);
+		TArray64<uint64> Keys;
+		TArray64<int64> Order;
+		Keys.SetNumUninitialized(Input.Num());
+		Order.SetNumUninitialized(Input.Num());
+		for (int64 PointIndex = 0; PointIndex < Input.Num(); PointIndex++)
+		{
+			Keys[PointIndex] = glTFRuntimePointCloud::GetMortonKey(Input[PointIndex].Location, Bounds.Min, Scale);
+			Order[PointIndex] = PointIndex;
+		}
+
+		Algo::StableSortBy(Order, [&Keys](const int64 PointIndex) { return Keys[PointIndex]; });
+
+		int64 NumMismatches = 0;
+		for (int64 PointIndex = 0; PointIndex < Sorted.Num(); PointIndex++)
+		{
+			const FLidarPointCloudPoint& Expected = Input[Order[PointIndex]];
+			if (Sorted[PointIndex].Location != Expected.Location || Sorted[PointIndex].Color != Expected.Color)
+			{
+				NumMismatches++;
+			}
+		}
+		return NumMismatches;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FglTFRuntimePointCloudSortTest, "glTFRuntimePointCloud.Sort", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FglTFRuntimePointCloudSortTest::RunTest(const FString& Parameters)
+{
+	using namespace glTFRuntimePointCloud;
+
+	FglTFRuntimePointCloudLoadContext Context;
+
+	for (const int64 NumPoints : { 0, 1 })
+	{
+		TArray64<FLidarPointCloudPoint> Points;
+		GenerateSortTestPoints(NumPoints, 16, Points);
+		const TArray64<FLidarPointCloudPoint> Input = Points;
+		TestTrue(FString::Printf(TEXT("%lld points sorted"), NumPoints), SortPointsByMortonKey(Points, Context));
+		TestEqual(FString::Printf(TEXT("%lld points mismatches"), NumPoints), CountSortMismatches(Input, Points, FBox3f(FVector3f::ZeroVector, FVector3f::ZeroVector)), static_cast<int64>(0));
+	}
+
+	// all of the keys are 0: every pass is skipped and the order does not change
+	{
+		TArray64<FLidarPointCloudPoint> Points;
+		GenerateSortTestPoints(SortTestNumPoints, 1, Points);
+		const TArray64<FLidarPointCloudPoint> Input = Points;
+		TestTrue(TEXT("Identical points sorted"), SortPointsByMortonKey(Points, Context));
+		TestEqual(TEXT("Identical points mismatches"), CountSortMismatches(Input, Points, ComputePointsBounds(Input)), static_cast<int64>(0));
+	}
+
+	TArray64<FLidarPointCloudPoint> Input;
+	GenerateSortTestPoints(SortTestNumPoints, 16, Input);
+
+	{
+		TArray64<FLidarPointCloudPoint> Points = Input;
+		TestTrue(TEXT("Grid points sorted"), SortPointsByMortonKey(Points, Context));
+		TestEqual(TEXT("Grid points mismatches"), CountSortMismatches(Input, Points, ComputePointsBounds(Input)), static_cast<int64>(0));
+	}
+
+	// the points only fill the lower corner of the bounds: the high digit of every key is 0 and its pass is skipped between the others
+	FBox3f Bounds = ComputePointsBounds(Input);
+	Bounds.Max = Bounds.Min + Bounds.GetSize() * 8;
+
+	{
+		TArray64<FLidarPointCloudPoint> Points = Input;
+		TestTrue(TEXT("Corner points sorted"), SortPointsByMortonKey<uint32>(Points, Bounds, Context));
+		TestEqual(TEXT("Corner points mismatches"), CountSortMismatches(Input, Points, Bounds), static_cast<int64>(0));
+	}
+
+	{
+		TArray64<FLidarPointCloudPoint> Points = Input;
+		TestTrue(TEXT("Corner points sorted with 64 bits indices"), SortPointsByMortonKey<int64>(Points, Bounds, Context));
+		TestEqual(TEXT("Corner points mismatches with 64 bits indices"), CountSortMismatches(Input, Points, Bounds), static_cast<int64>(0));
+	}
+
+	return true;
+}
+
+#endif
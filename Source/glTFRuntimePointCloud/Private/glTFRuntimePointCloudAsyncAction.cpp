@@ -0,0 +1,546 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#include "glTFRuntimePointCloudAsyncAction.h"
+#include "Async/Async.h"
+#include "glTFRuntimePointCloudSort.h"
+#include "glTFRuntimePointCloudStats.h"
+
+namespace glTFRuntimePointCloud
+{
+	/* points inserted in the octree before refreshing the rendering of a progressive load */
+	constexpr int64 ProgressiveBatchSize = 1024 * 1024;
+
+	/* a sample rarely holds the extreme points: the preview octree is enlarged to avoid rebuilding it for the remaining ones */
+	constexpr float ProgressiveBoundsMargin = 0.05f;
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudAsyncAction::CreateAction(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig, TFunction<bool(FglTFRuntimePointCloudLoadContext& Context, TArray64<FLidarPointCloudPoint>& Points)> InLoader)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = NewObject<UglTFRuntimePointCloudAsyncAction>();
+	Action->Asset = Asset;
+	Action->PointCloudConfig = PointCloudConfig;
+	if (Asset)
+	{
+		Action->Loader = MoveTemp(InLoader);
+	}
+	return Action;
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudAsyncAction::CreateStreamAction(const FglTFRuntimePointCloudConfig& PointCloudConfig, TFunction<bool(FglTFRuntimePointCloudLoadContext& Context, ULidarPointCloud* PointCloud)> InStreamLoader)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = NewObject<UglTFRuntimePointCloudAsyncAction>();
+	Action->PointCloudConfig = PointCloudConfig;
+	Action->StreamLoader = MoveTemp(InStreamLoader);
+	return Action;
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromMesh(UglTFRuntimeAsset* Asset, const int32 MeshIndex, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	return AsyncLoadPointCloudFromMeshes(Asset, { MeshIndex }, PointCloudConfig);
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromMeshes(UglTFRuntimeAsset* Asset, const TArray<int32>& MeshIndices, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	TSharedPtr<FglTFRuntimeParser> Parser = Asset ? Asset->GetParser() : nullptr;
+	return CreateAction(Asset, PointCloudConfig, [Parser, MeshIndices](FglTFRuntimePointCloudLoadContext& Context, TArray64<FLidarPointCloudPoint>& Points)
+		{
+			return UglTFRuntimePointCloudLibrary::LoadPointsFromMeshes(Parser.ToSharedRef(), MeshIndices, Points, Context);
+		});
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromXYZ(UglTFRuntimeAsset* Asset, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	TSharedPtr<FglTFRuntimeParser> Parser = Asset ? Asset->GetParser() : nullptr;
+	return CreateAction(Asset, PointCloudConfig, [Parser, ASCIIPointCloudConfig](FglTFRuntimePointCloudLoadContext& Context, TArray64<FLidarPointCloudPoint>& Points)
+		{
+			return UglTFRuntimePointCloudLibrary::LoadPointsFromXYZ(Parser.ToSharedRef(), nullptr, nullptr, ASCIIPointCloudConfig, Points, Context);
+		});
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromPCD(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	TSharedPtr<FglTFRuntimeParser> Parser = Asset ? Asset->GetParser() : nullptr;
+	return CreateAction(Asset, PointCloudConfig, [Parser](FglTFRuntimePointCloudLoadContext& Context, TArray64<FLidarPointCloudPoint>& Points)
+		{
+			return UglTFRuntimePointCloudLibrary::LoadPointsFromPCD(Parser.ToSharedRef(), Context.ViewPoint, Points, Context);
+		});
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromLAS(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	TSharedPtr<FglTFRuntimeParser> Parser = Asset ? Asset->GetParser() : nullptr;
+	return CreateAction(Asset, PointCloudConfig, [Parser](FglTFRuntimePointCloudLoadContext& Context, TArray64<FLidarPointCloudPoint>& Points)
+		{
+			return UglTFRuntimePointCloudLibrary::LoadPointsFromLAS(Parser.ToSharedRef(), Context.Origin, Points, Context);
+		});
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromPLY(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	TSharedPtr<FglTFRuntimeParser> Parser = Asset ? Asset->GetParser() : nullptr;
+	return CreateAction(Asset, PointCloudConfig, [Parser](FglTFRuntimePointCloudLoadContext& Context, TArray64<FLidarPointCloudPoint>& Points)
+		{
+			return UglTFRuntimePointCloudLibrary::LoadPointsFromPLY(Parser.ToSharedRef(), Points, Context);
+		});
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromLASFile(const FString& Filename, const int32 MemoryBudgetMB, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	return CreateStreamAction(PointCloudConfig, [Filename, MemoryBudgetMB](FglTFRuntimePointCloudLoadContext& Context, ULidarPointCloud* PointCloud)
+		{
+			return UglTFRuntimePointCloudLibrary::StreamPointsFromLASFile(Filename, static_cast<int64>(MemoryBudgetMB) * 1024 * 1024, Context.Origin, PointCloud, Context);
+		});
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromXYZFile(const FString& Filename, const int32 MemoryBudgetMB, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	return CreateStreamAction(PointCloudConfig, [Filename, MemoryBudgetMB, ASCIIPointCloudConfig](FglTFRuntimePointCloudLoadContext& Context, ULidarPointCloud* PointCloud)
+		{
+			return UglTFRuntimePointCloudLibrary::StreamPointsFromXYZFile(Filename, static_cast<int64>(MemoryBudgetMB) * 1024 * 1024, ASCIIPointCloudConfig, PointCloud, Context);
+		});
+}
+
+int32 UglTFRuntimePointCloudAsyncAction::GetProgressiveStride(const float PreviewFraction)
+{
+	if (PreviewFraction <= 0 || PreviewFraction >= 1)
+	{
+		return 0;
+	}
+	return FMath::Max(2, FMath::RoundToInt(1.0f / PreviewFraction));
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromMeshesProgressive(UglTFRuntimeAsset* Asset, const TArray<int32>& MeshIndices, const float PreviewFraction, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = AsyncLoadPointCloudFromMeshes(Asset, MeshIndices, PointCloudConfig);
+	Action->ProgressiveStride = GetProgressiveStride(PreviewFraction);
+	return Action;
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromXYZProgressive(UglTFRuntimeAsset* Asset, const float PreviewFraction, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = AsyncLoadPointCloudFromXYZ(Asset, ASCIIPointCloudConfig, PointCloudConfig);
+	Action->ProgressiveStride = GetProgressiveStride(PreviewFraction);
+	return Action;
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromPCDProgressive(UglTFRuntimeAsset* Asset, const float PreviewFraction, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = AsyncLoadPointCloudFromPCD(Asset, PointCloudConfig);
+	Action->ProgressiveStride = GetProgressiveStride(PreviewFraction);
+	return Action;
+}
+
+void UglTFRuntimePointCloudAsyncAction::Cancel()
+{
+	if (Context)
+	{
+		Context->Cancel();
+	}
+}
+
+bool UglTFRuntimePointCloudAsyncAction::IsRunning() const
+{
+	return Context.IsValid();
+}
+
+int64 UglTFRuntimePointCloudAsyncAction::GetNumRejectedPoints() const
+{
+	return NumRejectedPoints;
+}
+
+FglTFRuntimePointCloudLoadReport UglTFRuntimePointCloudAsyncAction::GetLoadReport() const
+{
+	return LoadReport;
+}
+
+FVector UglTFRuntimePointCloudAsyncAction::GetOrigin() const
+{
+	return Origin;
+}
+
+FTransform UglTFRuntimePointCloudAsyncAction::GetViewPoint() const
+{
+	return ViewPoint;
+}
+
+void UglTFRuntimePointCloudAsyncAction::Activate()
+{
+	if (Context)
+	{
+		return;
+	}
+
+	if (!Loader && !StreamLoader)
+	{
+		Finish(nullptr);
+		return;
+	}
+
+	// keep the action (and the asset blob) alive until the octree is ready
+	AddToRoot();
+
+	Context = MakeShared<FglTFRuntimePointCloudLoadContext, ESPMode::ThreadSafe>(PointCloudConfig);
+
+	TWeakObjectPtr<UglTFRuntimePointCloudAsyncAction> WeakThis = this;
+	Context->ProgressCallback = [WeakThis](const EglTFRuntimePointCloudLoadPhase Phase, const float Value)
+		{
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, Phase, Value]()
+				{
+					if (WeakThis.IsValid())
+					{
+						WeakThis->NotifyProgress(Phase, Value);
+					}
+				});
+		};
+
+	if (StreamLoader)
+	{
+		Stream();
+		return;
+	}
+
+	if (ProgressiveStride > 1)
+	{
+		Progressive();
+		return;
+	}
+
+	TSharedRef<FglTFRuntimePointCloudLoadContext, ESPMode::ThreadSafe> LoaderContext = Context.ToSharedRef();
+	TFunction<bool(FglTFRuntimePointCloudLoadContext&, TArray64<FLidarPointCloudPoint>&)> LoaderFunction = Loader;
+
+	Async(EAsyncExecution::ThreadPool, [WeakThis, LoaderContext, LoaderFunction]()
+		{
+			TSharedRef<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe> Points = MakeShared<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe>();
+			bool bSuccess = LoaderFunction(*LoaderContext, *Points) && !LoaderContext->IsCanceled();
+
+			if (bSuccess && LoaderContext->Config.bSortPoints)
+			{
+				bSuccess = glTFRuntimePointCloud::SortPointsByMortonKey(*Points, *LoaderContext);
+			}
+
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, Points, bSuccess]()
+				{
+					if (!WeakThis.IsValid())
+					{
+						return;
+					}
+
+					if (!bSuccess)
+					{
+						WeakThis->Finish(nullptr);
+						return;
+					}
+
+					WeakThis->BuildOctree(Points);
+				});
+		});
+}
+
+void UglTFRuntimePointCloudAsyncAction::BuildOctree(TSharedRef<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe> Points)
+{
+	// the async octree builder never completes without points
+	if (Points->Num() == 0)
+	{
+		Finish(ULidarPointCloud::CreateFromData(*Points, false));
+		return;
+	}
+
+	TWeakObjectPtr<UglTFRuntimePointCloudAsyncAction> WeakThis = this;
+	TSharedRef<FglTFRuntimePointCloudLoadContext, ESPMode::ThreadSafe> LoaderContext = Context.ToSharedRef();
+	const double OctreeBuildStartTime = FPlatformTime::Seconds();
+
+	// the octree builder reads directly from Points, so the completion callback owns it until the end
+	FLidarPointCloudAsyncParameters AsyncParameters(true,
+		[LoaderContext](float Value)
+		{
+			LoaderContext->ReportProgress(EglTFRuntimePointCloudLoadPhase::OctreeBuild, static_cast<int64>(Value * 100), 100);
+		},
+		[WeakThis, Points, LoaderContext, OctreeBuildStartTime](bool bSuccess)
+		{
+			LoaderContext->Report.OctreeBuildTime += FPlatformTime::Seconds() - OctreeBuildStartTime;
+			LoaderContext->Report.PeakUsedPhysical = FMath::Max<int64>(LoaderContext->Report.PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, Points, LoaderContext, bSuccess]()
+				{
+					if (WeakThis.IsValid())
+					{
+						WeakThis->Finish(bSuccess && !LoaderContext->IsCanceled() ? WeakThis->PointCloud : nullptr);
+					}
+				});
+		});
+
+	PointCloud = ULidarPointCloud::CreateFromData(*Points, AsyncParameters);
+	if (!PointCloud)
+	{
+		Finish(nullptr);
+	}
+}
+
+void UglTFRuntimePointCloudAsyncAction::Stream()
+{
+	// the point cloud must be created in the game thread, the PointCloud property keeps it alive while streaming
+	PointCloud = NewObject<ULidarPointCloud>();
+
+	TWeakObjectPtr<UglTFRuntimePointCloudAsyncAction> WeakThis = this;
+	TSharedRef<FglTFRuntimePointCloudLoadContext, ESPMode::ThreadSafe> LoaderContext = Context.ToSharedRef();
+	TFunction<bool(FglTFRuntimePointCloudLoadContext&, ULidarPointCloud*)> StreamFunction = StreamLoader;
+	ULidarPointCloud* StreamPointCloud = PointCloud;
+
+	Async(EAsyncExecution::ThreadPool, [WeakThis, LoaderContext, StreamFunction, StreamPointCloud]()
+		{
+			const bool bSuccess = StreamFunction(*LoaderContext, StreamPointCloud) && !LoaderContext->IsCanceled();
+
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, bSuccess]()
+				{
+					if (!WeakThis.IsValid())
+					{
+						return;
+					}
+
+					if (!bSuccess)
+					{
+						WeakThis->Finish(nullptr);
+						return;
+					}
+
+					WeakThis->PointCloud->RefreshBounds();
+					WeakThis->PointCloud->RefreshRendering();
+					WeakThis->Finish(WeakThis->PointCloud);
+				});
+		});
+}
+
+void UglTFRuntimePointCloudAsyncAction::Progressive()
+{
+	if (PointCloudConfig.Decimation != EglTFRuntimePointCloudDecimation::None)
+	{
+		UE_LOG(LogGLTFRuntime, Warning, TEXT("Decimation is ignored by progressive loads"));
+	}
+
+	// the point cloud must be created in the game thread, the PointCloud property keeps it alive while loading
+	PointCloud = NewObject<ULidarPointCloud>();
+
+	TWeakObjectPtr<UglTFRuntimePointCloudAsyncAction> WeakThis = this;
+	TSharedRef<FglTFRuntimePointCloudLoadContext, ESPMode::ThreadSafe> LoaderContext = Context.ToSharedRef();
+	TFunction<bool(FglTFRuntimePointCloudLoadContext&, TArray64<FLidarPointCloudPoint>&)> LoaderFunction = Loader;
+	ULidarPointCloud* ProgressivePointCloud = PointCloud;
+	const int32 Stride = ProgressiveStride;
+
+	Async(EAsyncExecution::ThreadPool, [WeakThis, LoaderContext, LoaderFunction, ProgressivePointCloud, Stride]()
+		{
+			LoaderContext->Config.Decimation = EglTFRuntimePointCloudDecimation::Stride;
+			LoaderContext->Config.DecimationStride = Stride;
+
+			TSharedRef<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe> PreviewPoints = MakeShared<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe>();
+			const bool bSuccess = LoaderFunction(*LoaderContext, *PreviewPoints) && !LoaderContext->IsCanceled();
+
+			FBox3f Bounds(ForceInit);
+			if (bSuccess && PreviewPoints->Num() > 0)
+			{
+				GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(*LoaderContext, OctreeBuild);
+
+				for (const FLidarPointCloudPoint& Point : *PreviewPoints)
+				{
+					Bounds += Point.Location;
+				}
+				Bounds = Bounds.ExpandBy(Bounds.GetSize() * glTFRuntimePointCloud::ProgressiveBoundsMargin);
+
+				ProgressivePointCloud->Initialize(FBox(Bounds));
+				ProgressivePointCloud->InsertPoints(PreviewPoints->GetData(), PreviewPoints->Num(), ELidarPointCloudDuplicateHandling::Ignore, false, FVector::ZeroVector);
+			}
+
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, PreviewPoints, Bounds, bSuccess]()
+				{
+					if (!WeakThis.IsValid())
+					{
+						return;
+					}
+
+					if (!bSuccess)
+					{
+						WeakThis->Finish(nullptr);
+						return;
+					}
+
+					WeakThis->Refine(PreviewPoints, Bounds);
+				});
+		});
+}
+
+void UglTFRuntimePointCloudAsyncAction::Refine(TSharedRef<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe> PreviewPoints, const FBox3f& Bounds)
+{
+	PointCloud->RefreshBounds();
+	PointCloud->RefreshRendering();
+
+	Preview.Broadcast(PointCloud);
+	PreviewCallback.ExecuteIfBound(PointCloud);
+
+	TWeakObjectPtr<UglTFRuntimePointCloudAsyncAction> WeakThis = this;
+	TSharedRef<FglTFRuntimePointCloudLoadContext, ESPMode::ThreadSafe> LoaderContext = Context.ToSharedRef();
+	TFunction<bool(FglTFRuntimePointCloudLoadContext&, TArray64<FLidarPointCloudPoint>&)> LoaderFunction = Loader;
+
+	// the input is scanned again, but only the points skipped by the preview are decoded
+	Async(EAsyncExecution::ThreadPool, [WeakThis, LoaderContext, LoaderFunction, PreviewPoints, Bounds]()
+		{
+			LoaderContext->Config.Decimation = EglTFRuntimePointCloudDecimation::StrideRemainder;
+
+			// both of the passes count all of the input points
+			const int64 NumInputPoints = LoaderContext->Report.NumInputPoints;
+
+			TSharedRef<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe> Points = MakeShared<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe>();
+			bool bSuccess = LoaderFunction(*LoaderContext, *Points) && !LoaderContext->IsCanceled();
+
+			LoaderContext->Report.NumInputPoints = NumInputPoints;
+
+			// the preview is small enough to be inserted in input order
+			if (bSuccess && LoaderContext->Config.bSortPoints)
+			{
+				bSuccess = glTFRuntimePointCloud::SortPointsByMortonKey(*Points, *LoaderContext);
+			}
+
+			// a valid RebuildBounds means the remaining points do not fit in the preview octree
+			FBox3f RebuildBounds(ForceInit);
+			if (bSuccess)
+			{
+				FBox3f PointsBounds(ForceInit);
+				for (const FLidarPointCloudPoint& Point : *Points)
+				{
+					PointsBounds += Point.Location;
+				}
+
+				if (PointsBounds.IsValid && (!Bounds.IsValid || !Bounds.IsInsideOrOn(PointsBounds.Min) || !Bounds.IsInsideOrOn(PointsBounds.Max)))
+				{
+					RebuildBounds = Bounds + PointsBounds;
+				}
+			}
+
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, PreviewPoints, Points, RebuildBounds, bSuccess]()
+				{
+					if (!WeakThis.IsValid())
+					{
+						return;
+					}
+
+					if (!bSuccess)
+					{
+						WeakThis->Finish(nullptr);
+						return;
+					}
+
+					WeakThis->Merge(PreviewPoints, Points, RebuildBounds);
+				});
+		});
+}
+
+void UglTFRuntimePointCloudAsyncAction::Merge(TSharedRef<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe> PreviewPoints, TSharedRef<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe> Points, const FBox3f& RebuildBounds)
+{
+	// the preview disappears until its points are inserted again in the larger octree
+	const bool bRebuild = RebuildBounds.IsValid != 0;
+	if (bRebuild)
+	{
+		PointCloud->Initialize(FBox(RebuildBounds));
+	}
+
+	TWeakObjectPtr<UglTFRuntimePointCloudAsyncAction> WeakThis = this;
+	TSharedRef<FglTFRuntimePointCloudLoadContext, ESPMode::ThreadSafe> LoaderContext = Context.ToSharedRef();
+	ULidarPointCloud* ProgressivePointCloud = PointCloud;
+
+	Async(EAsyncExecution::ThreadPool, [WeakThis, LoaderContext, ProgressivePointCloud, PreviewPoints, Points, bRebuild]()
+		{
+			TArray<TSharedRef<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe>> Batches;
+			if (bRebuild)
+			{
+				Batches.Add(PreviewPoints);
+			}
+			Batches.Add(Points);
+
+			int64 NumPoints = 0;
+			for (const TSharedRef<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe>& Batch : Batches)
+			{
+				NumPoints += Batch->Num();
+			}
+
+			int64 NumInsertedPoints = 0;
+			for (const TSharedRef<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe>& Batch : Batches)
+			{
+				for (int64 FirstPoint = 0; FirstPoint < Batch->Num() && !LoaderContext->IsCanceled(); FirstPoint += glTFRuntimePointCloud::ProgressiveBatchSize)
+				{
+					const int64 NumBatchPoints = FMath::Min(glTFRuntimePointCloud::ProgressiveBatchSize, Batch->Num() - FirstPoint);
+					{
+						GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(*LoaderContext, OctreeBuild);
+						ProgressivePointCloud->InsertPoints(Batch->GetData() + FirstPoint, NumBatchPoints, ELidarPointCloudDuplicateHandling::Ignore, false, FVector::ZeroVector);
+					}
+
+					LoaderContext->ReportProgress(EglTFRuntimePointCloudLoadPhase::OctreeBuild, NumInsertedPoints += NumBatchPoints, NumPoints);
+
+					AsyncTask(ENamedThreads::GameThread, [WeakThis]()
+						{
+							if (WeakThis.IsValid() && WeakThis->PointCloud)
+							{
+								WeakThis->PointCloud->RefreshRendering();
+							}
+						});
+				}
+			}
+
+			const bool bSuccess = !LoaderContext->IsCanceled();
+
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, bSuccess]()
+				{
+					if (!WeakThis.IsValid())
+					{
+						return;
+					}
+
+					if (!bSuccess)
+					{
+						WeakThis->Finish(nullptr);
+						return;
+					}
+
+					WeakThis->PointCloud->RefreshBounds();
+					WeakThis->PointCloud->RefreshRendering();
+					WeakThis->Finish(WeakThis->PointCloud);
+				});
+		});
+}
+
+void UglTFRuntimePointCloudAsyncAction::NotifyProgress(const EglTFRuntimePointCloudLoadPhase Phase, const float Value)
+{
+	Progress.Broadcast(Phase, Value);
+	ProgressCallback.ExecuteIfBound(Phase, Value);
+}
+
+void UglTFRuntimePointCloudAsyncAction::Finish(ULidarPointCloud* LoadedPointCloud)
+{
+	if (Context)
+	{
+		NumRejectedPoints = Context->NumRejectedPoints;
+		LoadReport = Context->GetReport();
+		Origin = Context->Origin;
+		ViewPoint = Context->ViewPoint;
+		Context->LogReport();
+	}
+
+	if (LoadedPointCloud)
+	{
+		Completed.Broadcast(LoadedPointCloud);
+	}
+	else
+	{
+		Failed.Broadcast(nullptr);
+	}
+
+	AsyncCallback.ExecuteIfBound(LoadedPointCloud);
+
+	Context.Reset();
+	PointCloud = nullptr;
+	Loader = nullptr;
+	StreamLoader = nullptr;
+
+	if (IsRooted())
+	{
+		RemoveFromRoot();
+	}
+	SetReadyToDestroy();
+}
@@ -0,0 +1,218 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/ParallelFor.h"
+#include "glTFRuntimeParser.h"
+#include "glTFRuntimePointCloudColor.h"
+#include "glTFRuntimePointCloudLibrary.h"
+#include "glTFRuntimePointCloudMesh.h"
+#include "glTFRuntimePointCloudSynthetic.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+
+/*
+ * Synthetic inputs of every format with their ground truth, shared by the benchmark commandlet and the automation tests.
+ */
+namespace glTFRuntimePointCloud
+{
+	const TCHAR* const BenchmarkFormats[] = { TEXT("xyz"), TEXT("xyz_file"), TEXT("pcd_ascii"), TEXT("pcd_binary"), TEXT("pcd_binary_compressed"), TEXT("gltf") };
+
+	/* Streaming loader budget of the xyz_file format */
+	constexpr int64 BenchmarkMemoryBudget = 256 * 1024 * 1024;
+
+	/* Generated input of a format and the points its loader must produce */
+	struct FBenchmarkInput
+	{
+		TArray64<uint8> Blob;
+		TSharedPtr<FglTFRuntimeParser> Parser;
+		TArray64<FLidarPointCloudPoint> Expected;
+		FString Filename;
+		/* the sRGB conversion of the glTF colors can be one step off the reference */
+		int32 ColorTolerance = 0;
+	};
+
+	/* "1000", "1K" or "100M" */
+	inline int64 ParseBenchmarkSize(FString Size)
+	{
+		Size.TrimStartAndEndInline();
+		int64 Multiplier = 1;
+		if (Size.EndsWith(TEXT("K")))
+		{
+			Multiplier = 1000;
+		}
+		else if (Size.EndsWith(TEXT("M")))
+		{
+			Multiplier = 1000 * 1000;
+		}
+
+		if (Multiplier > 1)
+		{
+			Size.LeftChopInline(1);
+		}
+
+		return FCString::Atoi64(*Size) * Multiplier;
+	}
+
+	inline TSharedPtr<FglTFRuntimeParser> CreateBenchmarkParser(const TArray64<uint8>& Blob, const bool bAsBlob)
+	{
+		FglTFRuntimeConfig LoaderConfig;
+		LoaderConfig.bAsBlob = bAsBlob;
+		return FglTFRuntimeParser::FromData(Blob.GetData(), Blob.Num(), LoaderConfig);
+	}
+
+	inline bool CreateBenchmarkInput(const FString& Format, const TArray64<FLidarPointCloudPoint>& Points, FBenchmarkInput& Input)
+	{
+		if (Format == TEXT("xyz") || Format == TEXT("xyz_file"))
+		{
+			WriteSyntheticXYZ(Points, Input.Blob);
+
+			// the alpha column is not written
+			Input.Expected = Points;
+			for (FLidarPointCloudPoint& Point : Input.Expected)
+			{
+				Point.Color.A = 0xFF;
+			}
+
+			if (Format == TEXT("xyz_file"))
+			{
+				Input.Filename = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("glTFRuntimePointCloud"), TEXT("Benchmark.xyz"));
+				const bool bSaved = FFileHelper::SaveArrayToFile(Input.Blob, *Input.Filename);
+				Input.Blob.Empty();
+				return bSaved;
+			}
+		}
+		else if (Format == TEXT("pcd_ascii"))
+		{
+			WriteSyntheticPCDASCII(Points, Input.Blob);
+			Input.Expected = Points;
+		}
+		else if (Format == TEXT("pcd_binary") || Format == TEXT("pcd_binary_compressed"))
+		{
+			if (!UglTFRuntimePointCloudLibrary::WritePointsToPCD(Points, Format == TEXT("pcd_binary_compressed"), Input.Blob))
+			{
+				return false;
+			}
+			Input.Expected = Points;
+		}
+		else if (Format == TEXT("gltf"))
+		{
+			if (!WriteSyntheticGLB(Points, Input.Blob))
+			{
+				return false;
+			}
+
+			Input.Parser = CreateBenchmarkParser(Input.Blob, false);
+			if (!Input.Parser)
+			{
+				return false;
+			}
+
+			// the ground truth goes through the same scene basis of the loader
+			FPointBasis Basis;
+			Basis.Init(*Input.Parser);
+
+			Input.Expected.SetNumUninitialized(Points.Num());
+			ParallelFor(static_cast<int32>((Points.Num() + SyntheticPointsPerBlock - 1) / SyntheticPointsPerBlock), [&](const int32 BlockIndex)
+				{
+					const int64 FirstPoint = BlockIndex * SyntheticPointsPerBlock;
+					const int64 LastPoint = FMath::Min(FirstPoint + SyntheticPointsPerBlock, Points.Num());
+					for (int64 PointIndex = FirstPoint; PointIndex < LastPoint; PointIndex++)
+					{
+						const FLidarPointCloudPoint& Point = Points[PointIndex];
+						const float Location[3] = { Point.Location.X, Point.Location.Y, Point.Location.Z };
+
+						FLidarPointCloudPoint ExpectedPoint;
+						ExpectedPoint.Location = Basis.TransformPosition(Location);
+						ExpectedPoint.Color = LinearToSRGBColor(Point.Color.R * (1.0f / 255.0f), Point.Color.G * (1.0f / 255.0f), Point.Color.B * (1.0f / 255.0f), Point.Color.A * (1.0f / 255.0f));
+						Input.Expected[PointIndex] = ExpectedPoint;
+					}
+				});
+
+			Input.ColorTolerance = 1;
+			return true;
+		}
+		else
+		{
+			return false;
+		}
+
+		Input.Parser = CreateBenchmarkParser(Input.Blob, true);
+		return Input.Parser.IsValid();
+	}
+
+	/* Runs the loader of the format: streamed points go straight to an octree, only their number is returned in NumStreamedPoints */
+	inline bool LoadBenchmarkPoints(const FString& Format, const FBenchmarkInput& Input, FglTFRuntimePointCloudLoadContext& Context, TArray64<FLidarPointCloudPoint>& Points, int64& NumStreamedPoints)
+	{
+		const FglTFRuntimeASCIIPointCloudConfig ASCIIPointCloudConfig;
+
+		if (!Input.Filename.IsEmpty())
+		{
+			ULidarPointCloud* PointCloud = NewObject<ULidarPointCloud>();
+			if (!UglTFRuntimePointCloudLibrary::StreamPointsFromXYZFile(Input.Filename, BenchmarkMemoryBudget, ASCIIPointCloudConfig, PointCloud, Context))
+			{
+				return false;
+			}
+			PointCloud->RefreshBounds();
+			NumStreamedPoints = PointCloud->GetNumPoints();
+			return true;
+		}
+
+		if (Format == TEXT("xyz"))
+		{
+			return UglTFRuntimePointCloudLibrary::LoadPointsFromXYZ(Input.Parser.ToSharedRef(), nullptr, nullptr, ASCIIPointCloudConfig, Points, Context);
+		}
+
+		if (Format == TEXT("gltf"))
+		{
+			return UglTFRuntimePointCloudLibrary::LoadPointsFromMeshes(Input.Parser.ToSharedRef(), { 0 }, Points, Context);
+		}
+
+		FTransform ViewPoint;
+		return UglTFRuntimePointCloudLibrary::LoadPointsFromPCD(Input.Parser.ToSharedRef(), ViewPoint, Points, Context);
+	}
+
+	/* Number of points not matching the ground truth (in order), the first mismatches are logged */
+	inline int64 CountMismatches(const TArray64<FLidarPointCloudPoint>& Points, const FBenchmarkInput& Input)
+	{
+		if (Points.Num() != Input.Expected.Num())
+		{
+			UE_LOG(LogGLTFRuntime, Error, TEXT("Loaded %lld points, expected %lld"), Points.Num(), Input.Expected.Num());
+			return FMath::Abs(Points.Num() - Input.Expected.Num());
+		}
+
+		std::atomic<int64> NumMismatches = 0;
+
+		ParallelFor(static_cast<int32>((Points.Num() + SyntheticPointsPerBlock - 1) / SyntheticPointsPerBlock), [&](const int32 BlockIndex)
+			{
+				const int64 FirstPoint = BlockIndex * SyntheticPointsPerBlock;
+				const int64 LastPoint = FMath::Min(FirstPoint + SyntheticPointsPerBlock, Points.Num());
+				for (int64 PointIndex = FirstPoint; PointIndex < LastPoint; PointIndex++)
+				{
+					const FLidarPointCloudPoint& Point = Points[PointIndex];
+					const FLidarPointCloudPoint& ExpectedPoint = Input.Expected[PointIndex];
+
+					const float Tolerance = 1e-5f * FMath::Max(1.0f, ExpectedPoint.Location.GetAbsMax());
+					const bool bLocationMatches = Point.Location.Equals(ExpectedPoint.Location, Tolerance);
+					const bool bColorMatches =
+						FMath::Abs(Point.Color.R - ExpectedPoint.Color.R) <= Input.ColorTolerance &&
+						FMath::Abs(Point.Color.G - ExpectedPoint.Color.G) <= Input.ColorTolerance &&
+						FMath::Abs(Point.Color.B - ExpectedPoint.Color.B) <= Input.ColorTolerance &&
+						FMath::Abs(Point.Color.A - ExpectedPoint.Color.A) <= Input.ColorTolerance;
+
+					if (!bLocationMatches || !bColorMatches)
+					{
+						if (++NumMismatches <= 8)
+						{
+							UE_LOG(LogGLTFRuntime, Error, TEXT("Point %lld is %s %s, expected %s %s"), PointIndex,
+								*Point.Location.ToString(), *Point.Color.ToString(), *ExpectedPoint.Location.ToString(), *ExpectedPoint.Color.ToString());
+						}
+					}
+				}
+			});
+
+		return NumMismatches;
+	}
+}
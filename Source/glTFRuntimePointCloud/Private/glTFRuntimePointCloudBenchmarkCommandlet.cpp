@@ -0,0 +1,207 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#include "glTFRuntimePointCloudBenchmarkCommandlet.h"
+#include "Dom/JsonObject.h"
+#include "glTFRuntimePointCloudBenchmark.h"
+#include "glTFRuntimePointCloudSort.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace glTFRuntimePointCloud
+{
+	namespace
+	{
+		TSharedRef<FJsonObject> BenchmarkReportToJson(const FglTFRuntimePointCloudLoadReport& Report)
+		{
+			TSharedRef<FJsonObject> JsonPhases = MakeShared<FJsonObject>();
+
+			auto AddPhase = [&](const TCHAR* Name, const double Time)
+				{
+					TSharedRef<FJsonObject> JsonPhase = MakeShared<FJsonObject>();
+					JsonPhase->SetNumberField(TEXT("time"), Time);
+					JsonPhase->SetNumberField(TEXT("points_per_second"), Time > 0 ? Report.NumInputPoints / Time : 0);
+					JsonPhases->SetObjectField(Name, JsonPhase);
+				};
+
+			AddPhase(TEXT("line_scan"), Report.LineScanTime);
+			AddPhase(TEXT("parse"), Report.ParseTime);
+			AddPhase(TEXT("decompress"), Report.DecompressTime);
+			AddPhase(TEXT("filter"), Report.FilterTime);
+			AddPhase(TEXT("sort"), Report.SortTime);
+			AddPhase(TEXT("octree_build"), Report.OctreeBuildTime);
+			AddPhase(TEXT("total"), Report.TotalTime);
+
+			TSharedRef<FJsonObject> JsonReport = MakeShared<FJsonObject>();
+			JsonReport->SetObjectField(TEXT("phases"), JsonPhases);
+			JsonReport->SetNumberField(TEXT("input_points"), Report.NumInputPoints);
+			JsonReport->SetNumberField(TEXT("accepted_points"), Report.NumAcceptedPoints);
+			JsonReport->SetNumberField(TEXT("rejected_points"), Report.NumRejectedPoints);
+			JsonReport->SetNumberField(TEXT("bytes_allocated"), Report.BytesAllocated);
+			JsonReport->SetNumberField(TEXT("peak_used_physical"), Report.PeakUsedPhysical);
+			return JsonReport;
+		}
+	}
+}
+
+UglTFRuntimePointCloudBenchmarkCommandlet::UglTFRuntimePointCloudBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Benchmarks and verifies the point cloud loaders on synthetic data");
+	HelpUsage = TEXT("-run=glTFRuntimePointCloudBenchmark [-Sizes=1K,1M] [-Formats=xyz,xyz_file,pcd_ascii,pcd_binary,pcd_binary_compressed,gltf] [-Seed=1] [-Iterations=1] [-NoOctree] [-Sort] [-Output=Report.json]");
+}
+
+int32 UglTFRuntimePointCloudBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString SizesParam = TEXT("1K,100K,1M");
+	FParse::Value(*Params, TEXT("Sizes="), SizesParam, false);
+
+	FString FormatsParam;
+	if (!FParse::Value(*Params, TEXT("Formats="), FormatsParam, false))
+	{
+		for (const TCHAR* Format : glTFRuntimePointCloud::BenchmarkFormats)
+		{
+			if (!FormatsParam.IsEmpty())
+			{
+				FormatsParam += TEXT(",");
+			}
+			FormatsParam += Format;
+		}
+	}
+
+	uint64 Seed = 1;
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+
+	int32 Iterations = 1;
+	FParse::Value(*Params, TEXT("Iterations="), Iterations);
+
+	FString OutputFilename;
+	FParse::Value(*Params, TEXT("Output="), OutputFilename);
+
+	const bool bBuildOctree = !FParse::Param(*Params, TEXT("NoOctree"));
+	const bool bSortPoints = FParse::Param(*Params, TEXT("Sort"));
+
+	TArray<FString> Sizes;
+	SizesParam.ParseIntoArray(Sizes, TEXT(","));
+	TArray<FString> Formats;
+	FormatsParam.ParseIntoArray(Formats, TEXT(","));
+
+	FglTFRuntimePointCloudConfig PointCloudConfig;
+	PointCloudConfig.bSortPoints = bSortPoints;
+
+	TArray<TSharedPtr<FJsonValue>> JsonResults;
+	bool bAllVerified = true;
+
+	for (const FString& Size : Sizes)
+	{
+		const int64 NumPoints = glTFRuntimePointCloud::ParseBenchmarkSize(Size);
+		if (NumPoints <= 0)
+		{
+			UE_LOG(LogGLTFRuntime, Error, TEXT("Invalid benchmark size %s"), *Size);
+			return 1;
+		}
+
+		TArray64<FLidarPointCloudPoint> Points;
+		glTFRuntimePointCloud::GenerateSyntheticPoints(Seed, NumPoints, Points);
+
+		for (const FString& Format : Formats)
+		{
+			glTFRuntimePointCloud::FBenchmarkInput Input;
+			if (!glTFRuntimePointCloud::CreateBenchmarkInput(Format, Points, Input))
+			{
+				UE_LOG(LogGLTFRuntime, Error, TEXT("Unable to generate %lld points of format %s"), NumPoints, *Format);
+				return 1;
+			}
+
+			const int64 InputSize = Input.Filename.IsEmpty() ? Input.Blob.Num() : IFileManager::Get().FileSize(*Input.Filename);
+
+			// the points are sorted by the octree build, the (stable) sort of the ground truth gives the same order
+			if (bSortPoints && bBuildOctree && Input.Filename.IsEmpty())
+			{
+				FglTFRuntimePointCloudLoadContext SortContext(PointCloudConfig);
+				glTFRuntimePointCloud::SortPointsByMortonKey(Input.Expected, SortContext);
+			}
+
+			for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+			{
+				FglTFRuntimePointCloudLoadContext Context(PointCloudConfig);
+				TArray64<FLidarPointCloudPoint> LoadedPoints;
+				int64 NumStreamedPoints = 0;
+				int64 NumMismatches = 0;
+
+				const bool bLoaded = glTFRuntimePointCloud::LoadBenchmarkPoints(Format, Input, Context, LoadedPoints, NumStreamedPoints);
+
+				// streamed points go straight to the octree, only their number can be checked
+				if (bLoaded && !Input.Filename.IsEmpty())
+				{
+					NumMismatches = FMath::Abs(NumStreamedPoints - Input.Expected.Num());
+				}
+				else if (bLoaded && bBuildOctree)
+				{
+					UglTFRuntimePointCloudLibrary::CreatePointCloud(LoadedPoints, Context);
+				}
+
+				// the report is taken before the (untimed) verification
+				const FglTFRuntimePointCloudLoadReport Report = Context.GetReport();
+
+				if (bLoaded && Input.Filename.IsEmpty())
+				{
+					NumMismatches = glTFRuntimePointCloud::CountMismatches(LoadedPoints, Input);
+				}
+
+				const bool bVerified = bLoaded && NumMismatches == 0;
+				bAllVerified &= bVerified;
+
+				TSharedRef<FJsonObject> JsonResult = glTFRuntimePointCloud::BenchmarkReportToJson(Report);
+				JsonResult->SetStringField(TEXT("format"), Format);
+				JsonResult->SetNumberField(TEXT("points"), NumPoints);
+				JsonResult->SetNumberField(TEXT("iteration"), Iteration);
+				JsonResult->SetNumberField(TEXT("input_bytes"), InputSize);
+				JsonResult->SetBoolField(TEXT("loaded"), bLoaded);
+				JsonResult->SetBoolField(TEXT("verified"), bVerified);
+				JsonResult->SetNumberField(TEXT("mismatches"), NumMismatches);
+				JsonResult->SetNumberField(TEXT("points_per_second"), Report.TotalTime > 0 ? NumPoints / Report.TotalTime : 0);
+				JsonResult->SetNumberField(TEXT("process_peak_used_physical"), FPlatformMemory::GetStats().PeakUsedPhysical);
+				JsonResults.Add(MakeShared<FJsonValueObject>(JsonResult));
+
+				UE_LOG(LogGLTFRuntime, Display, TEXT("%s %lld points (iteration %d): %s, %f seconds, %f points/s"), *Format, NumPoints, Iteration,
+					bVerified ? TEXT("verified") : TEXT("FAILED"), Report.TotalTime, Report.TotalTime > 0 ? NumPoints / Report.TotalTime : 0);
+
+				LoadedPoints.Empty();
+				CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+			}
+
+			if (!Input.Filename.IsEmpty())
+			{
+				IFileManager::Get().Delete(*Input.Filename);
+			}
+		}
+	}
+
+	TSharedRef<FJsonObject> JsonRoot = MakeShared<FJsonObject>();
+	JsonRoot->SetNumberField(TEXT("seed"), static_cast<double>(Seed));
+	JsonRoot->SetBoolField(TEXT("octree"), bBuildOctree);
+	JsonRoot->SetBoolField(TEXT("sort"), bSortPoints);
+	JsonRoot->SetNumberField(TEXT("threads"), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+	JsonRoot->SetArrayField(TEXT("results"), JsonResults);
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> JsonWriter = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(JsonRoot, JsonWriter);
+
+	if (OutputFilename.IsEmpty())
+	{
+		UE_LOG(LogGLTFRuntime, Display, TEXT("%s"), *Json);
+	}
+	else if (!FFileHelper::SaveStringToFile(Json, *OutputFilename))
+	{
+		UE_LOG(LogGLTFRuntime, Error, TEXT("Unable to write benchmark report to %s"), *OutputFilename);
+		return 1;
+	}
+
+	return bAllVerified ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#include "glTFRuntimePointCloudCache.h"
+#include "Async/MappedFileHandle.h"
+#include "glTFRuntimeParser.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Hash/xxhash.h"
+
+namespace glTFRuntimePointCloud
+{
+	namespace
+	{
+		bool IsValidCacheHeader(const FPointCacheHeader& Header, const uint64 Key, const int64 FileSize)
+		{
+			if (Header.Magic != FPointCacheHeader::CacheMagic || Header.Version != FPointCacheHeader::CacheVersion || Header.Key != Key)
+			{
+				return false;
+			}
+
+			// the point layout depends on the engine version
+			if (Header.PointSize != sizeof(FLidarPointCloudPoint) || Header.DataOffset < sizeof(FPointCacheHeader))
+			{
+				return false;
+			}
+
+			if (Header.NumberOfPoints < 0 || Header.NumberOfPoints > (FileSize - Header.DataOffset) / static_cast<int64>(sizeof(FLidarPointCloudPoint)))
+			{
+				return false;
+			}
+
+			return FileSize >= Header.DataOffset + Header.NumberOfPoints * static_cast<int64>(sizeof(FLidarPointCloudPoint));
+		}
+
+		void GetCacheViewPoint(const FPointCacheHeader& Header, FTransform& ViewPoint)
+		{
+			ViewPoint = FTransform::Identity;
+			ViewPoint.SetLocation(FVector(Header.ViewPointLocation[0], Header.ViewPointLocation[1], Header.ViewPointLocation[2]));
+			ViewPoint.SetRotation(FQuat(Header.ViewPointRotation[0], Header.ViewPointRotation[1], Header.ViewPointRotation[2], Header.ViewPointRotation[3]));
+		}
+	}
+
+	uint64 FPointCache::ComputeKey(const TArray64<uint8>& Blob, const TCHAR* Tag, TArrayView<const int32> Configuration)
+	{
+		const uint32 Version = FPointCacheHeader::CacheVersion;
+
+		FXxHash64Builder Builder;
+		Builder.Update(&Version, sizeof(uint32));
+		Builder.Update(Tag, FCString::Strlen(Tag) * sizeof(TCHAR));
+		Builder.Update(Configuration.GetData(), Configuration.Num() * sizeof(int32));
+		Builder.Update(Blob.GetData(), Blob.Num());
+		return Builder.Finalize().Hash;
+	}
+
+	bool FPointCache::Load(const FString& Filename, const uint64 Key, TArray64<FLidarPointCloudPoint>& Points, FTransform& ViewPoint)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		if (!PlatformFile.FileExists(*Filename))
+		{
+			return false;
+		}
+
+		TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*Filename));
+		if (MappedFile)
+		{
+			const int64 FileSize = MappedFile->GetFileSize();
+			if (FileSize < static_cast<int64>(sizeof(FPointCacheHeader)))
+			{
+				return false;
+			}
+
+			TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile->MapRegion(0, FileSize));
+			if (!MappedRegion)
+			{
+				return false;
+			}
+
+			FPointCacheHeader Header;
+			FMemory::Memcpy(&Header, MappedRegion->GetMappedPtr(), sizeof(FPointCacheHeader));
+			if (!IsValidCacheHeader(Header, Key, FileSize))
+			{
+				return false;
+			}
+
+			Points.SetNumUninitialized(Header.NumberOfPoints);
+			FMemory::Memcpy(Points.GetData(), MappedRegion->GetMappedPtr() + Header.DataOffset, Header.NumberOfPoints * sizeof(FLidarPointCloudPoint));
+			GetCacheViewPoint(Header, ViewPoint);
+			return true;
+		}
+
+		// platforms without memory mapping support
+		TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+		if (!Reader)
+		{
+			return false;
+		}
+
+		FPointCacheHeader Header;
+		if (Reader->TotalSize() < static_cast<int64>(sizeof(FPointCacheHeader)))
+		{
+			return false;
+		}
+
+		Reader->Serialize(&Header, sizeof(FPointCacheHeader));
+		if (!IsValidCacheHeader(Header, Key, Reader->TotalSize()))
+		{
+			return false;
+		}
+
+		Points.SetNumUninitialized(Header.NumberOfPoints);
+		Reader->Seek(Header.DataOffset);
+		Reader->Serialize(Points.GetData(), Header.NumberOfPoints * sizeof(FLidarPointCloudPoint));
+		if (Reader->IsError())
+		{
+			Points.Empty();
+			return false;
+		}
+
+		GetCacheViewPoint(Header, ViewPoint);
+		return true;
+	}
+
+	bool FPointCache::Save(const FString& Filename, const uint64 Key, const TArray64<FLidarPointCloudPoint>& Points, const FTransform& ViewPoint)
+	{
+		FPointCacheHeader Header;
+		Header.Key = Key;
+		Header.DataOffset = Align(sizeof(FPointCacheHeader), 16);
+		Header.NumberOfPoints = Points.Num();
+
+		const FVector Location = ViewPoint.GetLocation();
+		const FQuat Rotation = ViewPoint.GetRotation();
+		Header.ViewPointLocation[0] = Location.X;
+		Header.ViewPointLocation[1] = Location.Y;
+		Header.ViewPointLocation[2] = Location.Z;
+		Header.ViewPointRotation[0] = Rotation.X;
+		Header.ViewPointRotation[1] = Rotation.Y;
+		Header.ViewPointRotation[2] = Rotation.Z;
+		Header.ViewPointRotation[3] = Rotation.W;
+
+		// write to a temporary file first, so a partially written cache is never picked up
+		const FString TempFilename = Filename + TEXT(".tmp");
+		{
+			TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*TempFilename));
+			if (!Writer)
+			{
+				UE_LOG(LogGLTFRuntime, Error, TEXT("Unable to open point cloud cache file %s for writing"), *TempFilename);
+				return false;
+			}
+
+			uint8 Padding[16] = {};
+			Writer->Serialize(&Header, sizeof(FPointCacheHeader));
+			Writer->Serialize(Padding, Header.DataOffset - sizeof(FPointCacheHeader));
+			Writer->Serialize(const_cast<FLidarPointCloudPoint*>(Points.GetData()), Points.Num() * sizeof(FLidarPointCloudPoint));
+
+			if (!Writer->Close())
+			{
+				UE_LOG(LogGLTFRuntime, Error, TEXT("Unable to write point cloud cache file %s"), *TempFilename);
+				IFileManager::Get().Delete(*TempFilename);
+				return false;
+			}
+		}
+
+		return IFileManager::Get().Move(*Filename, *TempFilename, true);
+	}
+}
@@ -0,0 +1,39 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LidarPointCloudShared.h"
+
+namespace glTFRuntimePointCloud
+{
+	/*
+	 * Cache file layout (native endianness):
+	 *
+	 * FPointCacheHeader
+	 * NumberOfPoints * FLidarPointCloudPoint (starting at FPointCacheHeader::DataOffset)
+	 */
+	struct FPointCacheHeader
+	{
+		static constexpr uint32 CacheMagic = 0x43505447; // 'GTPC'
+		static constexpr uint32 CacheVersion = 1;
+
+		uint32 Magic = CacheMagic;
+		uint32 Version = CacheVersion;
+		uint64 Key = 0;
+		uint32 PointSize = sizeof(FLidarPointCloudPoint);
+		uint32 DataOffset = 0;
+		int64 NumberOfPoints = 0;
+		double ViewPointLocation[3] = {};
+		double ViewPointRotation[4] = { 0, 0, 0, 1 };
+	};
+
+	struct FPointCache
+	{
+		/* Combine the source blob hash with a loader specific tag and configuration values */
+		static uint64 ComputeKey(const TArray64<uint8>& Blob, const TCHAR* Tag, TArrayView<const int32> Configuration);
+
+		static bool Load(const FString& Filename, const uint64 Key, TArray64<FLidarPointCloudPoint>& Points, FTransform& ViewPoint);
+		static bool Save(const FString& Filename, const uint64 Key, const TArray64<FLidarPointCloudPoint>& Points, const FTransform& ViewPoint);
+	};
+}
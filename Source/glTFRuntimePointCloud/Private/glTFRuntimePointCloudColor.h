@@ -0,0 +1,131 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <emmintrin.h>
+#endif
+
+namespace glTFRuntimePointCloud
+{
+	/* Reference conversion (same curve and quantization of FLinearColor::ToFColor(true)), used only to build the tables */
+	inline uint8 LinearToSRGBReference(float Value)
+	{
+		Value = FMath::Clamp(Value, 0.0f, 1.0f);
+		Value = Value <= 0.0031308f ? Value * 12.92f : FMath::Pow(Value, 1.0f / 2.4f) * 1.055f - 0.055f;
+		return static_cast<uint8>(FMath::Clamp(FMath::FloorToInt(Value * 255.999f), 0, 255));
+	}
+
+	/*
+	 * Linear to sRGB lookup: a 16 bit table gives a result at most one step off,
+	 * the per step thresholds fix it so the output always matches the reference.
+	 */
+	struct FSRGBTable
+	{
+		static constexpr int32 TableBits = 16;
+		static constexpr int32 TableMax = (1 << TableBits) - 1;
+
+		uint8 Table[TableMax + 1];
+		float Thresholds[257];
+
+		FSRGBTable()
+		{
+			for (int32 Index = 0; Index <= TableMax; Index++)
+			{
+				Table[Index] = LinearToSRGBReference(static_cast<float>(Index) / TableMax);
+			}
+
+			// smallest value in [0, 1] mapped to each step (searched over the float bits, ordered for positive values)
+			Thresholds[0] = 0;
+			for (int32 Step = 1; Step < 256; Step++)
+			{
+				uint32 Low = 0;
+				uint32 High = 0x3F800000; // 1.0f
+				while (Low < High)
+				{
+					const uint32 Middle = Low + (High - Low) / 2;
+					if (LinearToSRGBReference(BitsToFloat(Middle)) >= Step)
+					{
+						High = Middle;
+					}
+					else
+					{
+						Low = Middle + 1;
+					}
+				}
+				Thresholds[Step] = BitsToFloat(Low);
+			}
+			Thresholds[256] = MAX_flt;
+		}
+
+		static float BitsToFloat(const uint32 Bits)
+		{
+			float Value;
+			FMemory::Memcpy(&Value, &Bits, sizeof(float));
+			return Value;
+		}
+
+		FORCEINLINE uint8 Convert(float Value) const
+		{
+			// NaN goes to 0
+			Value = Value > 0 ? (Value < 1 ? Value : 1) : 0;
+			int32 Step = Table[static_cast<int32>(Value * TableMax)];
+			if (Value < Thresholds[Step])
+			{
+				Step--;
+			}
+			else if (Value >= Thresholds[Step + 1])
+			{
+				Step++;
+			}
+			return static_cast<uint8>(Step);
+		}
+
+		static const FSRGBTable& Get()
+		{
+			static const FSRGBTable SRGBTable;
+			return SRGBTable;
+		}
+	};
+
+	/* Replacement for FLinearColor(R, G, B, A).ToFColor(true) (alpha stays linear) */
+	FORCEINLINE FColor LinearToSRGBColor(const float R, const float G, const float B, const float A)
+	{
+		const FSRGBTable& SRGBTable = FSRGBTable::Get();
+		return FColor(SRGBTable.Convert(R), SRGBTable.Convert(G), SRGBTable.Convert(B), static_cast<uint8>(FMath::FloorToInt(FMath::Clamp(A, 0.0f, 1.0f) * 255.999f)));
+	}
+
+	FORCEINLINE FColor LinearToSRGBColor(const FVector4& Color)
+	{
+		return LinearToSRGBColor(static_cast<float>(Color.X), static_cast<float>(Color.Y), static_cast<float>(Color.Z), static_cast<float>(Color.W));
+	}
+
+	/* Scales, truncates and clamps a single channel to a byte (NaN goes to 0) */
+	FORCEINLINE uint8 QuantizeColorChannel(const float Value, const float Scale)
+	{
+		const float Scaled = Value * Scale;
+		return static_cast<uint8>(Scaled > 0 ? (Scaled < 255 ? Scaled : 255) : 0);
+	}
+
+	/* Scales, truncates and clamps four channels (R, G, B, A) to bytes at once */
+	FORCEINLINE FColor QuantizeColor(const float R, const float G, const float B, const float A, const float Scale)
+	{
+#if PLATFORM_CPU_X86_FAMILY
+		__m128 Values = _mm_mul_ps(_mm_setr_ps(B, G, R, A), _mm_set1_ps(Scale));
+		// max first, so NaN goes to 0
+		Values = _mm_min_ps(_mm_max_ps(Values, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+		__m128i Integers = _mm_cvttps_epi32(Values);
+		Integers = _mm_packs_epi32(Integers, Integers);
+		Integers = _mm_packus_epi16(Integers, Integers);
+		FColor Color;
+		const uint32 Packed = static_cast<uint32>(_mm_cvtsi128_si32(Integers));
+		// FColor memory layout is B G R A
+		FMemory::Memcpy(&Color, &Packed, sizeof(uint32));
+		return Color;
+#else
+		return FColor(QuantizeColorChannel(R, Scale), QuantizeColorChannel(G, Scale), QuantizeColorChannel(B, Scale), QuantizeColorChannel(A, Scale));
+#endif
+	}
+}
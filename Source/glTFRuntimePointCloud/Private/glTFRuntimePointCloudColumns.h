@@ -0,0 +1,134 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "glTFRuntimePointCloudSink.h"
+
+namespace glTFRuntimePointCloud
+{
+	/*
+	 * Structure of arrays staging of a block of decoded points, shared by the binary loaders.
+	 * A loader fills every column with a tight per field loop (one type dispatch per block instead of one per point),
+	 * range filters then run as column passes and a single kernel builds the FLidarPointCloudPoint of the accepted points.
+	 * Only the points accepted by the decimation are staged, so rejected points are never decoded.
+	 */
+	class FPointColumns
+	{
+	public:
+		static constexpr int32 MaxPoints = 4096;
+
+		/* point indices relative to the loader source, the sink input index is FirstInputIndex + Index */
+		TArray<int64> Indices;
+		TArray<float> X;
+		TArray<float> Y;
+		TArray<float> Z;
+		TArray<FColor> Colors;
+		TArray<float> NX;
+		TArray<float> NY;
+		TArray<float> NZ;
+		/* sources of the range filters: Extras[RangeIndex * MaxPoints + PointIndex] */
+		TArray<double> Extras;
+		/* loader owned temporaries (e.g. linear float colors) */
+		TArray<float> Scratch;
+
+		int32 Num = 0;
+		int64 FirstInputIndex = 0;
+		bool bHasColors = false;
+		bool bHasNormals = false;
+
+		FPointColumns(const int32 InNumExtras, const int32 NumScratchColumns) : NumExtras(InNumExtras)
+		{
+			Indices.AddUninitialized(MaxPoints);
+			X.AddUninitialized(MaxPoints);
+			Y.AddUninitialized(MaxPoints);
+			Z.AddUninitialized(MaxPoints);
+			Colors.AddUninitialized(MaxPoints);
+			NX.AddUninitialized(MaxPoints);
+			NY.AddUninitialized(MaxPoints);
+			NZ.AddUninitialized(MaxPoints);
+			Extras.AddUninitialized(NumExtras * MaxPoints);
+			Scratch.AddUninitialized(NumScratchColumns * MaxPoints);
+			Mask.AddUninitialized(MaxPoints);
+		}
+
+		double* GetExtra(const int32 ExtraIndex)
+		{
+			return Extras.GetData() + ExtraIndex * MaxPoints;
+		}
+
+		float* GetScratch(const int32 ScratchIndex)
+		{
+			return Scratch.GetData() + ScratchIndex * MaxPoints;
+		}
+
+		/* Stages the indices of [FirstIndex, LastIndex) accepted by the writer (at most MaxPoints), returns the first index not staged */
+		int64 Gather(const FPointSink::FWriter& Writer, const int64 InFirstInputIndex, int64 FirstIndex, const int64 LastIndex)
+		{
+			FirstInputIndex = InFirstInputIndex;
+			Num = 0;
+			for (; FirstIndex < LastIndex && Num < MaxPoints; FirstIndex++)
+			{
+				if (Writer.Accepts(FirstInputIndex + FirstIndex))
+				{
+					Indices[Num++] = FirstIndex;
+				}
+			}
+			return FirstIndex;
+		}
+
+		/* Builds the staged points: straight into the output of a passthrough sink, through the range filters and the writer otherwise */
+		void Flush(FPointSink& Sink, FPointSink::FWriter& Writer)
+		{
+			if (Num == 0)
+			{
+				return;
+			}
+
+			if (Sink.IsPassthrough())
+			{
+				// every point is staged, indices are consecutive
+				FLidarPointCloudPoint* Output = Sink.GetOutput(FirstInputIndex + Indices[0]);
+				for (int32 PointIndex = 0; PointIndex < Num; PointIndex++)
+				{
+					Output[PointIndex] = MakePoint(PointIndex);
+				}
+				return;
+			}
+
+			const bool bHasRanges = Sink.HasRanges();
+			if (bHasRanges)
+			{
+				FMemory::Memset(Mask.GetData(), 1, Num);
+				Writer.MaskRanges(Extras.GetData(), MaxPoints, Num, Mask.GetData());
+			}
+
+			for (int32 PointIndex = 0; PointIndex < Num; PointIndex++)
+			{
+				if (!bHasRanges || Mask[PointIndex])
+				{
+					Writer.Add(FirstInputIndex + Indices[PointIndex], MakePoint(PointIndex));
+				}
+			}
+		}
+
+	private:
+		const int32 NumExtras;
+		TArray<uint8> Mask;
+
+		FORCEINLINE FLidarPointCloudPoint MakePoint(const int32 PointIndex) const
+		{
+			FLidarPointCloudPoint Point;
+			Point.Location = FVector3f(X[PointIndex], Y[PointIndex], Z[PointIndex]);
+			if (bHasColors)
+			{
+				Point.Color = Colors[PointIndex];
+			}
+			if (bHasNormals)
+			{
+				Point.Normal = FVector3f(NX[PointIndex], NY[PointIndex], NZ[PointIndex]);
+			}
+			return Point;
+		}
+	};
+}
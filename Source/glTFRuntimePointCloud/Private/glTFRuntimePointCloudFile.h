@@ -0,0 +1,80 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/MappedFileHandle.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/PlatformFileManager.h"
+
+namespace glTFRuntimePointCloud
+{
+	/*
+	 * Read-only view of a file, one window at a time.
+	 * Windows are mapped when the platform supports it, otherwise read in a buffer reused between windows.
+	 * Only the current window is resident, so memory is bounded by the largest requested window.
+	 */
+	class FFileWindow
+	{
+	public:
+		bool Open(const FString& Filename)
+		{
+			IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+			MappedFile.Reset(PlatformFile.OpenMapped(*Filename));
+			if (MappedFile)
+			{
+				FileSize = MappedFile->GetFileSize();
+				return true;
+			}
+
+			FileHandle.Reset(PlatformFile.OpenRead(*Filename));
+			if (!FileHandle)
+			{
+				return false;
+			}
+
+			FileSize = FileHandle->Size();
+			return FileSize >= 0;
+		}
+
+		int64 GetFileSize() const
+		{
+			return FileSize;
+		}
+
+		/* Returns the data of [Offset, Offset + Size) (clamped to the end of the file), valid until the next call */
+		const uint8* Map(const int64 Offset, int64& Size)
+		{
+			MappedRegion.Reset();
+
+			Size = FMath::Clamp<int64>(Size, 0, FileSize - Offset);
+			if (Offset < 0 || Size <= 0)
+			{
+				Size = 0;
+				return nullptr;
+			}
+
+			if (MappedFile)
+			{
+				MappedRegion.Reset(MappedFile->MapRegion(Offset, Size));
+				return MappedRegion ? MappedRegion->GetMappedPtr() : nullptr;
+			}
+
+			Buffer.SetNumUninitialized(Size);
+			if (!FileHandle->Seek(Offset) || !FileHandle->Read(Buffer.GetData(), Size))
+			{
+				return nullptr;
+			}
+
+			return Buffer.GetData();
+		}
+
+	private:
+		TUniquePtr<IMappedFileHandle> MappedFile;
+		TUniquePtr<IMappedFileRegion> MappedRegion;
+		TUniquePtr<IFileHandle> FileHandle;
+		TArray64<uint8> Buffer;
+		int64 FileSize = 0;
+	};
+}
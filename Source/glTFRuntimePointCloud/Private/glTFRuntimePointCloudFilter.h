@@ -0,0 +1,108 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "glTFRuntimePointCloudLibrary.h"
+#include "Math/VectorRegister.h"
+
+namespace glTFRuntimePointCloud
+{
+	/*
+	 * Crop box and range filters of a load configuration, evaluated by the loaders before a point reaches the output.
+	 * The crop box is tested on the decoded location, range values are resolved by each loader (column, field, property or attribute).
+	 */
+	class FPointFilter
+	{
+	public:
+		FPointFilter(const FglTFRuntimePointCloudConfig& Config)
+		{
+			bCropBox = Config.CropBox.IsValid != 0;
+			if (bCropBox)
+			{
+				// world to box space as 4 rows, a location is transformed with 3 multiply-adds
+				const FMatrix44f WorldToBox(Config.CropBoxTransform.ToInverseMatrixWithScale());
+				for (int32 Row = 0; Row < 4; Row++)
+				{
+					CropRows[Row] = VectorLoad(WorldToBox.M[Row]);
+				}
+
+				// the transformed W is always 1 (only the translation row has a W), the W bounds keep it away from the comparison edges
+				CropMin = MakeVectorRegisterFloat(static_cast<float>(Config.CropBox.Min.X), static_cast<float>(Config.CropBox.Min.Y), static_cast<float>(Config.CropBox.Min.Z), 0.0f);
+				CropMax = MakeVectorRegisterFloat(static_cast<float>(Config.CropBox.Max.X), static_cast<float>(Config.CropBox.Max.Y), static_cast<float>(Config.CropBox.Max.Z), 2.0f);
+			}
+
+			for (const FglTFRuntimePointCloudRangeFilter& RangeFilter : Config.RangeFilters)
+			{
+				Ranges.Add({ RangeFilter.Min, RangeFilter.Max });
+			}
+		}
+
+		bool IsEnabled() const
+		{
+			return bCropBox || Ranges.Num() > 0;
+		}
+
+		bool HasCropBox() const
+		{
+			return bCropBox;
+		}
+
+		bool HasRanges() const
+		{
+			return Ranges.Num() > 0;
+		}
+
+		FORCEINLINE bool AcceptsLocation(const FVector3f& Location) const
+		{
+			const VectorRegister4Float Position = VectorLoadFloat3_W0(&Location.X);
+			VectorRegister4Float Local = VectorMultiplyAdd(VectorReplicate(Position, 0), CropRows[0], CropRows[3]);
+			Local = VectorMultiplyAdd(VectorReplicate(Position, 1), CropRows[1], Local);
+			Local = VectorMultiplyAdd(VectorReplicate(Position, 2), CropRows[2], Local);
+			return !(VectorAnyGreaterThan(CropMin, Local) | VectorAnyGreaterThan(Local, CropMax));
+		}
+
+		/* GetValue(RangeIndex) returns the value of the source of the RangeIndex-th filter (NaN never passes) */
+		template<typename GetterType>
+		FORCEINLINE bool AcceptsRanges(GetterType GetValue) const
+		{
+			for (int32 RangeIndex = 0; RangeIndex < Ranges.Num(); RangeIndex++)
+			{
+				const double Value = GetValue(RangeIndex);
+				if (!(Value >= Ranges[RangeIndex].Min && Value <= Ranges[RangeIndex].Max))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/* Column version of AcceptsRanges: Values[RangeIndex * ColumnStride + PointIndex], Mask is cleared for the rejected points */
+		void MaskRanges(const double* Values, const int32 ColumnStride, const int32 NumPoints, uint8* Mask) const
+		{
+			for (int32 RangeIndex = 0; RangeIndex < Ranges.Num(); RangeIndex++)
+			{
+				const double* Column = Values + static_cast<int64>(RangeIndex) * ColumnStride;
+				const double Min = Ranges[RangeIndex].Min;
+				const double Max = Ranges[RangeIndex].Max;
+				for (int32 PointIndex = 0; PointIndex < NumPoints; PointIndex++)
+				{
+					Mask[PointIndex] &= static_cast<uint8>((Column[PointIndex] >= Min) & (Column[PointIndex] <= Max));
+				}
+			}
+		}
+
+	private:
+		struct FRange
+		{
+			double Min;
+			double Max;
+		};
+
+		bool bCropBox = false;
+		VectorRegister4Float CropRows[4];
+		VectorRegister4Float CropMin;
+		VectorRegister4Float CropMax;
+		TArray<FRange, TInlineAllocator<4>> Ranges;
+	};
+}
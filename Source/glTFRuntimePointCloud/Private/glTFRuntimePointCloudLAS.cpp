@@ -0,0 +1,353 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#include "glTFRuntimePointCloudLibrary.h"
+#include "Async/ParallelFor.h"
+#include "glTFRuntimePointCloudAsyncAction.h"
+#include "glTFRuntimePointCloudFile.h"
+#include "glTFRuntimePointCloudLAS.h"
+#include "glTFRuntimePointCloudSink.h"
+#include "glTFRuntimePointCloudStats.h"
+
+namespace glTFRuntimePointCloud
+{
+	namespace
+	{
+		constexpr int64 LASPointsPerBlock = 64 * 1024;
+
+		/* Validates the header against the available bytes and prepares the decoder, georeferenced coordinates are moved around Origin */
+		bool InitLASDecoder(const FLASHeader& Header, const int64 NumBytes, FVector& Origin, FLASDecoder& Decoder)
+		{
+			if (Header.bCompressed)
+			{
+				UE_LOG(LogGLTFRuntime, Error, TEXT("Compressed (LAZ) point data is not supported"));
+				return false;
+			}
+
+			if (!Decoder.Format.Init(Header.PointDataFormat))
+			{
+				UE_LOG(LogGLTFRuntime, Error, TEXT("Unsupported LAS point data record format: %u"), Header.PointDataFormat);
+				return false;
+			}
+
+			const int64 RecordLength = Header.PointDataRecordLength;
+			if (RecordLength < Decoder.Format.MinRecordLength)
+			{
+				UE_LOG(LogGLTFRuntime, Error, TEXT("Invalid LAS point data record length %lld for format %u"), RecordLength, Header.PointDataFormat);
+				return false;
+			}
+
+			if (Header.NumberOfPoints > static_cast<uint64>(NumBytes / RecordLength) || Header.PointDataOffset + static_cast<int64>(Header.NumberOfPoints) * RecordLength > NumBytes)
+			{
+				UE_LOG(LogGLTFRuntime, Error, TEXT("Truncated LAS point data"));
+				return false;
+			}
+
+			// georeferenced coordinates do not fit in floats, points are stored relative to the center of the bounds
+			Origin = Header.Max.X >= Header.Min.X && Header.Max.Y >= Header.Min.Y && Header.Max.Z >= Header.Min.Z ? (Header.Min + Header.Max) * 0.5 : Header.Offset;
+			Decoder.Scale = Header.Scale;
+			Decoder.Translation = Header.Offset - Origin;
+
+			return true;
+		}
+
+		/* Parallel reduction of the ranges of NumRecords records */
+		template<bool bWithBounds>
+		FLASScan ScanLASRecords(const FLASDecoder& Decoder, const uint8* Data, const int64 RecordLength, const int64 NumRecords, FglTFRuntimePointCloudLoadContext& Context)
+		{
+			GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, LineScan);
+
+			const int32 NumBlocks = static_cast<int32>((NumRecords + LASPointsPerBlock - 1) / LASPointsPerBlock);
+			TArray<FLASScan> BlockScans;
+			BlockScans.AddDefaulted(NumBlocks);
+
+			ParallelFor(NumBlocks, [&](const int32 BlockIndex)
+				{
+					if (Context.IsCanceled())
+					{
+						return;
+					}
+
+					const int64 FirstRecord = BlockIndex * LASPointsPerBlock;
+					const int64 NumBlockRecords = FMath::Min(LASPointsPerBlock, NumRecords - FirstRecord);
+					Decoder.Scan<bWithBounds>(Data + FirstRecord * RecordLength, RecordLength, NumBlockRecords, BlockScans[BlockIndex]);
+				});
+
+			FLASScan Scan;
+			for (const FLASScan& BlockScan : BlockScans)
+			{
+				Scan.Merge(BlockScan);
+			}
+			return Scan;
+		}
+
+		/* Decodes NumRecords records in parallel into the sink, Progress is advanced by the number of decoded records */
+		void DecodeLASRecords(const FLASDecoder& Decoder, const uint8* Data, const int64 RecordLength, const int64 NumRecords, FPointSink& Sink, const TArray<FLASPointFormat::EField>& RangeFields, std::atomic<int64>& Progress, const int64 TotalProgress, FglTFRuntimePointCloudLoadContext& Context)
+		{
+			GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, Parse);
+
+			const int32 NumBlocks = static_cast<int32>((NumRecords + LASPointsPerBlock - 1) / LASPointsPerBlock);
+
+			ParallelFor(NumBlocks, [&](const int32 BlockIndex)
+				{
+					if (Context.IsCanceled())
+					{
+						return;
+					}
+
+					const int64 FirstPoint = BlockIndex * LASPointsPerBlock;
+					const int64 LastPoint = FMath::Min(FirstPoint + LASPointsPerBlock, NumRecords);
+
+					FPointSink::FWriter Writer(Sink);
+
+					for (int64 PointIndex = FirstPoint; PointIndex < LastPoint; PointIndex++)
+					{
+						if (!Writer.Accepts(PointIndex))
+						{
+							continue;
+						}
+
+						const uint8* Record = Data + PointIndex * RecordLength;
+
+						if (Sink.HasRanges() && !Writer.AcceptsRanges([&](const int32 RangeIndex) { return Decoder.Format.GetField(Record, RangeFields[RangeIndex]); }))
+						{
+							continue;
+						}
+
+						Writer.Add(PointIndex, Decoder.Decode(Record));
+					}
+
+					Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, Progress += LastPoint - FirstPoint, TotalProgress);
+				});
+		}
+
+		TArray<FLASPointFormat::EField> GetLASRangeFields(const FglTFRuntimePointCloudConfig& Config)
+		{
+			TArray<FLASPointFormat::EField> RangeFields;
+			for (const FglTFRuntimePointCloudRangeFilter& RangeFilter : Config.RangeFilters)
+			{
+				RangeFields.Add(FLASPointFormat::FindField(RangeFilter.Field));
+			}
+			return RangeFields;
+		}
+	}
+}
+
+ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromLAS(UglTFRuntimeAsset* Asset, FVector& Origin, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	if (!Asset)
+	{
+		return nullptr;
+	}
+
+	FglTFRuntimePointCloudLoadContext Context(PointCloudConfig);
+	TArray64<FLidarPointCloudPoint> Points;
+	if (!LoadPointsFromLAS(Asset->GetParser().ToSharedRef(), Origin, Points, Context))
+	{
+		return nullptr;
+	}
+
+	return CreatePointCloud(Points, Context);
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudLibrary::LoadPointCloudFromLASAsync(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromLAS(Asset, PointCloudConfig);
+	Action->AsyncCallback = AsyncCallback;
+	Action->ProgressCallback = ProgressCallback;
+	Action->Activate();
+	return Action;
+}
+
+bool UglTFRuntimePointCloudLibrary::LoadPointsFromLAS(TSharedRef<FglTFRuntimeParser> Parser, FVector& Origin, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context)
+{
+	const TArray64<uint8>& Blob = Parser->GetBlob();
+
+	glTFRuntimePointCloud::FLASHeader Header;
+	if (!Header.Parse(Blob))
+	{
+		UE_LOG(LogGLTFRuntime, Error, TEXT("Invalid LAS header"));
+		return false;
+	}
+
+	glTFRuntimePointCloud::FLASDecoder Decoder;
+	if (!glTFRuntimePointCloud::InitLASDecoder(Header, Blob.Num(), Origin, Decoder))
+	{
+		return false;
+	}
+
+	const int64 NumberOfPoints = static_cast<int64>(Header.NumberOfPoints);
+	const int64 RecordLength = Header.PointDataRecordLength;
+	const uint8* Data = Blob.GetData() + Header.PointDataOffset;
+
+	// the color ranges are scanned before decoding so that skipped (decimated) records never need a second pass
+	Decoder.SetRanges(glTFRuntimePointCloud::ScanLASRecords<false>(Decoder, Data, RecordLength, NumberOfPoints, Context));
+
+	if (Context.IsCanceled())
+	{
+		return false;
+	}
+
+	glTFRuntimePointCloud::FPointSink Sink(Points, Context.Config);
+	if (!Sink.Begin(NumberOfPoints))
+	{
+		return false;
+	}
+
+	std::atomic<int64> DecodedPoints = 0;
+	glTFRuntimePointCloud::DecodeLASRecords(Decoder, Data, RecordLength, NumberOfPoints, Sink, glTFRuntimePointCloud::GetLASRangeFields(Context.Config), DecodedPoints, NumberOfPoints, Context);
+
+	if (!Sink.End(Context))
+	{
+		return false;
+	}
+
+	Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, 1, 1);
+
+	return true;
+}
+
+ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromLASFile(const FString& Filename, FVector& Origin, const int32 MemoryBudgetMB, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	FglTFRuntimePointCloudLoadContext Context(PointCloudConfig);
+	ULidarPointCloud* PointCloud = NewObject<ULidarPointCloud>();
+	if (!StreamPointsFromLASFile(Filename, static_cast<int64>(MemoryBudgetMB) * 1024 * 1024, Origin, PointCloud, Context))
+	{
+		return nullptr;
+	}
+
+	PointCloud->RefreshBounds();
+	PointCloud->RefreshRendering();
+	Context.LogReport();
+	return PointCloud;
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudLibrary::LoadPointCloudFromLASFileAsync(const FString& Filename, const int32 MemoryBudgetMB, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromLASFile(Filename, MemoryBudgetMB, PointCloudConfig);
+	Action->AsyncCallback = AsyncCallback;
+	Action->ProgressCallback = ProgressCallback;
+	Action->Activate();
+	return Action;
+}
+
+bool UglTFRuntimePointCloudLibrary::StreamPointsFromLASFile(const FString& Filename, const int64 MemoryBudget, FVector& Origin, ULidarPointCloud* PointCloud, FglTFRuntimePointCloudLoadContext& Context)
+{
+	glTFRuntimePointCloud::FFileWindow File;
+	if (!PointCloud || !File.Open(Filename))
+	{
+		UE_LOG(LogGLTFRuntime, Error, TEXT("Unable to open LAS file %s"), *Filename);
+		return false;
+	}
+
+	glTFRuntimePointCloud::FLASHeader Header;
+	{
+		int64 HeaderSize = 64 * 1024;
+		const uint8* HeaderData = File.Map(0, HeaderSize);
+		TArray64<uint8> HeaderBlob;
+		HeaderBlob.Append(HeaderData, HeaderData ? HeaderSize : 0);
+		if (!Header.Parse(HeaderBlob))
+		{
+			UE_LOG(LogGLTFRuntime, Error, TEXT("Invalid LAS header"));
+			return false;
+		}
+	}
+
+	glTFRuntimePointCloud::FLASDecoder Decoder;
+	if (!glTFRuntimePointCloud::InitLASDecoder(Header, File.GetFileSize(), Origin, Decoder))
+	{
+		return false;
+	}
+
+	const int64 NumberOfPoints = static_cast<int64>(Header.NumberOfPoints);
+	const int64 RecordLength = Header.PointDataRecordLength;
+
+	// a window holds its records and the decoded points, both must fit in the budget
+	const int64 RecordsPerWindow = FMath::Max<int64>(glTFRuntimePointCloud::LASPointsPerBlock, MemoryBudget / (RecordLength + static_cast<int64>(sizeof(FLidarPointCloudPoint))));
+	const int64 NumWindows = (NumberOfPoints + RecordsPerWindow - 1) / RecordsPerWindow;
+
+	auto MapWindow = [&](const int64 WindowIndex, int64& FirstRecord, int64& NumRecords) -> const uint8*
+		{
+			FirstRecord = WindowIndex * RecordsPerWindow;
+			NumRecords = FMath::Min(RecordsPerWindow, NumberOfPoints - FirstRecord);
+			int64 WindowSize = NumRecords * RecordLength;
+			const uint8* WindowData = File.Map(Header.PointDataOffset + FirstRecord * RecordLength, WindowSize);
+			if (!WindowData || WindowSize != NumRecords * RecordLength)
+			{
+				UE_LOG(LogGLTFRuntime, Error, TEXT("Unable to read LAS point data at record %lld"), FirstRecord);
+				return nullptr;
+			}
+			return WindowData;
+		};
+
+	// first pass: color ranges and bounds of the whole file, so that the octree is sized once
+	glTFRuntimePointCloud::FLASScan Scan;
+	for (int64 WindowIndex = 0; WindowIndex < NumWindows; WindowIndex++)
+	{
+		int64 FirstRecord = 0;
+		int64 NumRecords = 0;
+		const uint8* WindowData = MapWindow(WindowIndex, FirstRecord, NumRecords);
+		if (!WindowData)
+		{
+			return false;
+		}
+
+		Scan.Merge(glTFRuntimePointCloud::ScanLASRecords<true>(Decoder, WindowData, RecordLength, NumRecords, Context));
+
+		if (Context.IsCanceled())
+		{
+			return false;
+		}
+
+		Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::LineScan, FirstRecord + NumRecords, NumberOfPoints);
+	}
+
+	Decoder.SetRanges(Scan);
+
+	if (!Scan.Bounds.IsValid)
+	{
+		return true;
+	}
+
+	PointCloud->Initialize(FBox(Scan.Bounds));
+
+	// second pass: every window is decoded, filtered and inserted in the octree before mapping the next one
+	const TArray<glTFRuntimePointCloud::FLASPointFormat::EField> RangeFields = glTFRuntimePointCloud::GetLASRangeFields(Context.Config);
+	TArray64<FLidarPointCloudPoint> Points;
+	std::atomic<int64> DecodedPoints = 0;
+
+	for (int64 WindowIndex = 0; WindowIndex < NumWindows; WindowIndex++)
+	{
+		int64 FirstRecord = 0;
+		int64 NumRecords = 0;
+		const uint8* WindowData = MapWindow(WindowIndex, FirstRecord, NumRecords);
+		if (!WindowData)
+		{
+			return false;
+		}
+
+		Points.Reset();
+		glTFRuntimePointCloud::FPointSink Sink(Points, glTFRuntimePointCloud::MakeWindowConfig(Context.Config, FirstRecord, NumRecords, NumberOfPoints));
+		if (!Sink.Begin(NumRecords))
+		{
+			return false;
+		}
+
+		glTFRuntimePointCloud::DecodeLASRecords(Decoder, WindowData, RecordLength, NumRecords, Sink, RangeFields, DecodedPoints, NumberOfPoints, Context);
+
+		if (!Sink.End(Context))
+		{
+			return false;
+		}
+
+		{
+			GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, OctreeBuild);
+			PointCloud->InsertPoints(Points.GetData(), Points.Num(), ELidarPointCloudDuplicateHandling::Ignore, false, FVector::ZeroVector);
+		}
+	}
+
+	Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, 1, 1);
+
+	UE_LOG(LogGLTFRuntime, Log, TEXT("Streamed %lld LAS points in %lld windows"), NumberOfPoints, NumWindows);
+
+	return true;
+}
@@ -0,0 +1,233 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LidarPointCloudShared.h"
+
+namespace glTFRuntimePointCloud
+{
+	template<typename T>
+	FORCEINLINE T ReadLASValue(const uint8* Data, const int64 Offset)
+	{
+		T Value;
+		FMemory::Memcpy(&Value, Data + Offset, sizeof(T));
+		return Value;
+	}
+
+	/* LAS 1.0 - 1.4 public header block (uncompressed point data only) */
+	struct FLASHeader
+	{
+		uint8 VersionMajor = 0;
+		uint8 VersionMinor = 0;
+		uint16 HeaderSize = 0;
+		uint32 PointDataOffset = 0;
+		uint8 PointDataFormat = 0;
+		uint16 PointDataRecordLength = 0;
+		uint64 NumberOfPoints = 0;
+		FVector Scale = FVector::OneVector;
+		FVector Offset = FVector::ZeroVector;
+		FVector Min = FVector::ZeroVector;
+		FVector Max = FVector::ZeroVector;
+		bool bCompressed = false;
+
+		static constexpr int64 MinHeaderSize = 227;
+
+		bool Parse(const TArray64<uint8>& Blob)
+		{
+			const uint8* Data = Blob.GetData();
+
+			if (Blob.Num() < MinHeaderSize || FMemory::Memcmp(Data, "LASF", 4) != 0)
+			{
+				return false;
+			}
+
+			VersionMajor = Data[24];
+			VersionMinor = Data[25];
+			HeaderSize = ReadLASValue<uint16>(Data, 94);
+			PointDataOffset = ReadLASValue<uint32>(Data, 96);
+			PointDataFormat = Data[104];
+			PointDataRecordLength = ReadLASValue<uint16>(Data, 105);
+			NumberOfPoints = ReadLASValue<uint32>(Data, 107);
+
+			Scale = FVector(ReadLASValue<double>(Data, 131), ReadLASValue<double>(Data, 139), ReadLASValue<double>(Data, 147));
+			Offset = FVector(ReadLASValue<double>(Data, 155), ReadLASValue<double>(Data, 163), ReadLASValue<double>(Data, 171));
+			Max = FVector(ReadLASValue<double>(Data, 179), ReadLASValue<double>(Data, 195), ReadLASValue<double>(Data, 211));
+			Min = FVector(ReadLASValue<double>(Data, 187), ReadLASValue<double>(Data, 203), ReadLASValue<double>(Data, 219));
+
+			// LAS 1.4 64 bit point count (the legacy one is 0 for formats 6-10 or more than 4G points)
+			if (VersionMajor == 1 && VersionMinor >= 4 && HeaderSize >= 255 && Blob.Num() >= 255)
+			{
+				const uint64 NumberOfPoints64 = ReadLASValue<uint64>(Data, 247);
+				if (NumberOfPoints64 > 0)
+				{
+					NumberOfPoints = NumberOfPoints64;
+				}
+			}
+
+			// LASzip marks compressed data using the high bits of the format
+			bCompressed = (PointDataFormat & 0xC0) != 0;
+			PointDataFormat &= 0x3F;
+
+			return HeaderSize >= MinHeaderSize && PointDataOffset >= HeaderSize;
+		}
+	};
+
+	/* Fixed layout of a point data record format (offsets of the fields we map) */
+	struct FLASPointFormat
+	{
+		int32 MinRecordLength = 0;
+		int32 ClassificationOffset = 0;
+		uint8 ClassificationMask = 0xFF;
+		int32 RGBOffset = -1;
+
+		bool Init(const uint8 Format)
+		{
+			// formats 0-5 share the legacy 20 bytes core, 6-10 the 30 bytes extended one
+			static const int32 MinRecordLengths[] = { 20, 28, 26, 34, 57, 63, 30, 36, 38, 59, 67 };
+			static const int32 RGBOffsets[] = { -1, -1, 20, 28, -1, 28, -1, 30, 30, -1, 30 };
+
+			if (Format > 10)
+			{
+				return false;
+			}
+
+			MinRecordLength = MinRecordLengths[Format];
+			RGBOffset = RGBOffsets[Format];
+
+			if (Format < 6)
+			{
+				ClassificationOffset = 15;
+				ClassificationMask = 0x1F;
+			}
+			else
+			{
+				ClassificationOffset = 16;
+				ClassificationMask = 0xFF;
+			}
+
+			return true;
+		}
+
+		bool HasRGB() const
+		{
+			return RGBOffset >= 0;
+		}
+
+		/* Fields available to the range filters */
+		enum EField
+		{
+			None,
+			Intensity,
+			Classification
+		};
+
+		static EField FindField(const FString& Name)
+		{
+			if (Name == TEXT("intensity"))
+			{
+				return Intensity;
+			}
+			if (Name == TEXT("classification"))
+			{
+				return Classification;
+			}
+			return None;
+		}
+
+		FORCEINLINE double GetField(const uint8* Record, const EField Field) const
+		{
+			switch (Field)
+			{
+			case Intensity:
+				return ReadLASValue<uint16>(Record, 12);
+			case Classification:
+				return Record[ClassificationOffset] & ClassificationMask;
+			default:
+				return 0;
+			}
+		}
+	};
+
+	/* Ranges found in a set of records: 16 bit color maxima and (optionally) the decoded locations bounds */
+	struct FLASScan
+	{
+		uint16 MaxRGB = 0;
+		uint16 MaxIntensity = 0;
+		FBox3f Bounds = FBox3f(ForceInit);
+
+		void Merge(const FLASScan& Other)
+		{
+			MaxRGB = FMath::Max(MaxRGB, Other.MaxRGB);
+			MaxIntensity = FMath::Max(MaxIntensity, Other.MaxIntensity);
+			Bounds += Other.Bounds;
+		}
+	};
+
+	/* Record to point conversion, the color shifts are set from the 16 bit ranges of all of the records */
+	struct FLASDecoder
+	{
+		FLASPointFormat Format;
+		FVector Scale = FVector::OneVector;
+		FVector Translation = FVector::ZeroVector;
+		int32 RGBShift = 8;
+		int32 IntensityShift = 8;
+		bool bOpaque = false;
+
+		template<bool bWithBounds>
+		void Scan(const uint8* Data, const int64 RecordLength, const int64 NumRecords, FLASScan& Result) const
+		{
+			for (int64 RecordIndex = 0; RecordIndex < NumRecords; RecordIndex++)
+			{
+				const uint8* Record = Data + RecordIndex * RecordLength;
+				Result.MaxIntensity = FMath::Max(Result.MaxIntensity, ReadLASValue<uint16>(Record, 12));
+				if (Format.HasRGB())
+				{
+					Result.MaxRGB = FMath::Max(Result.MaxRGB, FMath::Max3(
+						ReadLASValue<uint16>(Record, Format.RGBOffset),
+						ReadLASValue<uint16>(Record, Format.RGBOffset + 2),
+						ReadLASValue<uint16>(Record, Format.RGBOffset + 4)));
+				}
+				if constexpr (bWithBounds)
+				{
+					Result.Bounds += DecodeLocation(Record);
+				}
+			}
+		}
+
+		/* Some writers store 8 bit values in the 16 bit fields, no intensity at all means fully opaque points */
+		void SetRanges(const FLASScan& Ranges)
+		{
+			RGBShift = Format.HasRGB() && Ranges.MaxRGB > 0 && Ranges.MaxRGB <= 0xFF ? 0 : 8;
+			IntensityShift = Ranges.MaxIntensity <= 0xFF ? 0 : 8;
+			bOpaque = Ranges.MaxIntensity == 0;
+		}
+
+		FORCEINLINE FVector3f DecodeLocation(const uint8* Record) const
+		{
+			return FVector3f(
+				static_cast<float>(ReadLASValue<int32>(Record, 0) * Scale.X + Translation.X),
+				static_cast<float>(ReadLASValue<int32>(Record, 4) * Scale.Y + Translation.Y),
+				static_cast<float>(ReadLASValue<int32>(Record, 8) * Scale.Z + Translation.Z));
+		}
+
+		FORCEINLINE FLidarPointCloudPoint Decode(const uint8* Record) const
+		{
+			FLidarPointCloudPoint Point;
+			Point.Location = DecodeLocation(Record);
+
+			Point.Color.A = bOpaque ? 0xFF : static_cast<uint8>(ReadLASValue<uint16>(Record, 12) >> IntensityShift);
+
+			if (Format.HasRGB())
+			{
+				Point.Color.R = static_cast<uint8>(ReadLASValue<uint16>(Record, Format.RGBOffset) >> RGBShift);
+				Point.Color.G = static_cast<uint8>(ReadLASValue<uint16>(Record, Format.RGBOffset + 2) >> RGBShift);
+				Point.Color.B = static_cast<uint8>(ReadLASValue<uint16>(Record, Format.RGBOffset + 4) >> RGBShift);
+			}
+
+			Point.ClassificationID = Record[Format.ClassificationOffset] & Format.ClassificationMask;
+
+			return Point;
+		}
+	};
+}
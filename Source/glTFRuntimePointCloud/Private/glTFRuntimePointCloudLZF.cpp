@@ -0,0 +1,275 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#include "glTFRuntimePointCloudLZF.h"
+
+namespace
+{
+	constexpr int32 LZFMaxLiteral = 1 << 5;
+	constexpr int64 LZFMaxOffset = 1 << 13;
+	constexpr int64 LZFMaxReference = (1 << 8) + (1 << 3);
+	constexpr int32 LZFHashLog = 16;
+
+	FORCEINLINE uint32 LZFHash(const uint8* Ptr)
+	{
+		const uint32 Value = (static_cast<uint32>(Ptr[0]) << 16) | (static_cast<uint32>(Ptr[1]) << 8) | Ptr[2];
+		return (Value * 2654435761u) >> (32 - LZFHashLog);
+	}
+
+	FORCEINLINE void Copy8(uint8* Destination, const uint8* Source)
+	{
+		uint64 Value;
+		FMemory::Memcpy(&Value, Source, 8);
+		FMemory::Memcpy(Destination, &Value, 8);
+	}
+
+	FORCEINLINE void Copy16(uint8* Destination, const uint8* Source)
+	{
+		uint64 Value[2];
+		FMemory::Memcpy(Value, Source, 16);
+		FMemory::Memcpy(Destination, Value, 16);
+	}
+}
+
+int64 FglTFRuntimePointCloudLZF::Decompress(const uint8* Input, const int64 InputSize, uint8* Output, const int64 OutputSize)
+{
+	const uint8* InputPtr = Input;
+	const uint8* InputEnd = Input + InputSize;
+	uint8* OutputPtr = Output;
+	uint8* OutputEnd = Output + OutputSize;
+
+	while (InputPtr < InputEnd)
+	{
+		const uint32 Ctrl = *InputPtr++;
+
+		if (Ctrl < (1 << 5)) // literal run
+		{
+			const int64 Length = Ctrl + 1;
+
+			// fast path: copy the whole max literal run (32 bytes) when both buffers have enough room
+			if (InputEnd - InputPtr >= LZFMaxLiteral && OutputEnd - OutputPtr >= LZFMaxLiteral)
+			{
+				Copy16(OutputPtr, InputPtr);
+				Copy16(OutputPtr + 16, InputPtr + 16);
+			}
+			else
+			{
+				if (OutputPtr + Length > OutputEnd || InputPtr + Length > InputEnd)
+				{
+					return -1;
+				}
+				FMemory::Memcpy(OutputPtr, InputPtr, Length);
+			}
+
+			InputPtr += Length;
+			OutputPtr += Length;
+		}
+		else // back reference
+		{
+			int64 Length = Ctrl >> 5;
+
+			if (InputPtr >= InputEnd)
+			{
+				return -1;
+			}
+
+			if (Length == 7)
+			{
+				Length += *InputPtr++;
+				if (InputPtr >= InputEnd)
+				{
+					return -1;
+				}
+			}
+
+			Length += 2;
+
+			const int64 Distance = ((static_cast<int64>(Ctrl & 0x1f) << 8) | *InputPtr++) + 1;
+
+			if (OutputPtr - Output < Distance || OutputPtr + Length > OutputEnd)
+			{
+				return -1;
+			}
+
+			const uint8* Reference = OutputPtr - Distance;
+
+			// all of the bounds checks are done, wide copies can overrun Length (but never OutputEnd) as the overrun is overwritten later
+			if (Distance >= 16 && OutputEnd - OutputPtr >= Length + 16)
+			{
+				uint8* CopyEnd = OutputPtr + Length;
+				while (OutputPtr < CopyEnd)
+				{
+					Copy16(OutputPtr, Reference);
+					OutputPtr += 16;
+					Reference += 16;
+				}
+				OutputPtr = CopyEnd;
+			}
+			else if (Distance >= 8 && OutputEnd - OutputPtr >= Length + 8)
+			{
+				uint8* CopyEnd = OutputPtr + Length;
+				while (OutputPtr < CopyEnd)
+				{
+					Copy8(OutputPtr, Reference);
+					OutputPtr += 8;
+					Reference += 8;
+				}
+				OutputPtr = CopyEnd;
+			}
+			else if (Distance == 1)
+			{
+				// run of a single byte
+				FMemory::Memset(OutputPtr, *Reference, Length);
+				OutputPtr += Length;
+			}
+			else
+			{
+				for (int64 Index = 0; Index < Length; Index++)
+				{
+					*OutputPtr++ = *Reference++;
+				}
+			}
+		}
+	}
+
+	return OutputPtr - Output;
+}
+
+int64 FglTFRuntimePointCloudLZF::Compress(const uint8* Input, const int64 InputSize, uint8* Output, const int64 OutputSize)
+{
+	if (InputSize <= 0)
+	{
+		return 0;
+	}
+
+	if (OutputSize < 1)
+	{
+		return -1;
+	}
+
+	TArray<int64> HashTable;
+	HashTable.Init(-1, 1 << LZFHashLog);
+
+	int64 InputOffset = 0;
+	int64 OutputOffset = 1; // reserve the control byte of the first literal run
+	int64 LiteralStart = 0;
+	int32 Literals = 0;
+
+	auto EmitLiteral = [&]() -> bool
+		{
+			if (OutputOffset >= OutputSize)
+			{
+				return false;
+			}
+			Output[OutputOffset++] = Input[InputOffset++];
+			if (++Literals == LZFMaxLiteral)
+			{
+				Output[LiteralStart] = LZFMaxLiteral - 1;
+				Literals = 0;
+				if (OutputOffset >= OutputSize)
+				{
+					return false;
+				}
+				LiteralStart = OutputOffset++;
+			}
+			return true;
+		};
+
+	while (InputOffset + 2 < InputSize)
+	{
+		const uint32 Hash = LZFHash(Input + InputOffset);
+		const int64 Reference = HashTable[Hash];
+		HashTable[Hash] = InputOffset;
+
+		const int64 Offset = InputOffset - Reference - 1;
+
+		if (Reference >= 0 && Offset < LZFMaxOffset &&
+			Input[Reference] == Input[InputOffset] &&
+			Input[Reference + 1] == Input[InputOffset + 1] &&
+			Input[Reference + 2] == Input[InputOffset + 2])
+		{
+			const int64 MaxLength = FMath::Min(InputSize - InputOffset, LZFMaxReference);
+			int64 Length = 3;
+			while (Length < MaxLength && Input[Reference + Length] == Input[InputOffset + Length])
+			{
+				Length++;
+			}
+
+			// close the pending literal run (or drop its unused control byte)
+			if (Literals > 0)
+			{
+				Output[LiteralStart] = Literals - 1;
+			}
+			else
+			{
+				OutputOffset--;
+			}
+
+			const int64 EncodedLength = Length - 2;
+			const int64 MatchEnd = InputOffset + Length;
+
+			// back reference (2 or 3 bytes) plus the next literal run control byte only when input remains
+			// (the control byte reserved after the last match is dropped at the end)
+			if (OutputOffset + (EncodedLength < 7 ? 2 : 3) + (MatchEnd < InputSize ? 1 : 0) > OutputSize)
+			{
+				return -1;
+			}
+
+			if (EncodedLength < 7)
+			{
+				Output[OutputOffset++] = static_cast<uint8>((Offset >> 8) + (EncodedLength << 5));
+			}
+			else
+			{
+				Output[OutputOffset++] = static_cast<uint8>((Offset >> 8) + (7 << 5));
+				Output[OutputOffset++] = static_cast<uint8>(EncodedLength - 7);
+			}
+			Output[OutputOffset++] = static_cast<uint8>(Offset & 0xFF);
+
+			LiteralStart = OutputOffset++;
+			Literals = 0;
+
+			// index the positions covered by the match for better ratios on repetitive data
+			for (int64 Position = InputOffset + 1; Position < MatchEnd && Position + 2 < InputSize; Position++)
+			{
+				HashTable[LZFHash(Input + Position)] = Position;
+			}
+			InputOffset = MatchEnd;
+		}
+		else if (!EmitLiteral())
+		{
+			return -1;
+		}
+	}
+
+	while (InputOffset < InputSize)
+	{
+		if (!EmitLiteral())
+		{
+			return -1;
+		}
+	}
+
+	if (Literals > 0)
+	{
+		Output[LiteralStart] = Literals - 1;
+	}
+	else
+	{
+		OutputOffset--;
+	}
+
+	return OutputOffset;
+}
+
+bool FglTFRuntimePointCloudLZF::Compress(const uint8* Input, const int64 InputSize, TArray64<uint8>& Output)
+{
+	Output.SetNumUninitialized(GetCompressBound(InputSize));
+	const int64 CompressedSize = Compress(Input, InputSize, Output.GetData(), Output.Num());
+	if (CompressedSize < 0)
+	{
+		Output.Empty();
+		return false;
+	}
+	Output.SetNum(CompressedSize, false);
+	return true;
+}
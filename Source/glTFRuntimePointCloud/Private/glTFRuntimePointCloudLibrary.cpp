@@ -2,6 +2,55 @@
 
 #include "glTFRuntimePointCloudLibrary.h"
 #include "Async/ParallelFor.h"
+#include "glTFRuntimePointCloudAsyncAction.h"
+#include "glTFRuntimePointCloudCache.h"
+#include "glTFRuntimePointCloudColumns.h"
+#include "glTFRuntimePointCloudFile.h"
+#include "glTFRuntimePointCloudLZF.h"
+#include "glTFRuntimePointCloudMesh.h"
+#include "glTFRuntimePointCloudParsing.h"
+#include "glTFRuntimePointCloudPCD.h"
+#include "glTFRuntimePointCloudSink.h"
+#include "glTFRuntimePointCloudSort.h"
+#include "glTFRuntimePointCloudStats.h"
+#include "Misc/FileHelper.h"
+
+void FglTFRuntimePointCloudLoadContext::ReportProgress(const EglTFRuntimePointCloudLoadPhase Phase, const int64 Done, const int64 Total)
+{
+	if (!ProgressCallback || Total <= 0)
+	{
+		return;
+	}
+
+	const int32 Percent = static_cast<int32>(FMath::Clamp<int64>((Done * 100) / Total, 0, 100));
+	std::atomic<int32>& PhasePercent = LastPercent[static_cast<int32>(Phase)];
+	int32 CurrentPercent = PhasePercent.load();
+	while (Percent > CurrentPercent)
+	{
+		if (PhasePercent.compare_exchange_weak(CurrentPercent, Percent))
+		{
+			ProgressCallback(Phase, Percent / 100.0f);
+			return;
+		}
+	}
+}
+
+FglTFRuntimePointCloudLoadReport FglTFRuntimePointCloudLoadContext::GetReport() const
+{
+	FglTFRuntimePointCloudLoadReport CurrentReport = Report;
+	CurrentReport.NumRejectedPoints = NumRejectedPoints;
+	CurrentReport.TotalTime = FPlatformTime::Seconds() - StartTime;
+	return CurrentReport;
+}
+
+void FglTFRuntimePointCloudLoadContext::LogReport() const
+{
+	const FglTFRuntimePointCloudLoadReport CurrentReport = GetReport();
+	UE_LOG(LogGLTFRuntime, Log, TEXT("Point cloud load: input=%lld accepted=%lld rejected=%lld line_scan=%f parse=%f decompress=%f filter=%f sort=%f octree_build=%f total=%f bytes_allocated=%lld peak_used_physical=%lld"),
+		CurrentReport.NumInputPoints, CurrentReport.NumAcceptedPoints, CurrentReport.NumRejectedPoints,
+		CurrentReport.LineScanTime, CurrentReport.ParseTime, CurrentReport.DecompressTime, CurrentReport.FilterTime, CurrentReport.SortTime, CurrentReport.OctreeBuildTime, CurrentReport.TotalTime,
+		CurrentReport.BytesAllocated, CurrentReport.PeakUsedPhysical);
+}
 
 bool UglTFRuntimePointCloudLibrary::HasPointCloud(UglTFRuntimeAsset* Asset, const int32 MeshIndex)
 {
@@ -22,591 +71,1081 @@ bool UglTFRuntimePointCloudLibrary::HasPointCloud(UglTFRuntimeAsset* Asset, cons
 	return false;
 }
 
-ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromMesh(UglTFRuntimeAsset* Asset, const int32 MeshIndex)
+ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromMesh(UglTFRuntimeAsset* Asset, const int32 MeshIndex, const FglTFRuntimePointCloudConfig& PointCloudConfig)
 {
+	if (!Asset)
+	{
+		return nullptr;
+	}
+
 	TSharedPtr<FJsonObject> JsonMeshObject = Asset->GetParser()->GetJsonObjectFromRootIndex("meshes", MeshIndex);
 	if (!JsonMeshObject)
 	{
 		return nullptr;
 	}
 
-	TArray<FglTFRuntimePrimitive> Primitives;
-	if (!Asset->GetParser()->LoadPrimitives(JsonMeshObject.ToSharedRef(), Primitives, FglTFRuntimeMaterialsConfig(), false /* do not triangulate points */))
+	FglTFRuntimePointCloudLoadContext Context(PointCloudConfig);
+	TArray64<FLidarPointCloudPoint> Points;
+	if (!LoadPointsFromMeshes(Asset->GetParser().ToSharedRef(), { MeshIndex }, Points, Context))
 	{
 		return nullptr;
 	}
 
-	TArray<FLidarPointCloudPoint> Points;
-
+	return CreatePointCloud(Points, Context);
+}
 
-	for (const FglTFRuntimePrimitive& Primitive : Primitives)
+ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromMeshes(UglTFRuntimeAsset* Asset, const TArray<int32>& MeshIndices, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	if (!Asset)
 	{
-		if (Primitive.Mode == 0)
-		{
-			for (uint32 Index : Primitive.Indices)
-			{
-				FLidarPointCloudPoint Point;
-				if (Primitive.Positions.IsValidIndex(Index))
-				{
-					Point.Location = FVector3f(Primitive.Positions[Index]);
-				}
-				if (Primitive.Colors.IsValidIndex(Index))
-				{
-					Point.Color = FLinearColor(Primitive.Colors[Index]).ToFColor(true);
-				}
-				if (Primitive.Normals.IsValidIndex(Index))
-				{
-					Point.Normal = FVector3f(Primitive.Normals[Index]);
-				}
+		return nullptr;
+	}
 
-				Points.Add(MoveTemp(Point));
-			}
-		}
+	FglTFRuntimePointCloudLoadContext Context(PointCloudConfig);
+	TArray64<FLidarPointCloudPoint> Points;
+	if (!LoadPointsFromMeshes(Asset->GetParser().ToSharedRef(), MeshIndices, Points, Context))
+	{
+		return nullptr;
 	}
 
-	return ULidarPointCloud::CreateFromData(Points, false);
+	return CreatePointCloud(Points, Context);
 }
 
-ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromMeshes(UglTFRuntimeAsset* Asset, const TArray<int32>& MeshIndices)
+bool UglTFRuntimePointCloudLibrary::LoadPointsFromMeshes(TSharedRef<FglTFRuntimeParser> Parser, const TArray<int32>& MeshIndices, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context)
 {
-	TArray<FLidarPointCloudPoint> Points;
+	bool bSuccess = false;
 
-	for (const int32 MeshIndex : MeshIndices)
+	glTFRuntimePointCloud::FPointBasis Basis;
+	Basis.Init(*Parser);
+
+	// a slice of the output array filled by a single primitive
+	struct FPointSlice
 	{
-		TSharedPtr<FJsonObject> JsonMeshObject = Asset->GetParser()->GetJsonObjectFromRootIndex("meshes", MeshIndex);
-		if (!JsonMeshObject)
+		int32 DirectPrimitive = INDEX_NONE;
+		int32 ParserMesh = INDEX_NONE;
+		int32 ParserPrimitive = INDEX_NONE;
+		int64 FirstPoint = 0;
+		int64 NumPoints = 0;
+	};
+
+	TArray<glTFRuntimePointCloud::FPointPrimitive> DirectPrimitives;
+	glTFRuntimePointCloud::FMeshoptBufferViews MeshoptBufferViews;
+	TArray<TArray<FglTFRuntimePrimitive>> ParserMeshes;
+	TArray<FPointSlice> Slices;
+	int64 NumPoints = 0;
+
+	// first pass (serial, the parser is not thread safe): resolve accessors and count the points
+	for (int32 MeshIndexOffset = 0; MeshIndexOffset < MeshIndices.Num(); MeshIndexOffset++)
+	{
+		if (Context.IsCanceled())
 		{
-			continue;
+			return false;
 		}
 
-		TArray<FglTFRuntimePrimitive> Primitives;
-		if (!Asset->GetParser()->LoadPrimitives(JsonMeshObject.ToSharedRef(), Primitives, FglTFRuntimeMaterialsConfig(), false /* do not triangulate points */))
+		TSharedPtr<FJsonObject> JsonMeshObject = Parser->GetJsonObjectFromRootIndex("meshes", MeshIndices[MeshIndexOffset]);
+		if (!JsonMeshObject)
 		{
 			continue;
 		}
 
-		for (const FglTFRuntimePrimitive& Primitive : Primitives)
+		// mode 0 primitives are decoded straight from their accessors, anything unsupported falls back to the parser
+		const int32 FirstDirectPrimitive = DirectPrimitives.Num();
+		bool bDirectDecode = true;
+		for (TSharedRef<FJsonObject> JsonPrimitiveObject : Parser->GetJsonObjectArrayOfObjects(JsonMeshObject.ToSharedRef(), "primitives"))
 		{
-			if (Primitive.Mode == 0)
+			if (Parser->GetJsonObjectNumber(JsonPrimitiveObject, "mode", 4) != 0)
 			{
-				for (uint32 Index : Primitive.Indices)
-				{
-					FLidarPointCloudPoint Point;
-					if (Primitive.Positions.IsValidIndex(Index))
-					{
-						Point.Location = FVector3f(Primitive.Positions[Index]);
-					}
-					if (Primitive.Colors.IsValidIndex(Index))
-					{
-						Point.Color = FLinearColor(Primitive.Colors[Index]).ToFColor(true);
-					}
-					if (Primitive.Normals.IsValidIndex(Index))
-					{
-						Point.Normal = FVector3f(Primitive.Normals[Index]);
-					}
+				continue;
+			}
 
-					Points.Add(MoveTemp(Point));
-				}
+			glTFRuntimePointCloud::FPointPrimitive& PointPrimitive = DirectPrimitives.AddDefaulted_GetRef();
+			if (!PointPrimitive.Init(*Parser, JsonPrimitiveObject, MeshoptBufferViews, Context.Config.RangeFilters))
+			{
+				bDirectDecode = false;
+				break;
 			}
 		}
-	}
-
-	return ULidarPointCloud::CreateFromData(Points, false);
-}
-
-ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromXYZ(UglTFRuntimeAsset* Asset, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig)
-{
-	return LoadPointCloudFromXYZWithFilter(Asset, nullptr, nullptr, ASCIIPointCloudConfig);
-}
-
-ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromXYZWithFilter(UglTFRuntimeAsset* Asset, TFunction<void(FLidarPointCloudPoint&, const TArray<FString>&, const FglTFRuntimeASCIIPointCloudConfig&)> StringFilter, TFunction<void(FLidarPointCloudPoint&, const TArray<double>&, const TArray<double>&, const TArray<double>&, const FglTFRuntimeASCIIPointCloudConfig&)> FloatFilter, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig)
-{
-	if (!Asset)
-	{
-		return nullptr;
-	}
 
-	const TArray64<uint8>& Blob = Asset->GetParser()->GetBlob();
-
-	TArray<FLidarPointCloudPoint> Points;
+		if (bDirectDecode)
+		{
+			for (int32 PrimitiveIndex = FirstDirectPrimitive; PrimitiveIndex < DirectPrimitives.Num(); PrimitiveIndex++)
+			{
+				FPointSlice& Slice = Slices.AddDefaulted_GetRef();
+				Slice.DirectPrimitive = PrimitiveIndex;
+				Slice.FirstPoint = NumPoints;
+				Slice.NumPoints = DirectPrimitives[PrimitiveIndex].NumPoints;
+				NumPoints += Slice.NumPoints;
+			}
 
-	TArray<FString> CurrentLine;
-	TPair<int64, int64> CurrentString = { -1, 0 };
+			bSuccess = true;
+			continue;
+		}
 
-	TArray<TPair<int64, int64>> BinaryLines;
+		DirectPrimitives.SetNum(FirstDirectPrimitive);
 
-	float StartTime = FPlatformTime::Seconds();
+		TArray<FglTFRuntimePrimitive> Primitives;
+		if (!Parser->LoadPrimitives(JsonMeshObject.ToSharedRef(), Primitives, FglTFRuntimeMaterialsConfig(), false /* do not triangulate points */))
+		{
+			continue;
+		}
 
-	for (int64 Index = 0; Index < Blob.Num(); Index++)
-	{
-		const uint8 Char = Blob[Index];
+		bSuccess = true;
 
-		if (Char == '\r' || Char == '\n')
+		if (Context.Config.RangeFilters.Num() > 0)
 		{
-			if (CurrentString.Value > 0)
-			{
-				BinaryLines.Add(CurrentString);
-			}
-			CurrentString.Key = -1;
-			CurrentString.Value = 0;
+			UE_LOG(LogGLTFRuntime, Warning, TEXT("Mesh %d is loaded by the parser, its range filter attributes are 0"), MeshIndices[MeshIndexOffset]);
 		}
-		else
+
+		for (int32 PrimitiveIndex = 0; PrimitiveIndex < Primitives.Num(); PrimitiveIndex++)
 		{
-			if (CurrentString.Key < 0)
+			if (Primitives[PrimitiveIndex].Mode == 0)
 			{
-				CurrentString.Key = Index;
+				FPointSlice& Slice = Slices.AddDefaulted_GetRef();
+				Slice.ParserMesh = ParserMeshes.Num();
+				Slice.ParserPrimitive = PrimitiveIndex;
+				Slice.FirstPoint = NumPoints;
+				Slice.NumPoints = Primitives[PrimitiveIndex].Indices.Num();
+				NumPoints += Slice.NumPoints;
 			}
-			CurrentString.Value++;
 		}
+
+		ParserMeshes.Add(MoveTemp(Primitives));
 	}
 
-	if (CurrentString.Value > 0)
 	{
-		BinaryLines.Add(CurrentString);
+		GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, Decompress);
+		if (!MeshoptBufferViews.Decode())
+		{
+			UE_LOG(LogGLTFRuntime, Error, TEXT("Unable to decode EXT_meshopt_compression buffer views"));
+			return false;
+		}
 	}
 
-	const FglTFRuntimeASCIIPointCloudConfig& Config = ASCIIPointCloudConfig;
-
-	if (Config.LinesToSkip < 0 || Config.LinesToSkip > BinaryLines.Num())
+	// second pass: every slice is split in blocks, decoded in parallel into the preallocated array
+	struct FPointBlock
 	{
-		return nullptr;
+		int32 Slice;
+		int64 FirstPoint;
+		int64 LastPoint;
+	};
+
+	constexpr int64 PointsPerBlock = 64 * 1024;
+	TArray<FPointBlock> Blocks;
+	for (int32 SliceIndex = 0; SliceIndex < Slices.Num(); SliceIndex++)
+	{
+		for (int64 FirstPoint = 0; FirstPoint < Slices[SliceIndex].NumPoints; FirstPoint += PointsPerBlock)
+		{
+			Blocks.Add({ SliceIndex, FirstPoint, FMath::Min(FirstPoint + PointsPerBlock, Slices[SliceIndex].NumPoints) });
+		}
 	}
 
-	const int32 NumLines = BinaryLines.Num() - Config.LinesToSkip;
-
-	Points.AddUninitialized(NumLines);
-
-	if (Config.bComputeColumnsMinMax)
+	glTFRuntimePointCloud::FPointSink Sink(Points, Context.Config);
+	if (!Sink.Begin(NumPoints))
 	{
+		return false;
+	}
 
-		TArray<TArray<double>> Lines;
-		Lines.AddUninitialized(NumLines);
+	std::atomic<int64> DecodedPoints = 0;
 
-		ParallelFor(NumLines, [&](const int32 LineIndexOffset)
+	{
+		GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, Parse);
+		ParallelFor(Blocks.Num(), [&](const int32 BlockIndex)
 			{
-				const int32 LineIndex = LineIndexOffset + Config.LinesToSkip;
-
-				const TPair<int64, int64>& BinaryPair = BinaryLines[LineIndex];
-
-				const int64 PairLen = BinaryPair.Key + BinaryPair.Value;
-
-				TArray<double> Line;
+				if (Context.IsCanceled())
+				{
+					return;
+				}
 
-				int64 CurrentStringOffset = -1;
-				int64 CurrentStringLen = 0;
+				const FPointBlock& Block = Blocks[BlockIndex];
+				const FPointSlice& Slice = Slices[Block.Slice];
 
-				for (int64 Index = BinaryPair.Key; Index < PairLen; Index++)
-				{
-					const uint8 Char = Blob[Index];
-					if (Char == ' ' || Char == '\t')
+				auto DecodeRange = [&](const int64 FirstPoint, const int64 LastPoint, FLidarPointCloudPoint* SlicePoints)
 					{
-						if (CurrentStringLen > 0)
+						if (Slice.DirectPrimitive != INDEX_NONE)
 						{
-							Line.Add(FCString::Atod(*FString(CurrentStringLen, reinterpret_cast<const ANSICHAR*>(Blob.GetData() + CurrentStringOffset))));
+							DirectPrimitives[Slice.DirectPrimitive].Decode(Basis, FirstPoint, LastPoint, SlicePoints);
 						}
-						CurrentStringOffset = -1;
-						CurrentStringLen = 0;
-					}
-					else
-					{
-						if (CurrentStringOffset < 0)
+						else
 						{
-							CurrentStringOffset = Index;
+							glTFRuntimePointCloud::DecodeParserPrimitive(ParserMeshes[Slice.ParserMesh][Slice.ParserPrimitive], FirstPoint, LastPoint, SlicePoints);
 						}
-						CurrentStringLen++;
-					}
-				}
+					};
 
-				if (CurrentStringLen > 0)
+				if (Slice.DirectPrimitive != INDEX_NONE && DirectPrimitives[Slice.DirectPrimitive].CanDecodeColumns())
 				{
-					Line.Add(FCString::Atod(*FString(CurrentStringLen, reinterpret_cast<const ANSICHAR*>(Blob.GetData() + CurrentStringOffset))));
+					const glTFRuntimePointCloud::FPointPrimitive& Primitive = DirectPrimitives[Slice.DirectPrimitive];
+					glTFRuntimePointCloud::FPointSink::FWriter Writer(Sink);
+					glTFRuntimePointCloud::FPointColumns Columns(Primitive.Ranges.Num(), 4);
+					for (int64 PointIndex = Block.FirstPoint; PointIndex < Block.LastPoint;)
+					{
+						PointIndex = Columns.Gather(Writer, Slice.FirstPoint, PointIndex, Block.LastPoint);
+						Primitive.DecodeColumns(Basis, Columns);
+						Columns.Flush(Sink, Writer);
+					}
 				}
-
-				Lines[LineIndexOffset] = MoveTemp(Line);
-			});
-
-		TArray<double> MinValues;
-		TArray<double> MaxValues;
-
-		for (const TArray<double>& Line : Lines)
-		{
-			for (int32 LineIndex = 0; LineIndex < Line.Num(); LineIndex++)
-			{
-				if (!MinValues.IsValidIndex(LineIndex))
+				else if (Sink.IsPassthrough())
 				{
-					MinValues.Add(Line[LineIndex]);
+					DecodeRange(Block.FirstPoint, Block.LastPoint, Sink.GetOutput(Slice.FirstPoint + Block.FirstPoint));
 				}
 				else
 				{
-					MinValues[LineIndex] = FMath::Min(MinValues[LineIndex], Line[LineIndex]);
-				}
+					// only the accepted points are decoded
+					glTFRuntimePointCloud::FPointSink::FWriter Writer(Sink);
+					for (int64 PointIndex = Block.FirstPoint; PointIndex < Block.LastPoint; PointIndex++)
+					{
+						if (!Writer.Accepts(Slice.FirstPoint + PointIndex))
+						{
+							continue;
+						}
 
-				if (!MaxValues.IsValidIndex(LineIndex))
-				{
-					MaxValues.Add(Line[LineIndex]);
-				}
-				else
-				{
-					MaxValues[LineIndex] = FMath::Max(MaxValues[LineIndex], Line[LineIndex]);
+						if (Sink.HasRanges() && !Writer.AcceptsRanges([&](const int32 RangeIndex) { return Slice.DirectPrimitive != INDEX_NONE ? DirectPrimitives[Slice.DirectPrimitive].GetRange(PointIndex, RangeIndex) : 0.0; }))
+						{
+							continue;
+						}
+
+						FLidarPointCloudPoint Point;
+						DecodeRange(PointIndex, PointIndex + 1, &Point);
+						Writer.Add(Slice.FirstPoint + PointIndex, Point);
+					}
 				}
-			}
-		}
 
-		ParallelFor(NumLines, [&](const int32 LineIndexOffset)
-			{
-				TArray<double> Line = Lines[LineIndexOffset];
-				FLidarPointCloudPoint Point;
+				Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, DecodedPoints += Block.LastPoint - Block.FirstPoint, NumPoints);
+			});
+	}
 
-				if (Config.XYZColumns.X >= 0 && Config.XYZColumns.X < Line.Num())
-				{
-					Point.Location.X = Line[Config.XYZColumns.X];
-				}
+	if (!Sink.End(Context))
+	{
+		return false;
+	}
 
-				if (Config.XYZColumns.Y >= 0 && Config.XYZColumns.Y < Line.Num())
-				{
-					Point.Location.Y = Line[Config.XYZColumns.Y];
-				}
+	Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, 1, 1);
 
-				if (Config.XYZColumns.Z >= 0 && Config.XYZColumns.Z < Line.Num())
-				{
-					Point.Location.Z = Line[Config.XYZColumns.Z];
-				}
+	return bSuccess;
+}
 
-				if (Config.RGBColumns.X >= 0 && Config.RGBColumns.X < Line.Num())
-				{
-					Point.Color.R = Line[Config.RGBColumns.X] * (Config.bFloatColors ? 255 : 1);
-				}
+ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromXYZ(UglTFRuntimeAsset* Asset, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	return LoadPointCloudFromXYZWithFilter(Asset, nullptr, nullptr, ASCIIPointCloudConfig, PointCloudConfig);
+}
 
-				if (Config.RGBColumns.Y >= 0 && Config.RGBColumns.Y < Line.Num())
-				{
-					Point.Color.G = Line[Config.RGBColumns.Y] * (Config.bFloatColors ? 255 : 1);
-				}
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudLibrary::LoadPointCloudFromMeshAsync(UglTFRuntimeAsset* Asset, const int32 MeshIndex, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromMesh(Asset, MeshIndex, PointCloudConfig);
+	Action->AsyncCallback = AsyncCallback;
+	Action->ProgressCallback = ProgressCallback;
+	Action->Activate();
+	return Action;
+}
 
-				if (Config.RGBColumns.Z >= 0 && Config.RGBColumns.Z < Line.Num())
-				{
-					Point.Color.B = Line[Config.RGBColumns.Z] * (Config.bFloatColors ? 255 : 1);
-				}
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudLibrary::LoadPointCloudFromMeshesAsync(UglTFRuntimeAsset* Asset, const TArray<int32>& MeshIndices, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromMeshes(Asset, MeshIndices, PointCloudConfig);
+	Action->AsyncCallback = AsyncCallback;
+	Action->ProgressCallback = ProgressCallback;
+	Action->Activate();
+	return Action;
+}
 
-				if (Config.NormalColumns.X >= 0 && Config.NormalColumns.X < Line.Num())
-				{
-					Point.Normal.X = Line[Config.NormalColumns.X];
-				}
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudLibrary::LoadPointCloudFromXYZAsync(UglTFRuntimeAsset* Asset, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback)
+{
+	return LoadPointCloudFromXYZWithFilterAsync(Asset, nullptr, nullptr, ASCIIPointCloudConfig, PointCloudConfig, AsyncCallback, ProgressCallback);
+}
 
-				if (Config.NormalColumns.Y >= 0 && Config.NormalColumns.Y < Line.Num())
-				{
-					Point.Normal.Y = Line[Config.NormalColumns.Y];
-				}
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudLibrary::LoadPointCloudFromXYZWithFilterAsync(UglTFRuntimeAsset* Asset, TFunction<void(FLidarPointCloudPoint&, const TArray<FString>&, const FglTFRuntimeASCIIPointCloudConfig&)> StringFilter, TFunction<void(FLidarPointCloudPoint&, const TArray<double>&, const TArray<double>&, const TArray<double>&, const FglTFRuntimeASCIIPointCloudConfig&)> FloatFilter, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback)
+{
+	TSharedPtr<FglTFRuntimeParser> Parser = Asset ? Asset->GetParser() : nullptr;
+	UglTFRuntimePointCloudAsyncAction* Action = UglTFRuntimePointCloudAsyncAction::CreateAction(Asset, PointCloudConfig, [Parser, StringFilter, FloatFilter, ASCIIPointCloudConfig](FglTFRuntimePointCloudLoadContext& Context, TArray64<FLidarPointCloudPoint>& Points)
+		{
+			return LoadPointsFromXYZ(Parser.ToSharedRef(), StringFilter, FloatFilter, ASCIIPointCloudConfig, Points, Context);
+		});
+	Action->AsyncCallback = AsyncCallback;
+	Action->ProgressCallback = ProgressCallback;
+	Action->Activate();
+	return Action;
+}
 
-				if (Config.NormalColumns.Z >= 0 && ASCIIPointCloudConfig.NormalColumns.Z < Line.Num())
-				{
-					Point.Normal.Z = Line[Config.NormalColumns.Z];
-				}
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudLibrary::LoadPointCloudFromPCDAsync(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromPCD(Asset, PointCloudConfig);
+	Action->AsyncCallback = AsyncCallback;
+	Action->ProgressCallback = ProgressCallback;
+	Action->Activate();
+	return Action;
+}
 
-				if (Config.AlphaColumn >= 0 && ASCIIPointCloudConfig.AlphaColumn < Line.Num())
-				{
-					Point.Color.A = Line[Config.AlphaColumn] * (Config.bFloatColors ? 255 : 1);
-				}
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudLibrary::LoadPointCloudFromMeshesProgressiveAsync(UglTFRuntimeAsset* Asset, const TArray<int32>& MeshIndices, const float PreviewFraction, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& PreviewCallback, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromMeshesProgressive(Asset, MeshIndices, PreviewFraction, PointCloudConfig);
+	Action->PreviewCallback = PreviewCallback;
+	Action->AsyncCallback = AsyncCallback;
+	Action->ProgressCallback = ProgressCallback;
+	Action->Activate();
+	return Action;
+}
 
-				if (FloatFilter)
-				{
-					FloatFilter(Point, Line, MinValues, MaxValues, ASCIIPointCloudConfig);
-				}
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudLibrary::LoadPointCloudFromXYZProgressiveAsync(UglTFRuntimeAsset* Asset, const float PreviewFraction, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& PreviewCallback, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromXYZProgressive(Asset, PreviewFraction, ASCIIPointCloudConfig, PointCloudConfig);
+	Action->PreviewCallback = PreviewCallback;
+	Action->AsyncCallback = AsyncCallback;
+	Action->ProgressCallback = ProgressCallback;
+	Action->Activate();
+	return Action;
+}
 
-				Points[LineIndexOffset] = MoveTemp(Point);
-			});
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudLibrary::LoadPointCloudFromPCDProgressiveAsync(UglTFRuntimeAsset* Asset, const float PreviewFraction, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& PreviewCallback, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromPCDProgressive(Asset, PreviewFraction, PointCloudConfig);
+	Action->PreviewCallback = PreviewCallback;
+	Action->AsyncCallback = AsyncCallback;
+	Action->ProgressCallback = ProgressCallback;
+	Action->Activate();
+	return Action;
+}
+
+ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromXYZWithFilter(UglTFRuntimeAsset* Asset, TFunction<void(FLidarPointCloudPoint&, const TArray<FString>&, const FglTFRuntimeASCIIPointCloudConfig&)> StringFilter, TFunction<void(FLidarPointCloudPoint&, const TArray<double>&, const TArray<double>&, const TArray<double>&, const FglTFRuntimeASCIIPointCloudConfig&)> FloatFilter, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	if (!Asset)
+	{
+		return nullptr;
 	}
-	else
+
+	FglTFRuntimePointCloudLoadContext Context(PointCloudConfig);
+	TArray64<FLidarPointCloudPoint> Points;
+	if (!LoadPointsFromXYZ(Asset->GetParser().ToSharedRef(), StringFilter, FloatFilter, ASCIIPointCloudConfig, Points, Context))
 	{
+		return nullptr;
+	}
 
-		ParallelFor(NumLines, [&](const int32 LineIndexOffset)
-			{
-				const int32 LineIndex = LineIndexOffset + Config.LinesToSkip;
+	return CreatePointCloud(Points, Context);
+}
+
+ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromXYZWithBatchFilter(UglTFRuntimeAsset* Asset, const TArray<int32>& FilterColumns, FglTFRuntimePointCloudBatchFilter BatchFilter, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	if (!Asset)
+	{
+		return nullptr;
+	}
+
+	FglTFRuntimePointCloudLoadContext Context(PointCloudConfig);
+	TArray64<FLidarPointCloudPoint> Points;
+	if (!LoadPointsFromXYZWithBatchFilter(Asset->GetParser().ToSharedRef(), FilterColumns, BatchFilter, ASCIIPointCloudConfig, Points, Context))
+	{
+		return nullptr;
+	}
+
+	return CreatePointCloud(Points, Context);
+}
+
+bool UglTFRuntimePointCloudLibrary::LoadPointsFromXYZ(TSharedRef<FglTFRuntimeParser> Parser, TFunction<void(FLidarPointCloudPoint&, const TArray<FString>&, const FglTFRuntimeASCIIPointCloudConfig&)> StringFilter, TFunction<void(FLidarPointCloudPoint&, const TArray<double>&, const TArray<double>&, const TArray<double>&, const FglTFRuntimeASCIIPointCloudConfig&)> FloatFilter, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context)
+{
+	const FglTFRuntimeASCIIPointCloudConfig& Config = ASCIIPointCloudConfig;
+
+	// min/max values are only consumed by the FloatFilter
+	const bool bComputeColumnsMinMax = Config.bComputeColumnsMinMax && FloatFilter;
+
+	// without legacy filters there is no need to expose every column of every line
+	if (!bComputeColumnsMinMax && !StringFilter)
+	{
+		return LoadPointsFromXYZWithBatchFilter(Parser, {}, nullptr, Config, Points, Context);
+	}
+
+	const TArray64<uint8>& Blob = Parser->GetBlob();
+
+	int64 DataBegin = 0;
+	const int64 DataEnd = Blob.Num();
+	TArray<glTFRuntimePointCloud::FLineChunk> Chunks;
+	const int64 TotalLines = glTFRuntimePointCloud::BuildLineChunksSkippingLines(Blob, Config.LinesToSkip, DataBegin, Chunks, Context);
+	if (TotalLines < 0)
+	{
+		return false;
+	}
+
+	Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::LineScan, 1, 1);
 
-				const TPair<int64, int64>& BinaryPair = BinaryLines[LineIndex];
+	const int64 NumLines = TotalLines;
+
+	glTFRuntimePointCloud::FPointSink Sink(Points, Context.Config);
+	if (!Sink.Begin(NumLines))
+	{
+		return false;
+	}
 
-				const int64 PairLen = BinaryPair.Key + BinaryPair.Value;
+	const glTFRuntimePointCloud::FASCIIColumns Columns(Config, {}, Context.Config.RangeFilters);
 
-				TArray<FString> Line;
+	std::atomic<int64> ParsedLines = 0;
 
-				int64 CurrentStringOffset = -1;
-				int64 CurrentStringLen = 0;
+	{
+		GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, Parse);
+		if (bComputeColumnsMinMax)
+		{
+			// first pass: per-chunk reduction of the columns min/max, nothing is stored per line
+			TArray<TArray<double>> ChunksMinValues;
+			TArray<TArray<double>> ChunksMaxValues;
+			ChunksMinValues.AddDefaulted(Chunks.Num());
+			ChunksMaxValues.AddDefaulted(Chunks.Num());
 
-				for (int64 Index = BinaryPair.Key; Index < PairLen; Index++)
+			ParallelFor(Chunks.Num(), [&](const int32 ChunkIndex)
 				{
-					const uint8 Char = Blob[Index];
-					if (Char == ' ' || Char == '\t')
+					if (Context.IsCanceled())
 					{
-						if (CurrentStringLen > 0)
+						return;
+					}
+
+					const glTFRuntimePointCloud::FLineChunk& Chunk = Chunks[ChunkIndex];
+					TArray<double>& ChunkMinValues = ChunksMinValues[ChunkIndex];
+					TArray<double>& ChunkMaxValues = ChunksMaxValues[ChunkIndex];
+
+					glTFRuntimePointCloud::ForEachLine(Blob.GetData(), DataBegin, DataEnd, Chunk, [&](const uint8* LineBegin, const uint8* LineEnd)
 						{
-							Line.Add(FString(CurrentStringLen, reinterpret_cast<const ANSICHAR*>(Blob.GetData() + CurrentStringOffset)));
-						}
-						CurrentStringOffset = -1;
-						CurrentStringLen = 0;
+							glTFRuntimePointCloud::ForEachToken(LineBegin, LineEnd, -1, [&](const int32 TokenIndex, const uint8* TokenBegin, const uint8* TokenEnd)
+								{
+									const double Value = glTFRuntimePointCloud::TokenToDouble(TokenBegin, TokenEnd);
+									if (!ChunkMinValues.IsValidIndex(TokenIndex))
+									{
+										ChunkMinValues.Add(Value);
+										ChunkMaxValues.Add(Value);
+									}
+									else
+									{
+										ChunkMinValues[TokenIndex] = FMath::Min(ChunkMinValues[TokenIndex], Value);
+										ChunkMaxValues[TokenIndex] = FMath::Max(ChunkMaxValues[TokenIndex], Value);
+									}
+								});
+						});
+
+					Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, ParsedLines += Chunk.NumLines, NumLines * 2);
+				});
+
+			if (Context.IsCanceled())
+			{
+				return false;
+			}
+
+			TArray<double> MinValues;
+			TArray<double> MaxValues;
+
+			for (int32 ChunkIndex = 0; ChunkIndex < Chunks.Num(); ChunkIndex++)
+			{
+				const TArray<double>& ChunkMinValues = ChunksMinValues[ChunkIndex];
+				const TArray<double>& ChunkMaxValues = ChunksMaxValues[ChunkIndex];
+				for (int32 ColumnIndex = 0; ColumnIndex < ChunkMinValues.Num(); ColumnIndex++)
+				{
+					if (!MinValues.IsValidIndex(ColumnIndex))
+					{
+						MinValues.Add(ChunkMinValues[ColumnIndex]);
+						MaxValues.Add(ChunkMaxValues[ColumnIndex]);
 					}
 					else
 					{
-						if (CurrentStringOffset < 0)
-						{
-							CurrentStringOffset = Index;
-						}
-						CurrentStringLen++;
+						MinValues[ColumnIndex] = FMath::Min(MinValues[ColumnIndex], ChunkMinValues[ColumnIndex]);
+						MaxValues[ColumnIndex] = FMath::Max(MaxValues[ColumnIndex], ChunkMaxValues[ColumnIndex]);
 					}
 				}
+			}
 
-				if (CurrentStringLen > 0)
+			// second pass: lines are parsed again in a per-chunk buffer and converted straight to points
+			ParallelFor(Chunks.Num(), [&](const int32 ChunkIndex)
 				{
-					Line.Add(FString(CurrentStringLen, reinterpret_cast<const ANSICHAR*>(Blob.GetData() + CurrentStringOffset)));
-				}
+					if (Context.IsCanceled())
+					{
+						return;
+					}
 
-				FLidarPointCloudPoint Point;
+					const glTFRuntimePointCloud::FLineChunk& Chunk = Chunks[ChunkIndex];
+					int64 LineIndexOffset = Chunk.FirstLine;
 
-				if (Config.XYZColumns.X >= 0 && Config.XYZColumns.X < Line.Num())
-				{
-					Point.Location.X = FCString::Atof(*(Line[Config.XYZColumns.X]));
-				}
+					TArray<double> Line;
+					glTFRuntimePointCloud::FPointSink::FWriter Writer(Sink);
 
-				if (Config.XYZColumns.Y >= 0 && Config.XYZColumns.Y < Line.Num())
-				{
-					Point.Location.Y = FCString::Atof(*(Line[Config.XYZColumns.Y]));
-				}
+					glTFRuntimePointCloud::ForEachLine(Blob.GetData(), DataBegin, DataEnd, Chunk, [&](const uint8* LineBegin, const uint8* LineEnd)
+						{
+							const int64 LineIndex = LineIndexOffset++;
+							if (!Writer.Accepts(LineIndex))
+							{
+								return;
+							}
 
-				if (Config.XYZColumns.Z >= 0 && Config.XYZColumns.Z < Line.Num())
-				{
-					Point.Location.Z = FCString::Atof(*(Line[Config.XYZColumns.Z]));
-				}
+							Line.Reset();
+							glTFRuntimePointCloud::ForEachToken(LineBegin, LineEnd, -1, [&Line](const int32 TokenIndex, const uint8* TokenBegin, const uint8* TokenEnd)
+								{
+									Line.Add(glTFRuntimePointCloud::TokenToDouble(TokenBegin, TokenEnd));
+								});
 
-				if (Config.RGBColumns.X >= 0 && Config.RGBColumns.X < Line.Num())
-				{
-					Point.Color.R = FCString::Atof(*(Line[Config.RGBColumns.X])) * (Config.bFloatColors ? 255 : 1);
-				}
+							if (Sink.HasRanges() && !Writer.AcceptsRanges([&](const int32 RangeIndex) { return Line.IsValidIndex(Columns.RangeColumns[RangeIndex]) ? Line[Columns.RangeColumns[RangeIndex]] : 0.0; }))
+							{
+								return;
+							}
 
-				if (Config.RGBColumns.Y >= 0 && Config.RGBColumns.Y < Line.Num())
-				{
-					Point.Color.G = FCString::Atof(*(Line[Config.RGBColumns.Y])) * (Config.bFloatColors ? 255 : 1);
-				}
+							FLidarPointCloudPoint Point = Columns.BuildPointFromColumns(Line.GetData(), Line.Num());
 
-				if (Config.RGBColumns.Z >= 0 && Config.RGBColumns.Z < Line.Num())
-				{
-					Point.Color.B = FCString::Atof(*(Line[Config.RGBColumns.Z])) * (Config.bFloatColors ? 255 : 1);
-				}
+							FloatFilter(Point, Line, MinValues, MaxValues, ASCIIPointCloudConfig);
 
-				if (Config.NormalColumns.X >= 0 && Config.NormalColumns.X < Line.Num())
-				{
-					Point.Normal.X = FCString::Atof(*(Line[Config.NormalColumns.X]));
-				}
+							Writer.Add(LineIndex, Point);
+						});
 
-				if (Config.NormalColumns.Y >= 0 && Config.NormalColumns.Y < Line.Num())
+					Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, ParsedLines += Chunk.NumLines, NumLines * 2);
+				});
+		}
+		else
+		{
+			ParallelFor(Chunks.Num(), [&](const int32 ChunkIndex)
 				{
-					Point.Normal.Y = FCString::Atof(*(Line[Config.NormalColumns.Y]));
-				}
+					if (Context.IsCanceled())
+					{
+						return;
+					}
 
-				if (Config.NormalColumns.Z >= 0 && ASCIIPointCloudConfig.NormalColumns.Z < Line.Num())
-				{
-					Point.Normal.Z = FCString::Atof(*(Line[Config.NormalColumns.Z]));
-				}
+					const glTFRuntimePointCloud::FLineChunk& Chunk = Chunks[ChunkIndex];
+					int64 LineIndexOffset = Chunk.FirstLine;
 
-				if (Config.AlphaColumn >= 0 && ASCIIPointCloudConfig.AlphaColumn < Line.Num())
-				{
-					Point.Color.A = FCString::Atof(*(Line[Config.AlphaColumn])) * (Config.bFloatColors ? 255 : 1);
-				}
+					// per-chunk scratch buffers, reused for every line
+					TArray<double, TInlineAllocator<16>> Values;
+					Values.AddZeroed(Columns.NumSlots);
+					TArray<FString> Line;
+					glTFRuntimePointCloud::FPointSink::FWriter Writer(Sink);
+
+					glTFRuntimePointCloud::ForEachLine(Blob.GetData(), DataBegin, DataEnd, Chunk, [&](const uint8* LineBegin, const uint8* LineEnd)
+						{
+							const int64 LineIndex = LineIndexOffset++;
+							if (!Writer.Accepts(LineIndex))
+							{
+								return;
+							}
+
+							const int32 NumTokens = Columns.ParseLine(LineBegin, LineEnd, Values.GetData());
+
+							if (Sink.HasRanges() && !Writer.AcceptsRanges([&](const int32 RangeIndex) { return Columns.GetRange(Values.GetData(), RangeIndex, NumTokens); }))
+							{
+								return;
+							}
+
+							FLidarPointCloudPoint Point = Columns.BuildPoint(Values.GetData(), NumTokens);
+
+							// the legacy filter requires every column as an FString
+							Line.Reset();
+							glTFRuntimePointCloud::ForEachToken(LineBegin, LineEnd, -1, [&Line](const int32 TokenIndex, const uint8* TokenBegin, const uint8* TokenEnd)
+								{
+									Line.Add(FString(static_cast<int32>(TokenEnd - TokenBegin), reinterpret_cast<const ANSICHAR*>(TokenBegin)));
+								});
+							StringFilter(Point, Line, ASCIIPointCloudConfig);
+
+							Writer.Add(LineIndex, Point);
+						});
+
+					Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, ParsedLines += Chunk.NumLines, NumLines);
+				});
+		}
+	}
 
-				if (StringFilter)
+	if (!Sink.End(Context))
+	{
+		return false;
+	}
+
+	Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, 1, 1);
+
+	return true;
+}
+
+bool UglTFRuntimePointCloudLibrary::LoadPointsFromXYZWithBatchFilter(TSharedRef<FglTFRuntimeParser> Parser, const TArray<int32>& FilterColumns, FglTFRuntimePointCloudBatchFilter BatchFilter, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context)
+{
+	const FglTFRuntimeASCIIPointCloudConfig& Config = ASCIIPointCloudConfig;
+
+	const TArray64<uint8>& Blob = Parser->GetBlob();
+
+	int64 DataBegin = 0;
+	const int64 DataEnd = Blob.Num();
+	TArray<glTFRuntimePointCloud::FLineChunk> Chunks;
+	const int64 TotalLines = glTFRuntimePointCloud::BuildLineChunksSkippingLines(Blob, Config.LinesToSkip, DataBegin, Chunks, Context);
+	if (TotalLines < 0)
+	{
+		return false;
+	}
+
+	Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::LineScan, 1, 1);
+
+	const int64 NumLines = TotalLines;
+
+	glTFRuntimePointCloud::FPointSink Sink(Points, Context.Config);
+	if (!Sink.Begin(NumLines))
+	{
+		return false;
+	}
+
+	// filter columns are parsed only when a filter consumes them
+	const glTFRuntimePointCloud::FASCIIColumns Columns(Config, BatchFilter ? FilterColumns : TArray<int32>(), Context.Config.RangeFilters);
+	const int32 NumExtraColumns = Columns.ExtraColumns.Num();
+
+	std::atomic<int64> ParsedLines = 0;
+
+	{
+		GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, Parse);
+		ParallelFor(Chunks.Num(), [&](const int32 ChunkIndex)
+			{
+				if (Context.IsCanceled())
 				{
-					StringFilter(Point, Line, ASCIIPointCloudConfig);
+					return;
 				}
 
-				Points[LineIndexOffset] = MoveTemp(Point);
+				const glTFRuntimePointCloud::FLineChunk& Chunk = Chunks[ChunkIndex];
+				int64 LineIndexOffset = Chunk.FirstLine;
+
+				// per-chunk scratch buffers, reused for every line
+				TArray<double, TInlineAllocator<16>> Values;
+				Values.AddZeroed(Columns.NumSlots);
+
+				glTFRuntimePointCloud::FPointSink::FWriter Writer(Sink);
+				glTFRuntimePointCloud::FBatchBuilder BatchBuilder(Writer, BatchFilter, NumExtraColumns);
+
+				glTFRuntimePointCloud::ForEachLine(Blob.GetData(), DataBegin, DataEnd, Chunk, [&](const uint8* LineBegin, const uint8* LineEnd)
+					{
+						const int64 LineIndex = LineIndexOffset++;
+
+						// the batch filter sees every point (in the ranges), decimation is applied to its output
+						if (!BatchFilter && !Writer.Accepts(LineIndex))
+						{
+							return;
+						}
+
+						const int32 NumTokens = Columns.ParseLine(LineBegin, LineEnd, Values.GetData());
+
+						if (Sink.HasRanges() && !Writer.AcceptsRanges([&](const int32 RangeIndex) { return Columns.GetRange(Values.GetData(), RangeIndex, NumTokens); }))
+						{
+							return;
+						}
+
+						if (BatchFilter)
+						{
+							BatchBuilder.Add(LineIndex, Columns.BuildPoint(Values.GetData(), NumTokens), [&](const int32 ExtraIndex) { return static_cast<float>(Columns.GetExtra(Values.GetData(), ExtraIndex, NumTokens)); });
+						}
+						else
+						{
+							Writer.Add(LineIndex, Columns.BuildPoint(Values.GetData(), NumTokens));
+						}
+					});
+
+				BatchBuilder.Flush();
+
+				Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, ParsedLines += Chunk.NumLines, NumLines);
 			});
 	}
 
-	UE_LOG(LogGLTFRuntime, Log, TEXT("Processed %d points in %f seconds"), NumLines, FPlatformTime::Seconds() - StartTime);
+	if (!Sink.End(Context))
+	{
+		return false;
+	}
+
+	Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, 1, 1);
 
-	return ULidarPointCloud::CreateFromData(Points, false);
+	return true;
 }
 
-ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromPCD(UglTFRuntimeAsset* Asset, FTransform& ViewPoint)
+ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromXYZFile(const FString& Filename, const int32 MemoryBudgetMB, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig)
 {
-	if (!Asset)
+	FglTFRuntimePointCloudLoadContext Context(PointCloudConfig);
+	ULidarPointCloud* PointCloud = NewObject<ULidarPointCloud>();
+	if (!StreamPointsFromXYZFile(Filename, static_cast<int64>(MemoryBudgetMB) * 1024 * 1024, ASCIIPointCloudConfig, PointCloud, Context))
 	{
 		return nullptr;
 	}
 
-	const TArray64<uint8>& Blob = Asset->GetParser()->GetBlob();
+	PointCloud->RefreshBounds();
+	PointCloud->RefreshRendering();
+	Context.LogReport();
+	return PointCloud;
+}
 
-	TArray<FLidarPointCloudPoint> Points;
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudLibrary::LoadPointCloudFromXYZFileAsync(const FString& Filename, const int32 MemoryBudgetMB, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromXYZFile(Filename, MemoryBudgetMB, ASCIIPointCloudConfig, PointCloudConfig);
+	Action->AsyncCallback = AsyncCallback;
+	Action->ProgressCallback = ProgressCallback;
+	Action->Activate();
+	return Action;
+}
 
-	TArray<TArray<FString>> Lines;
-	TArray<FString> CurrentLine;
-	FString CurrentString;
+bool UglTFRuntimePointCloudLibrary::StreamPointsFromXYZFile(const FString& Filename, const int64 MemoryBudget, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, ULidarPointCloud* PointCloud, FglTFRuntimePointCloudLoadContext& Context)
+{
+	const FglTFRuntimeASCIIPointCloudConfig& Config = ASCIIPointCloudConfig;
 
-	int64 BinaryIndex = -1;
-	int64 ASCIIIndex = -1;
-	bool bBinaryCompressed = false;
+	glTFRuntimePointCloud::FFileWindow File;
+	if (!PointCloud || !File.Open(Filename))
+	{
+		UE_LOG(LogGLTFRuntime, Error, TEXT("Unable to open XYZ file %s"), *Filename);
+		return false;
+	}
 
-	for (int64 Index = 0; Index < Blob.Num(); Index++)
+	if (Config.LinesToSkip < 0)
 	{
-		const char Char = static_cast<char>(Blob[Index]);
-		if (Char == ' ' || Char == '\t' || Char == '\r' || Char == '\n')
+		return false;
+	}
+
+	const int64 FileSize = File.GetFileSize();
+
+	// windows end after their last newline (a window grows until it contains a whole line), the skipped lines must be in the first one
+	auto ForEachWindow = [&](const int64 WindowSize, TFunctionRef<bool(const uint8* Data, const int64 Begin, const int64 End, const int64 Offset)> Callback) -> bool
 		{
-			if (!CurrentString.IsEmpty())
-			{
-				CurrentLine.Add(CurrentString);
-			}
-			CurrentString = "";
-			if (Char == '\r' || Char == '\n')
+			int64 Offset = 0;
+			int64 Size = WindowSize;
+			while (Offset < FileSize)
 			{
-				if (CurrentLine.Num() > 0)
+				const uint8* Data = File.Map(Offset, Size);
+				if (!Data)
 				{
-					Lines.Add(CurrentLine);
-					if (CurrentLine.Num() >= 2 && CurrentLine[0] == "DATA")
+					UE_LOG(LogGLTFRuntime, Error, TEXT("Unable to read XYZ file %s at offset %lld"), *Filename, Offset);
+					return false;
+				}
+
+				int64 End = Size;
+				if (Offset + Size < FileSize)
+				{
+					while (End > 0 && !glTFRuntimePointCloud::IsNewLine(Data[End - 1]))
 					{
-						ASCIIIndex = Lines.Num();
+						End--;
+					}
 
-						if (CurrentLine[1] != "ascii")
-						{
-							BinaryIndex = Index + 1;
-							bBinaryCompressed = CurrentLine[1] == "binary_compressed";
-							break;
-						}
+					if (End == 0)
+					{
+						Size *= 2;
+						continue;
 					}
 				}
-				CurrentLine.Empty();
+
+				int64 Begin = 0;
+				if (Offset == 0)
+				{
+					Begin = glTFRuntimePointCloud::SkipLines(Data, 0, End, Config.LinesToSkip);
+					if (Begin < 0)
+					{
+						return false;
+					}
+				}
+
+				if (!Callback(Data, Begin, End, Offset) || Context.IsCanceled())
+				{
+					return false;
+				}
+
+				Offset += End;
+				Size = WindowSize;
 			}
-		}
-		else
+			return true;
+		};
+
+	// first pass: lines and bounds, only the location columns are parsed
+	FglTFRuntimeASCIIPointCloudConfig BoundsConfig = Config;
+	BoundsConfig.RGBColumns = FIntVector(-1);
+	BoundsConfig.NormalColumns = FIntVector(-1);
+	BoundsConfig.AlphaColumn = -1;
+	const glTFRuntimePointCloud::FASCIIColumns BoundsColumns(BoundsConfig, {}, {});
+
+	int64 TotalLines = 0;
+	FBox3f Bounds(ForceInit);
+	TArray<glTFRuntimePointCloud::FLineChunk> Chunks;
+
+	const bool bScanned = ForEachWindow(FMath::Max<int64>(MemoryBudget, 1024 * 1024), [&](const uint8* Data, const int64 Begin, const int64 End, const int64 Offset)
 		{
-			CurrentString += Char;
-		}
-	}
+			if (glTFRuntimePointCloud::BuildLineChunks(Data, Begin, End, Chunks, Context, Offset, FileSize) < 0)
+			{
+				return false;
+			}
+
+			TArray<FBox3f> ChunksBounds;
+			ChunksBounds.Init(FBox3f(ForceInit), Chunks.Num());
 
-	if (ASCIIIndex < 0)
+			{
+				GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, LineScan);
+				ParallelFor(Chunks.Num(), [&](const int32 ChunkIndex)
+					{
+						if (Context.IsCanceled())
+						{
+							return;
+						}
+
+						TArray<double, TInlineAllocator<16>> Values;
+						Values.AddZeroed(BoundsColumns.NumSlots);
+
+						glTFRuntimePointCloud::ForEachLine(Data, Begin, End, Chunks[ChunkIndex], [&](const uint8* LineBegin, const uint8* LineEnd)
+							{
+								const int32 NumTokens = BoundsColumns.ParseLine(LineBegin, LineEnd, Values.GetData());
+								ChunksBounds[ChunkIndex] += BoundsColumns.BuildPoint(Values.GetData(), NumTokens).Location;
+							});
+					});
+			}
+
+			for (const glTFRuntimePointCloud::FLineChunk& Chunk : Chunks)
+			{
+				TotalLines += Chunk.NumLines;
+			}
+
+			for (const FBox3f& ChunkBounds : ChunksBounds)
+			{
+				Bounds += ChunkBounds;
+			}
+
+			return true;
+		});
+
+	if (!bScanned)
 	{
-		return nullptr;
+		return false;
 	}
 
-	TMap<FString, TArray<FString>> HeaderFields;
+	Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::LineScan, 1, 1);
 
-	for (int64 Index = 0; Index < ASCIIIndex; Index++)
+	if (TotalLines == 0)
 	{
-		HeaderFields.Add(Lines[Index][0], Lines[Index]);
+		return true;
 	}
 
-	int64 NumberOfFields = 0;
-	FIntVector XYZ = { -1, -1, -1 };
-	int32 RGB = -1;
-	FIntVector NXYZ = { -1, -1, -1 };
+	PointCloud->Initialize(FBox(Bounds));
 
-	int64 Width = 0;
-	int64 Height = 1;
-	int64 NumberOfPoints = 0;
+	// second pass: a window holds its text and the decoded points, both must fit in the budget
+	const int64 BytesPerLine = FMath::Max<int64>(1, FileSize / TotalLines);
+	const int64 WindowSize = FMath::Max<int64>(1024 * 1024, MemoryBudget * BytesPerLine / (BytesPerLine + static_cast<int64>(sizeof(FLidarPointCloudPoint))));
 
-	int64 ChunkSize = 0;
+	const glTFRuntimePointCloud::FASCIIColumns Columns(Config, {}, Context.Config.RangeFilters);
 
-	if (HeaderFields.Contains("FIELDS"))
-	{
-		const TArray<FString>& Fields = HeaderFields["FIELDS"];
-		for (int32 Index = 1; Index < Fields.Num(); Index++)
+	TArray64<FLidarPointCloudPoint> Points;
+	int64 FirstLine = 0;
+	std::atomic<int64> ParsedLines = 0;
+
+	const bool bStreamed = ForEachWindow(WindowSize, [&](const uint8* Data, const int64 Begin, const int64 End, const int64 Offset)
 		{
-			const FString& Field = Fields[Index];
-			if (Field == "x")
+			const int64 NumLines = glTFRuntimePointCloud::BuildLineChunks(Data, Begin, End, Chunks, Context);
+			if (NumLines < 0)
 			{
-				XYZ.X = Index - 1;
+				return false;
 			}
-			else if (Field == "y")
-			{
-				XYZ.Y = Index - 1;
-			}
-			else if (Field == "z")
-			{
-				XYZ.Z = Index - 1;
-			}
-			else if (Field == "rgb")
+
+			Points.Reset();
+			glTFRuntimePointCloud::FPointSink Sink(Points, glTFRuntimePointCloud::MakeWindowConfig(Context.Config, FirstLine, NumLines, TotalLines));
+			if (!Sink.Begin(NumLines))
 			{
-				RGB = Index - 1;
+				return false;
 			}
-			else if (Field == "normal_x")
+
 			{
-				NXYZ.X = Index - 1;
+				GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, Parse);
+				ParallelFor(Chunks.Num(), [&](const int32 ChunkIndex)
+					{
+						if (Context.IsCanceled())
+						{
+							return;
+						}
+
+						const glTFRuntimePointCloud::FLineChunk& Chunk = Chunks[ChunkIndex];
+						int64 LineIndexOffset = Chunk.FirstLine;
+
+						TArray<double, TInlineAllocator<16>> Values;
+						Values.AddZeroed(Columns.NumSlots);
+
+						glTFRuntimePointCloud::FPointSink::FWriter Writer(Sink);
+
+						glTFRuntimePointCloud::ForEachLine(Data, Begin, End, Chunk, [&](const uint8* LineBegin, const uint8* LineEnd)
+							{
+								const int64 LineIndex = LineIndexOffset++;
+								if (!Writer.Accepts(LineIndex))
+								{
+									return;
+								}
+
+								const int32 NumTokens = Columns.ParseLine(LineBegin, LineEnd, Values.GetData());
+
+								if (Sink.HasRanges() && !Writer.AcceptsRanges([&](const int32 RangeIndex) { return Columns.GetRange(Values.GetData(), RangeIndex, NumTokens); }))
+								{
+									return;
+								}
+
+								Writer.Add(LineIndex, Columns.BuildPoint(Values.GetData(), NumTokens));
+							});
+
+						Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, ParsedLines += Chunk.NumLines, TotalLines);
+					});
 			}
-			else if (Field == "normal_y")
+
+			if (!Sink.End(Context))
 			{
-				NXYZ.Y = Index - 1;
+				return false;
 			}
-			else if (Field == "normal_z")
+
 			{
-				NXYZ.Z = Index - 1;
+				GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, OctreeBuild);
+				PointCloud->InsertPoints(Points.GetData(), Points.Num(), ELidarPointCloudDuplicateHandling::Ignore, false, FVector::ZeroVector);
 			}
-		}
 
-		NumberOfFields = Fields.Num() - 1;
+			FirstLine += NumLines;
+			return true;
+		});
+
+	if (!bStreamed)
+	{
+		return false;
 	}
 
-	TMap<int32, int64> BinaryOffsetsMap;
-	TMap<int32, int64> BinarySizeMap;
-	if (HeaderFields.Contains("SIZE"))
+	Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, 1, 1);
+
+	return true;
+}
+
+ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromPCD(UglTFRuntimeAsset* Asset, FTransform& ViewPoint, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	if (!Asset)
 	{
-		const TArray<FString>& Fields = HeaderFields["SIZE"];
-		for (int32 Index = 1; Index < Fields.Num(); Index++)
-		{
-			int64 Size = FCString::Atoi64(*(Fields[Index]));
-			if (HeaderFields.Contains("COUNT"))
-			{
-				const TArray<FString>& CountFields = HeaderFields["COUNT"];
-				if (CountFields.IsValidIndex(Index))
-				{
-					Size *= FCString::Atoi64(*(CountFields[Index]));
-				}
-			}
-			BinaryOffsetsMap.Add(Index - 1, ChunkSize);
-			BinarySizeMap.Add(Index - 1, Size);
-			ChunkSize += Size;
-		}
+		return nullptr;
 	}
 
-	if (HeaderFields.Contains("WIDTH"))
+	FglTFRuntimePointCloudLoadContext Context(PointCloudConfig);
+	TArray64<FLidarPointCloudPoint> Points;
+	if (!LoadPointsFromPCD(Asset->GetParser().ToSharedRef(), ViewPoint, Points, Context))
 	{
-		const TArray<FString>& Fields = HeaderFields["WIDTH"];
-		if (Fields.Num() > 1)
-		{
-			Width = FCString::Atoi64(*(Fields[1]));
-		}
+		return nullptr;
 	}
 
-	if (HeaderFields.Contains("HEIGHT"))
+	return CreatePointCloud(Points, Context);
+}
+
+TArray<ULidarPointCloud*> UglTFRuntimePointCloudLibrary::LoadPointCloudsFromXYZ(UglTFRuntimeAsset* Asset, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	if (!Asset)
 	{
-		const TArray<FString>& Fields = HeaderFields["HEIGHT"];
-		if (Fields.Num() > 1)
-		{
-			Height = FCString::Atoi64(*(Fields[1]));
-		}
+		return {};
+	}
+
+	FglTFRuntimePointCloudLoadContext Context(PointCloudConfig);
+	TArray64<FLidarPointCloudPoint> Points;
+	if (!LoadPointsFromXYZ(Asset->GetParser().ToSharedRef(), nullptr, nullptr, ASCIIPointCloudConfig, Points, Context))
+	{
+		return {};
+	}
+
+	return CreatePointClouds(Points, Context);
+}
+
+TArray<ULidarPointCloud*> UglTFRuntimePointCloudLibrary::LoadPointCloudsFromPCD(UglTFRuntimeAsset* Asset, FTransform& ViewPoint, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	if (!Asset)
+	{
+		return {};
+	}
+
+	FglTFRuntimePointCloudLoadContext Context(PointCloudConfig);
+	TArray64<FLidarPointCloudPoint> Points;
+	if (!LoadPointsFromPCD(Asset->GetParser().ToSharedRef(), ViewPoint, Points, Context))
+	{
+		return {};
+	}
+
+	return CreatePointClouds(Points, Context);
+}
+
+ULidarPointCloud* UglTFRuntimePointCloudLibrary::CreatePointCloud(TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context)
+{
+	if (Context.Config.bSortPoints)
+	{
+		glTFRuntimePointCloud::SortPointsByMortonKey(Points, Context);
+	}
+
+	ULidarPointCloud* PointCloud = nullptr;
+	{
+		GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, OctreeBuild);
+		PointCloud = ULidarPointCloud::CreateFromData(Points, false);
+	}
+
+	Context.LogReport();
+
+	return PointCloud;
+}
+
+TArray<ULidarPointCloud*> UglTFRuntimePointCloudLibrary::CreatePointClouds(TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context)
+{
+	const int64 MaxPointsPerCloud = Context.Config.MaxPointsPerCloud;
+
+	if (MaxPointsPerCloud <= 0 || Points.Num() <= MaxPointsPerCloud)
+	{
+		return { CreatePointCloud(Points, Context) };
 	}
 
-	if (HeaderFields.Contains("POINTS"))
+	if (Context.Config.bSortPoints)
 	{
-		const TArray<FString>& Fields = HeaderFields["POINTS"];
-		if (Fields.Num() > 1)
+		glTFRuntimePointCloud::SortPointsByMortonKey(Points, Context);
+	}
+
+	TArray<ULidarPointCloud*> PointClouds;
+
+	{
+		GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, OctreeBuild);
+
+		// every run is inserted straight from the source array, no per cloud copy is made
+		for (int64 FirstPoint = 0; FirstPoint < Points.Num(); FirstPoint += MaxPointsPerCloud)
 		{
-			NumberOfPoints = FCString::Atoi64(*(Fields[1]));
+			const int64 NumPoints = FMath::Min(MaxPointsPerCloud, Points.Num() - FirstPoint);
+			const FLidarPointCloudPoint* RunPoints = Points.GetData() + FirstPoint;
+
+			FBox3f Bounds(ForceInit);
+			for (int64 PointIndex = 0; PointIndex < NumPoints; PointIndex++)
+			{
+				Bounds += RunPoints[PointIndex].Location;
+			}
+
+			ULidarPointCloud* PointCloud = NewObject<ULidarPointCloud>();
+			PointCloud->Initialize(FBox(Bounds));
+			PointCloud->InsertPoints(RunPoints, NumPoints, ELidarPointCloudDuplicateHandling::Ignore, false, FVector::ZeroVector);
+			PointCloud->RefreshBounds();
+			PointCloud->RefreshRendering();
+			PointClouds.Add(PointCloud);
 		}
 	}
 
-	if (NumberOfPoints < (Width * Height))
+	UE_LOG(LogGLTFRuntime, Log, TEXT("Split %lld points in %d point clouds"), Points.Num(), PointClouds.Num());
+	Context.LogReport();
+
+	return PointClouds;
+}
+
+bool UglTFRuntimePointCloudLibrary::LoadPointsFromPCD(TSharedRef<FglTFRuntimeParser> Parser, FTransform& ViewPoint, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context)
+{
+	const TArray64<uint8>& Blob = Parser->GetBlob();
+
+	glTFRuntimePointCloud::FPCDHeader Header;
+	if (!Header.Parse(Blob))
+	{
+		return false;
+	}
+
+	ViewPoint = Header.ViewPoint;
+
+	const int64 NumberOfPoints = Header.NumberOfPoints;
+	const int64 ChunkSize = Header.PointSize;
+
+	if (Header.DataType == "ascii")
+	{
+		return LoadPointsFromPCDASCII(Blob, Header, Points, Context);
+	}
+
+	const int64 BinaryIndex = Header.DataOffset;
+	const bool bBinaryCompressed = Header.DataType == "binary_compressed";
+
+	if (Header.DataType != "binary" && !bBinaryCompressed)
 	{
-		NumberOfPoints = Width * Height;
+		UE_LOG(LogGLTFRuntime, Error, TEXT("Unsupported PCD DATA type: %s"), *Header.DataType);
+		return false;
 	}
 
-	if (BinaryIndex > -1)
 	{
 		const uint8* DataPtr = Blob.GetData() + BinaryIndex;
 		int64 DataLen = Blob.Num() - BinaryIndex;
 
-		TArray64<uint8> Data2; // just keep it for eventual reordering after decompression
+		// binary_compressed data is decompressed in its field-major layout and decoded from there
+		TArray64<uint8> LZFOutput;
+		bool bFieldMajor = false;
 
 		if (bBinaryCompressed)
 		{
 			if (DataLen < 8)
 			{
-				return nullptr;
+				return false;
 			}
 
 			const uint32* CompressedSize = reinterpret_cast<const uint32*>(DataPtr);
@@ -614,148 +1153,475 @@ ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromPCD(UglTFRunt
 
 			if (*CompressedSize > DataLen - 8)
 			{
-				return nullptr;
+				return false;
 			}
 
-			TArray64<uint8> LZFOutput;
 			LZFOutput.AddUninitialized(*UncompressedSize);
+			Context.Report.BytesAllocated += LZFOutput.Num();
+
+			if (Context.IsCanceled())
+			{
+				return false;
+			}
 
-			DataPtr += 8;
-			int64 InputOffset = 0;
-			int64 OutputOffset = 0;
+			Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Decompress, 0, 1);
 
-			while (InputOffset < *CompressedSize)
 			{
-				uint8 Ctrl = DataPtr[InputOffset++];
-				if (Ctrl < (1 << 5)) // Mode 0
+				GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, Decompress);
+				if (FglTFRuntimePointCloudLZF::Decompress(DataPtr + 8, *CompressedSize, LZFOutput.GetData(), LZFOutput.Num()) != LZFOutput.Num())
 				{
-					Ctrl++;
-					if (OutputOffset + Ctrl > *UncompressedSize)
-					{
-						return nullptr;
-					}
-					if (InputOffset + Ctrl > *CompressedSize)
-					{
-						return nullptr;
-					}
-
-					FMemory::Memcpy(LZFOutput.GetData() + OutputOffset, DataPtr + InputOffset, Ctrl);
-					InputOffset += Ctrl;
-					OutputOffset += Ctrl;
+					UE_LOG(LogGLTFRuntime, Error, TEXT("Unable to decompress PCD binary_compressed data"));
+					return false;
 				}
-				else
-				{
-					uint32 Length = Ctrl >> 5;
-					int32 BackReferenceOffset = OutputOffset - (((uint32)(Ctrl & 0x1f)) << 8) - 1;
+			}
 
-					if (InputOffset >= *CompressedSize)
-					{
-						return nullptr;
-					}
+			Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Decompress, 1, 1);
 
-					if (Length == 7)
-					{
-						Length += DataPtr[InputOffset++];
+			// check decompressed binary size
+			if (LZFOutput.Num() < NumberOfPoints * ChunkSize)
+			{
+				return false;
+			}
 
-						if (InputOffset >= *CompressedSize)
-						{
-							return nullptr;
-						}
-					}
+			DataPtr = LZFOutput.GetData();
+			DataLen = LZFOutput.Num();
+			bFieldMajor = true;
+		}
 
-					BackReferenceOffset -= DataPtr[InputOffset++];
-					if (BackReferenceOffset < 0)
-					{
-						return nullptr;
-					}
+		// check binary size
+		if (DataLen < NumberOfPoints * ChunkSize)
+		{
+			return false;
+		}
 
-					if (OutputOffset + Length + 2 > *UncompressedSize)
-					{
-						return nullptr;
-					}
+		glTFRuntimePointCloud::FPCDDecodePlan DecodePlan;
+		DecodePlan.Compile(Header, bFieldMajor, Context.Config.RangeFilters);
 
-					LZFOutput[OutputOffset++] = LZFOutput[BackReferenceOffset++];
+		glTFRuntimePointCloud::FPointSink Sink(Points, Context.Config);
+		if (!Sink.Begin(NumberOfPoints))
+		{
+			return false;
+		}
 
-					LZFOutput[OutputOffset++] = LZFOutput[BackReferenceOffset++];
+		constexpr int64 PointsPerBlock = 64 * 1024;
+		const int32 NumBlocks = static_cast<int32>((NumberOfPoints + PointsPerBlock - 1) / PointsPerBlock);
+		std::atomic<int64> DecodedPoints = 0;
 
-					while (Length > 0)
+		{
+			GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, Parse);
+			ParallelFor(NumBlocks, [&](const int32 BlockIndex)
+				{
+					if (Context.IsCanceled())
 					{
-						LZFOutput[OutputOffset++] = LZFOutput[BackReferenceOffset++];
-						Length--;
+						return;
 					}
-				}
-			}
 
-			// check decompressed binary size
-			if (LZFOutput.Num() < NumberOfPoints * ChunkSize)
-			{
-				return nullptr;
-			}
+					const int64 FirstPoint = BlockIndex * PointsPerBlock;
+					const int64 LastPoint = FMath::Min(FirstPoint + PointsPerBlock, NumberOfPoints);
 
-			Data2.AddUninitialized(LZFOutput.Num());
+					glTFRuntimePointCloud::FPointSink::FWriter Writer(Sink);
+					glTFRuntimePointCloud::FPointColumns Columns(DecodePlan.Ranges.Num(), 0);
 
-			for (int64 FieldIndex = 0; FieldIndex < NumberOfFields; FieldIndex++)
-			{
-				for (int64 PointIndex = 0; PointIndex < NumberOfPoints; PointIndex++)
-				{
-					const int32 Size = BinarySizeMap[FieldIndex];
-					const int64 SrcOffset = FieldIndex * (Size * NumberOfPoints) + (PointIndex * Size);
-					const int64 DstOffset = PointIndex * ChunkSize + BinaryOffsetsMap[FieldIndex];
-					FMemory::Memcpy(Data2.GetData() + DstOffset, LZFOutput.GetData() + SrcOffset, Size);
-				}
-			}
+					for (int64 PointIndex = FirstPoint; PointIndex < LastPoint;)
+					{
+						PointIndex = Columns.Gather(Writer, 0, PointIndex, LastPoint);
+						DecodePlan.DecodeColumns(DataPtr, Columns);
+						Columns.Flush(Sink, Writer);
+					}
 
-			DataPtr = Data2.GetData();
-			DataLen = Data2.Num();
+					Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, DecodedPoints += LastPoint - FirstPoint, NumberOfPoints);
+				});
 		}
 
-		// check binary size
-		if (DataLen < NumberOfPoints * ChunkSize)
+		if (!Sink.End(Context))
 		{
-			return nullptr;
+			return false;
 		}
+	}
+
+	Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, 1, 1);
+
+	return true;
+}
+
+ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromXYZWithCache(UglTFRuntimeAsset* Asset, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FString& CacheFilename, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	if (!Asset)
+	{
+		return nullptr;
+	}
+
+	FglTFRuntimePointCloudLoadContext Context(PointCloudConfig);
+	TArray64<FLidarPointCloudPoint> Points;
+	if (!LoadPointsFromXYZWithCache(Asset->GetParser().ToSharedRef(), ASCIIPointCloudConfig, CacheFilename, Points, Context))
+	{
+		return nullptr;
+	}
+
+	return CreatePointCloud(Points, Context);
+}
+
+ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromPCDWithCache(UglTFRuntimeAsset* Asset, const FString& CacheFilename, FTransform& ViewPoint, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	if (!Asset)
+	{
+		return nullptr;
+	}
+
+	FglTFRuntimePointCloudLoadContext Context(PointCloudConfig);
+	TArray64<FLidarPointCloudPoint> Points;
+	if (!LoadPointsFromPCDWithCache(Asset->GetParser().ToSharedRef(), CacheFilename, ViewPoint, Points, Context))
+	{
+		return nullptr;
+	}
 
-		// check binary offsets
-		if (BinaryOffsetsMap.Num() != NumberOfFields)
+	return CreatePointCloud(Points, Context);
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudLibrary::LoadPointCloudFromXYZWithCacheAsync(UglTFRuntimeAsset* Asset, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FString& CacheFilename, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback)
+{
+	TSharedPtr<FglTFRuntimeParser> Parser = Asset ? Asset->GetParser() : nullptr;
+	UglTFRuntimePointCloudAsyncAction* Action = UglTFRuntimePointCloudAsyncAction::CreateAction(Asset, PointCloudConfig, [Parser, ASCIIPointCloudConfig, CacheFilename](FglTFRuntimePointCloudLoadContext& Context, TArray64<FLidarPointCloudPoint>& Points)
 		{
-			return nullptr;
-		}
+			return LoadPointsFromXYZWithCache(Parser.ToSharedRef(), ASCIIPointCloudConfig, CacheFilename, Points, Context);
+		});
+	Action->AsyncCallback = AsyncCallback;
+	Action->ProgressCallback = ProgressCallback;
+	Action->Activate();
+	return Action;
+}
 
-		for (int64 Index = 0; Index < NumberOfPoints; Index++)
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudLibrary::LoadPointCloudFromPCDWithCacheAsync(UglTFRuntimeAsset* Asset, const FString& CacheFilename, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback)
+{
+	TSharedPtr<FglTFRuntimeParser> Parser = Asset ? Asset->GetParser() : nullptr;
+	UglTFRuntimePointCloudAsyncAction* Action = UglTFRuntimePointCloudAsyncAction::CreateAction(Asset, PointCloudConfig, [Parser, CacheFilename](FglTFRuntimePointCloudLoadContext& Context, TArray64<FLidarPointCloudPoint>& Points)
 		{
-			FLidarPointCloudPoint Point;
-			const uint8* PointPtr = DataPtr + (Index * ChunkSize);
+			return LoadPointsFromPCDWithCache(Parser.ToSharedRef(), CacheFilename, Context.ViewPoint, Points, Context);
+		});
+	Action->AsyncCallback = AsyncCallback;
+	Action->ProgressCallback = ProgressCallback;
+	Action->Activate();
+	return Action;
+}
 
-			if (XYZ.X > -1)
-			{
-				const float* Ptr = reinterpret_cast<const float*>(PointPtr + BinaryOffsetsMap[XYZ.X]);
-				Point.Location.X = *Ptr;
-			}
-			if (XYZ.Y > -1)
+bool UglTFRuntimePointCloudLibrary::LoadPointsFromXYZWithCache(TSharedRef<FglTFRuntimeParser> Parser, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FString& CacheFilename, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context)
+{
+	TArray<int32> Configuration =
+	{
+		ASCIIPointCloudConfig.XYZColumns.X, ASCIIPointCloudConfig.XYZColumns.Y, ASCIIPointCloudConfig.XYZColumns.Z,
+		ASCIIPointCloudConfig.RGBColumns.X, ASCIIPointCloudConfig.RGBColumns.Y, ASCIIPointCloudConfig.RGBColumns.Z,
+		ASCIIPointCloudConfig.NormalColumns.X, ASCIIPointCloudConfig.NormalColumns.Y, ASCIIPointCloudConfig.NormalColumns.Z,
+		ASCIIPointCloudConfig.AlphaColumn,
+		ASCIIPointCloudConfig.LinesToSkip,
+		ASCIIPointCloudConfig.bFloatColors ? 1 : 0,
+		ASCIIPointCloudConfig.bComputeColumnsMinMax ? 1 : 0
+	};
+	glTFRuntimePointCloud::AppendConfigurationKey(Context.Config, Configuration);
+
+	const uint64 Key = glTFRuntimePointCloud::FPointCache::ComputeKey(Parser->GetBlob(), TEXT("XYZ"), Configuration);
+
+	FTransform ViewPoint;
+	if (glTFRuntimePointCloud::FPointCache::Load(CacheFilename, Key, Points, ViewPoint))
+	{
+		Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, 1, 1);
+		return true;
+	}
+
+	if (!LoadPointsFromXYZ(Parser, nullptr, nullptr, ASCIIPointCloudConfig, Points, Context))
+	{
+		return false;
+	}
+
+	if (!glTFRuntimePointCloud::FPointCache::Save(CacheFilename, Key, Points, FTransform::Identity))
+	{
+		UE_LOG(LogGLTFRuntime, Warning, TEXT("Unable to write point cloud cache %s"), *CacheFilename);
+	}
+
+	return true;
+}
+
+bool UglTFRuntimePointCloudLibrary::LoadPointsFromPCDWithCache(TSharedRef<FglTFRuntimeParser> Parser, const FString& CacheFilename, FTransform& ViewPoint, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context)
+{
+	TArray<int32> Configuration;
+	glTFRuntimePointCloud::AppendConfigurationKey(Context.Config, Configuration);
+
+	const uint64 Key = glTFRuntimePointCloud::FPointCache::ComputeKey(Parser->GetBlob(), TEXT("PCD"), Configuration);
+
+	if (glTFRuntimePointCloud::FPointCache::Load(CacheFilename, Key, Points, ViewPoint))
+	{
+		Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, 1, 1);
+		return true;
+	}
+
+	if (!LoadPointsFromPCD(Parser, ViewPoint, Points, Context))
+	{
+		return false;
+	}
+
+	if (!glTFRuntimePointCloud::FPointCache::Save(CacheFilename, Key, Points, ViewPoint))
+	{
+		UE_LOG(LogGLTFRuntime, Warning, TEXT("Unable to write point cloud cache %s"), *CacheFilename);
+	}
+
+	return true;
+}
+
+bool UglTFRuntimePointCloudLibrary::SavePointCloudToPCD(ULidarPointCloud* PointCloud, const FString& Filename, const bool bBinaryCompressed)
+{
+	if (!PointCloud)
+	{
+		return false;
+	}
+
+	TArray64<FLidarPointCloudPoint> Points;
+	PointCloud->GetPointsAsCopies(Points, true);
+
+	TArray64<uint8> Blob;
+	if (!WritePointsToPCD(Points, bBinaryCompressed, Blob))
+	{
+		return false;
+	}
+
+	return FFileHelper::SaveArrayToFile(Blob, *Filename);
+}
+
+bool UglTFRuntimePointCloudLibrary::WritePointsToPCD(const TArray64<FLidarPointCloudPoint>& Points, const bool bBinaryCompressed, TArray64<uint8>& Blob)
+{
+	// x y z rgba normal_x normal_y normal_z
+	constexpr int64 NumFields = 7;
+	constexpr int64 PointSize = NumFields * sizeof(uint32);
+	const int64 NumberOfPoints = Points.Num();
+
+	const FString Header = FString::Printf(TEXT("# .PCD v0.7 - Point Cloud Data file format\nVERSION 0.7\nFIELDS x y z rgba normal_x normal_y normal_z\nSIZE 4 4 4 4 4 4 4\nTYPE F F F U F F F\nCOUNT 1 1 1 1 1 1 1\nWIDTH %lld\nHEIGHT 1\nVIEWPOINT 0 0 0 1 0 0 0\nPOINTS %lld\nDATA %s\n"),
+		NumberOfPoints, NumberOfPoints, bBinaryCompressed ? TEXT("binary_compressed") : TEXT("binary"));
+
+	FTCHARToUTF8 HeaderUTF8(*Header);
+
+	// binary_compressed stores the fields one after the other (field-major), binary stores whole points
+	TArray64<uint8> Data;
+	Data.AddUninitialized(NumberOfPoints * PointSize);
+
+	const int64 FieldStride = bBinaryCompressed ? sizeof(uint32) : PointSize;
+	const int64 PointStride = bBinaryCompressed ? NumberOfPoints * sizeof(uint32) : sizeof(uint32);
+
+	ParallelFor(static_cast<int32>((NumberOfPoints + 65535) / 65536), [&](const int32 BlockIndex)
+		{
+			const int64 FirstPoint = BlockIndex * 65536LL;
+			const int64 LastPoint = FMath::Min(FirstPoint + 65536, NumberOfPoints);
+
+			for (int64 PointIndex = FirstPoint; PointIndex < LastPoint; PointIndex++)
 			{
-				const float* Ptr = reinterpret_cast<const float*>(PointPtr + BinaryOffsetsMap[XYZ.Y]);
-				Point.Location.Y = *Ptr;
+				const FLidarPointCloudPoint& Point = Points[PointIndex];
+				const FVector3f Normal = Point.Normal.ToVector();
+				const uint32 Packed = (static_cast<uint32>(Point.Color.A) << 24) | (static_cast<uint32>(Point.Color.R) << 16) | (static_cast<uint32>(Point.Color.G) << 8) | Point.Color.B;
+
+				uint8* PointPtr = Data.GetData() + PointIndex * FieldStride;
+				FMemory::Memcpy(PointPtr, &Point.Location.X, sizeof(float));
+				FMemory::Memcpy(PointPtr + PointStride, &Point.Location.Y, sizeof(float));
+				FMemory::Memcpy(PointPtr + PointStride * 2, &Point.Location.Z, sizeof(float));
+				FMemory::Memcpy(PointPtr + PointStride * 3, &Packed, sizeof(uint32));
+				FMemory::Memcpy(PointPtr + PointStride * 4, &Normal.X, sizeof(float));
+				FMemory::Memcpy(PointPtr + PointStride * 5, &Normal.Y, sizeof(float));
+				FMemory::Memcpy(PointPtr + PointStride * 6, &Normal.Z, sizeof(float));
 			}
-			if (XYZ.Z > -1)
+		});
+
+	Blob.Reset();
+	Blob.Append(reinterpret_cast<const uint8*>(HeaderUTF8.Get()), HeaderUTF8.Length());
+
+	if (!bBinaryCompressed)
+	{
+		Blob.Append(Data);
+		return true;
+	}
+
+	TArray64<uint8> Compressed;
+	if (!FglTFRuntimePointCloudLZF::Compress(Data.GetData(), Data.Num(), Compressed) || Compressed.Num() > MAX_uint32 || Data.Num() > MAX_uint32)
+	{
+		UE_LOG(LogGLTFRuntime, Error, TEXT("Unable to compress PCD data"));
+		return false;
+	}
+
+	const uint32 Sizes[2] = { static_cast<uint32>(Compressed.Num()), static_cast<uint32>(Data.Num()) };
+	Blob.Append(reinterpret_cast<const uint8*>(Sizes), sizeof(Sizes));
+	Blob.Append(Compressed);
+
+	return true;
+}
+
+bool UglTFRuntimePointCloudLibrary::LoadPointsFromPCDASCII(const TArray64<uint8>& Blob, const glTFRuntimePointCloud::FPCDHeader& Header, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context)
+{
+	// every used field gets a slot, the matching tokens are the only ones converted
+	enum ESlot
+	{
+		SlotX, SlotY, SlotZ,
+		SlotRGB, SlotRGBA,
+		SlotNX, SlotNY, SlotNZ,
+		SlotIntensity,
+		NumSlots
+	};
+
+	const TCHAR* SlotNames[NumSlots] = { TEXT("x"), TEXT("y"), TEXT("z"), TEXT("rgb"), TEXT("rgba"), TEXT("normal_x"), TEXT("normal_y"), TEXT("normal_z"), TEXT("intensity") };
+
+	int32 SlotFields[NumSlots];
+	TArray<int32> ColumnToSlot;
+	auto MapColumn = [&ColumnToSlot](const int32 Column, const int32 Slot)
+		{
+			while (ColumnToSlot.Num() <= Column)
 			{
-				const float* Ptr = reinterpret_cast<const float*>(PointPtr + BinaryOffsetsMap[XYZ.Z]);
-				Point.Location.Z = *Ptr;
+				ColumnToSlot.Add(-1);
 			}
-			if (RGB > -1)
+			if (ColumnToSlot[Column] < 0)
 			{
-				const uint32* Ptr = reinterpret_cast<const uint32*>(PointPtr + BinaryOffsetsMap[RGB]);
-				Point.Color.R = (*Ptr >> 16) & 0xFF;
-				Point.Color.G = (*Ptr >> 8) & 0xFF;
-				Point.Color.B = (*Ptr) & 0xFF;
+				ColumnToSlot[Column] = Slot;
 			}
+			return ColumnToSlot[Column];
+		};
 
-			Points.Add(MoveTemp(Point));
+	for (int32 Slot = 0; Slot < NumSlots; Slot++)
+	{
+		SlotFields[Slot] = Header.FindField(SlotNames[Slot]);
+		if (SlotFields[Slot] >= 0)
+		{
+			MapColumn(Header.Fields[SlotFields[Slot]].Column, Slot);
 		}
 	}
-	else
+
+	// range filter fields get the slots after the fixed ones (or share them), missing fields have no slot
+	TArray<int32> RangeSlots;
+	int32 NumUsedSlots = NumSlots;
+	for (const FglTFRuntimePointCloudRangeFilter& RangeFilter : Context.Config.RangeFilters)
 	{
+		const int32 FieldIndex = Header.FindField(*RangeFilter.Field);
+		RangeSlots.Add(FieldIndex >= 0 ? MapColumn(Header.Fields[FieldIndex].Column, NumUsedSlots) : -1);
+		if (RangeSlots.Last() == NumUsedSlots)
+		{
+			NumUsedSlots++;
+		}
+	}
 
+	TArray<glTFRuntimePointCloud::FLineChunk> Chunks;
+	const int64 TotalLines = glTFRuntimePointCloud::BuildLineChunks(Blob.GetData(), Header.DataOffset, Blob.Num(), Chunks, Context);
+	if (TotalLines < 0)
+	{
+		return false;
+	}
+
+	Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::LineScan, 1, 1);
+
+	glTFRuntimePointCloud::FPointSink Sink(Points, Context.Config);
+	if (!Sink.Begin(TotalLines))
+	{
+		return false;
+	}
+
+	const bool bHasNormals = SlotFields[SlotNX] >= 0 || SlotFields[SlotNY] >= 0 || SlotFields[SlotNZ] >= 0;
+
+	std::atomic<int64> ParsedLines = 0;
+
+	{
+		GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, Parse);
+		ParallelFor(Chunks.Num(), [&](const int32 ChunkIndex)
+			{
+				if (Context.IsCanceled())
+				{
+					return;
+				}
+
+				const glTFRuntimePointCloud::FLineChunk& Chunk = Chunks[ChunkIndex];
+				int64 PointIndexOffset = Chunk.FirstLine;
+
+				TArray<const uint8*, TInlineAllocator<NumSlots * 2>> TokenBegins;
+				TArray<const uint8*, TInlineAllocator<NumSlots * 2>> TokenEnds;
+				TokenBegins.AddUninitialized(NumUsedSlots);
+				TokenEnds.AddUninitialized(NumUsedSlots);
+
+				glTFRuntimePointCloud::FPointSink::FWriter Writer(Sink);
+
+				glTFRuntimePointCloud::ForEachLine(Blob.GetData(), Header.DataOffset, Blob.Num(), Chunk, [&](const uint8* LineBegin, const uint8* LineEnd)
+					{
+						const int64 PointIndex = PointIndexOffset++;
+						if (!Writer.Accepts(PointIndex))
+						{
+							return;
+						}
+
+						FMemory::Memzero(TokenBegins.GetData(), NumUsedSlots * sizeof(const uint8*));
+
+						glTFRuntimePointCloud::ForEachToken(LineBegin, LineEnd, ColumnToSlot.Num(), [&](const int32 TokenIndex, const uint8* TokenBegin, const uint8* TokenEnd)
+							{
+								const int32 Slot = ColumnToSlot[TokenIndex];
+								if (Slot >= 0)
+								{
+									TokenBegins[Slot] = TokenBegin;
+									TokenEnds[Slot] = TokenEnd;
+								}
+							});
+
+						auto GetValue = [&](const int32 Slot)
+							{
+								return glTFRuntimePointCloud::TokenToDouble(TokenBegins[Slot], TokenEnds[Slot]);
+							};
+
+						if (Sink.HasRanges() && !Writer.AcceptsRanges([&](const int32 RangeIndex) { return RangeSlots[RangeIndex] >= 0 && TokenBegins[RangeSlots[RangeIndex]] ? GetValue(RangeSlots[RangeIndex]) : 0.0; }))
+						{
+							return;
+						}
+
+						FLidarPointCloudPoint Point;
+
+						if (TokenBegins[SlotX])
+						{
+							Point.Location.X = GetValue(SlotX);
+						}
+						if (TokenBegins[SlotY])
+						{
+							Point.Location.Y = GetValue(SlotY);
+						}
+						if (TokenBegins[SlotZ])
+						{
+							Point.Location.Z = GetValue(SlotZ);
+						}
+
+						if (TokenBegins[SlotRGBA])
+						{
+							const uint32 Packed = glTFRuntimePointCloud::ParsePCDPackedColor(TokenBegins[SlotRGBA], TokenEnds[SlotRGBA]);
+							Point.Color = FColor((Packed >> 16) & 0xFF, (Packed >> 8) & 0xFF, Packed & 0xFF, (Packed >> 24) & 0xFF);
+						}
+						else
+						{
+							if (TokenBegins[SlotRGB])
+							{
+								const uint32 Packed = glTFRuntimePointCloud::ParsePCDPackedColor(TokenBegins[SlotRGB], TokenEnds[SlotRGB]);
+								Point.Color.R = (Packed >> 16) & 0xFF;
+								Point.Color.G = (Packed >> 8) & 0xFF;
+								Point.Color.B = Packed & 0xFF;
+							}
+
+							if (TokenBegins[SlotIntensity])
+							{
+								Point.Color.A = glTFRuntimePointCloud::PCDIntensityToAlpha(GetValue(SlotIntensity), Header.Fields[SlotFields[SlotIntensity]]);
+							}
+						}
+
+						if (bHasNormals)
+						{
+							Point.Normal = FVector3f(TokenBegins[SlotNX] ? GetValue(SlotNX) : 0, TokenBegins[SlotNY] ? GetValue(SlotNY) : 0, TokenBegins[SlotNZ] ? GetValue(SlotNZ) : 0);
+						}
+
+						Writer.Add(PointIndex, Point);
+					});
+
+				Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, ParsedLines += Chunk.NumLines, TotalLines);
+			});
+	}
+
+	if (!Sink.End(Context))
+	{
+		return false;
 	}
 
-	return ULidarPointCloud::CreateFromData(Points, false);
+	Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, 1, 1);
+
+	return true;
 }
\ No newline at end of file
@@ -0,0 +1,689 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "glTFRuntimeParser.h"
+#include "Async/ParallelFor.h"
+#include "glTFRuntimePointCloudColor.h"
+#include "glTFRuntimePointCloudColumns.h"
+#include "glTFRuntimePointCloudLibrary.h"
+#include "glTFRuntimePointCloudMeshopt.h"
+#include <atomic>
+#include "LidarPointCloudShared.h"
+#include "Templates/IsIntegral.h"
+#include "Templates/IsSigned.h"
+
+namespace glTFRuntimePointCloud
+{
+	namespace EAccessorComponentType
+	{
+		enum Type : int64
+		{
+			Byte = 5120,
+			UnsignedByte = 5121,
+			Short = 5122,
+			UnsignedShort = 5123,
+			UnsignedInt = 5125,
+			Float = 5126
+		};
+	}
+
+	/* glTF to Unreal conversion (scene basis and scale) as axes, so the parser is not invoked per point */
+	struct FPointBasis
+	{
+		FVector3f Origin;
+		FVector3f Axes[3];
+		FVector3f NormalAxes[3];
+
+		void Init(FglTFRuntimeParser& Parser)
+		{
+			const FVector UnitAxes[3] = { FVector(1, 0, 0), FVector(0, 1, 0), FVector(0, 0, 1) };
+			const FVector ParserOrigin = Parser.TransformPosition(FVector::ZeroVector);
+			Origin = FVector3f(ParserOrigin);
+			for (int32 Axis = 0; Axis < 3; Axis++)
+			{
+				Axes[Axis] = FVector3f(Parser.TransformPosition(UnitAxes[Axis]) - ParserOrigin);
+				NormalAxes[Axis] = FVector3f(Parser.TransformVector(UnitAxes[Axis]));
+			}
+		}
+
+		FORCEINLINE FVector3f TransformPosition(const float* Values) const
+		{
+			return Origin + Axes[0] * Values[0] + Axes[1] * Values[1] + Axes[2] * Values[2];
+		}
+
+		FORCEINLINE FVector3f TransformNormal(const float* Values) const
+		{
+			return NormalAxes[0] * Values[0] + NormalAxes[1] * Values[1] + NormalAxes[2] * Values[2];
+		}
+	};
+
+	/* EXT_meshopt_compression buffer views, decoded (in parallel) before the points */
+	class FMeshoptBufferViews
+	{
+	public:
+		/* Returns the (not yet decoded) storage of the buffer view, nullptr when the view uses an unsupported mode/filter */
+		const TArray64<uint8>* Add(FglTFRuntimeParser& Parser, const int32 BufferViewIndex, TSharedRef<FJsonObject> JsonMeshoptObject, int64& Stride)
+		{
+			if (const FBufferView* BufferView = BufferViews.Find(BufferViewIndex))
+			{
+				Stride = BufferView->Stride;
+				return BufferView->Data.Get();
+			}
+
+			FString Mode;
+			FString Filter = TEXT("NONE");
+			JsonMeshoptObject->TryGetStringField(TEXT("mode"), Mode);
+			JsonMeshoptObject->TryGetStringField(TEXT("filter"), Filter);
+			if (Mode != "ATTRIBUTES" || (Filter != "NONE" && Filter != "OCTAHEDRAL" && Filter != "EXPONENTIAL"))
+			{
+				return nullptr;
+			}
+
+			const int64 BufferIndex = static_cast<int64>(Parser.GetJsonObjectNumber(JsonMeshoptObject, "buffer", INDEX_NONE));
+			const int64 ByteOffset = static_cast<int64>(Parser.GetJsonObjectNumber(JsonMeshoptObject, "byteOffset", 0));
+			const int64 ByteLength = static_cast<int64>(Parser.GetJsonObjectNumber(JsonMeshoptObject, "byteLength", 0));
+
+			FBufferView BufferView;
+			BufferView.Stride = static_cast<int64>(Parser.GetJsonObjectNumber(JsonMeshoptObject, "byteStride", 0));
+			BufferView.Count = static_cast<int64>(Parser.GetJsonObjectNumber(JsonMeshoptObject, "count", 0));
+			BufferView.Filter = Filter;
+
+			FglTFRuntimeBlob Blob;
+			if (BufferIndex < 0 || !Parser.GetBuffer(static_cast<int32>(BufferIndex), Blob) || ByteOffset < 0 || ByteLength <= 0 || ByteOffset + ByteLength > Blob.Num)
+			{
+				return nullptr;
+			}
+
+			if (BufferView.Stride <= 0 || BufferView.Stride > 256 || BufferView.Stride % 4 != 0 || BufferView.Count < 0)
+			{
+				return nullptr;
+			}
+
+			if (Filter == "OCTAHEDRAL" && BufferView.Stride != 4 && BufferView.Stride != 8)
+			{
+				return nullptr;
+			}
+
+			// the decoded size comes from the json: it must match the parent buffer view and what the compressed data can encode
+			// (every 16 bytes group costs at least 2 header bits, so a byte of compressed data never decodes to more than 64 bytes)
+			TSharedPtr<FJsonObject> JsonBufferViewObject = Parser.GetJsonObjectFromRootIndex("bufferViews", BufferViewIndex);
+			const int64 DecodedSize = JsonBufferViewObject ? static_cast<int64>(Parser.GetJsonObjectNumber(JsonBufferViewObject.ToSharedRef(), "byteLength", 0)) : 0;
+			if (BufferView.Count > DecodedSize / BufferView.Stride || BufferView.Count * BufferView.Stride != DecodedSize || DecodedSize > ByteLength * 64)
+			{
+				return nullptr;
+			}
+
+			BufferView.Compressed = Blob.Data + ByteOffset;
+			BufferView.CompressedSize = ByteLength;
+			BufferView.Data = MakeUnique<TArray64<uint8>>();
+			BufferView.Data->AddUninitialized(BufferView.Count * BufferView.Stride);
+
+			Stride = BufferView.Stride;
+			return BufferViews.Add(BufferViewIndex, MoveTemp(BufferView)).Data.Get();
+		}
+
+		bool Decode()
+		{
+			TArray<FBufferView*> PendingBufferViews;
+			for (TPair<int32, FBufferView>& Pair : BufferViews)
+			{
+				if (!Pair.Value.bDecoded)
+				{
+					PendingBufferViews.Add(&Pair.Value);
+				}
+			}
+
+			std::atomic<bool> bSuccess = true;
+			ParallelFor(PendingBufferViews.Num(), [&](const int32 Index)
+				{
+					FBufferView& BufferView = *PendingBufferViews[Index];
+					uint8* Data = BufferView.Data->GetData();
+					if (!Meshopt::DecodeVertexBuffer(Data, BufferView.Count, BufferView.Stride, BufferView.Compressed, BufferView.CompressedSize))
+					{
+						bSuccess = false;
+						return;
+					}
+
+					if (BufferView.Filter == "OCTAHEDRAL")
+					{
+						if (BufferView.Stride == 4)
+						{
+							Meshopt::DecodeFilterOctahedral(reinterpret_cast<int8*>(Data), BufferView.Count);
+						}
+						else
+						{
+							Meshopt::DecodeFilterOctahedral(reinterpret_cast<int16*>(Data), BufferView.Count);
+						}
+					}
+					else if (BufferView.Filter == "EXPONENTIAL")
+					{
+						Meshopt::DecodeFilterExponential(Data, BufferView.Count * BufferView.Stride / 4);
+					}
+
+					BufferView.bDecoded = true;
+				});
+
+			return bSuccess;
+		}
+
+	private:
+		struct FBufferView
+		{
+			const uint8* Compressed = nullptr;
+			int64 CompressedSize = 0;
+			int64 Stride = 0;
+			int64 Count = 0;
+			FString Filter;
+			// stable address, accessors point into it before decoding
+			TUniquePtr<TArray64<uint8>> Data;
+			bool bDecoded = false;
+		};
+
+		TMap<int32, FBufferView> BufferViews;
+	};
+
+	/* Raw view of a glTF accessor inside its buffer view (dequantized on read) */
+	struct FAccessorView
+	{
+		const uint8* Data = nullptr;
+		int64 Stride = 0;
+		int64 Count = 0;
+		int64 Elements = 0;
+		int64 ComponentType = 0;
+		bool bNormalized = false;
+		float Scale = 1;
+
+		bool IsValid() const
+		{
+			return Data != nullptr;
+		}
+
+		bool Init(FglTFRuntimeParser& Parser, const int64 AccessorIndex, FMeshoptBufferViews& MeshoptBufferViews)
+		{
+			TSharedPtr<FJsonObject> JsonAccessorObject = Parser.GetJsonObjectFromRootIndex("accessors", static_cast<int32>(AccessorIndex));
+			// sparse accessors need to be resolved by the parser
+			if (!JsonAccessorObject || JsonAccessorObject->HasField(TEXT("sparse")))
+			{
+				return false;
+			}
+
+			int64 ElementSize = 0;
+			int64 DataSize = 0;
+
+			const int64 BufferViewIndex = static_cast<int64>(Parser.GetJsonObjectNumber(JsonAccessorObject.ToSharedRef(), "bufferView", INDEX_NONE));
+			TSharedPtr<FJsonObject> JsonMeshoptObject = GetMeshoptObject(Parser, BufferViewIndex);
+			if (JsonMeshoptObject)
+			{
+				const TArray64<uint8>* BufferViewData = MeshoptBufferViews.Add(Parser, BufferViewIndex, JsonMeshoptObject.ToSharedRef(), Stride);
+				if (!BufferViewData)
+				{
+					return false;
+				}
+
+				const int64 ByteOffset = static_cast<int64>(Parser.GetJsonObjectNumber(JsonAccessorObject.ToSharedRef(), "byteOffset", 0));
+				ComponentType = static_cast<int64>(Parser.GetJsonObjectNumber(JsonAccessorObject.ToSharedRef(), "componentType", 0));
+				Count = static_cast<int64>(Parser.GetJsonObjectNumber(JsonAccessorObject.ToSharedRef(), "count", 0));
+				bNormalized = JsonAccessorObject->HasField(TEXT("normalized")) && JsonAccessorObject->GetBoolField(TEXT("normalized"));
+				ElementSize = GetComponentSize(ComponentType);
+
+				FString Type;
+				JsonAccessorObject->TryGetStringField(TEXT("type"), Type);
+				Elements = Type == "SCALAR" ? 1 : Type == "VEC2" ? 2 : Type == "VEC3" ? 3 : Type == "VEC4" ? 4 : 0;
+
+				if (ElementSize <= 0 || Elements <= 0 || ByteOffset < 0 || ByteOffset > BufferViewData->Num())
+				{
+					return false;
+				}
+
+				Data = BufferViewData->GetData() + ByteOffset;
+				DataSize = BufferViewData->Num() - ByteOffset;
+			}
+			else
+			{
+				FglTFRuntimeBlob Blob;
+				if (!Parser.GetAccessor(static_cast<int32>(AccessorIndex), ComponentType, Stride, Elements, ElementSize, Count, bNormalized, Blob, nullptr))
+				{
+					return false;
+				}
+
+				Data = Blob.Data;
+				DataSize = Blob.Num;
+			}
+
+			if (Count > 0 && (Stride <= 0 || (Count - 1) * Stride + Elements * ElementSize > DataSize))
+			{
+				Data = nullptr;
+				return false;
+			}
+
+			// KHR_mesh_quantization: normalized integers map to [0, 1] or [-1, 1], the others keep their value
+			Scale = 1;
+			if (bNormalized)
+			{
+				switch (ComponentType)
+				{
+				case EAccessorComponentType::Byte:
+					Scale = 1.0f / 127.0f;
+					break;
+				case EAccessorComponentType::UnsignedByte:
+					Scale = 1.0f / 255.0f;
+					break;
+				case EAccessorComponentType::Short:
+					Scale = 1.0f / 32767.0f;
+					break;
+				case EAccessorComponentType::UnsignedShort:
+					Scale = 1.0f / 65535.0f;
+					break;
+				default:
+					break;
+				}
+			}
+
+			return true;
+		}
+
+		bool IsFloatOrQuantized(const bool bAllowUnnormalized) const
+		{
+			switch (ComponentType)
+			{
+			case EAccessorComponentType::Float:
+				return true;
+			case EAccessorComponentType::Byte:
+			case EAccessorComponentType::UnsignedByte:
+			case EAccessorComponentType::Short:
+			case EAccessorComponentType::UnsignedShort:
+				return bNormalized || bAllowUnnormalized;
+			default:
+				return false;
+			}
+		}
+
+		static int64 GetComponentSize(const int64 InComponentType)
+		{
+			switch (InComponentType)
+			{
+			case EAccessorComponentType::Byte:
+			case EAccessorComponentType::UnsignedByte:
+				return 1;
+			case EAccessorComponentType::Short:
+			case EAccessorComponentType::UnsignedShort:
+				return 2;
+			case EAccessorComponentType::UnsignedInt:
+			case EAccessorComponentType::Float:
+				return 4;
+			default:
+				return 0;
+			}
+		}
+
+		static TSharedPtr<FJsonObject> GetMeshoptObject(FglTFRuntimeParser& Parser, const int64 BufferViewIndex)
+		{
+			TSharedPtr<FJsonObject> JsonBufferViewObject = BufferViewIndex >= 0 ? Parser.GetJsonObjectFromRootIndex("bufferViews", static_cast<int32>(BufferViewIndex)) : nullptr;
+			const TSharedPtr<FJsonObject>* JsonExtensionsObject = nullptr;
+			if (!JsonBufferViewObject || !JsonBufferViewObject->TryGetObjectField(TEXT("extensions"), JsonExtensionsObject))
+			{
+				return nullptr;
+			}
+
+			const TSharedPtr<FJsonObject>* JsonMeshoptObject = nullptr;
+			if (!(*JsonExtensionsObject)->TryGetObjectField(TEXT("EXT_meshopt_compression"), JsonMeshoptObject))
+			{
+				return nullptr;
+			}
+
+			return *JsonMeshoptObject;
+		}
+
+		template<typename T>
+		FORCEINLINE T GetComponent(const int64 Index, const int64 Component) const
+		{
+			T Value;
+			FMemory::Memcpy(&Value, Data + Index * Stride + Component * sizeof(T), sizeof(T));
+			return Value;
+		}
+
+		FORCEINLINE uint32 GetIndex(const int64 Index) const
+		{
+			switch (ComponentType)
+			{
+			case EAccessorComponentType::UnsignedByte:
+				return Data[Index * Stride];
+			case EAccessorComponentType::UnsignedShort:
+				return GetComponent<uint16>(Index, 0);
+			default:
+				return GetComponent<uint32>(Index, 0);
+			}
+		}
+
+		/* Dequantization is fused with the read: one switch per element, then a tight per component loop */
+		FORCEINLINE void GetFloats(const int64 Index, float* Values) const
+		{
+			switch (ComponentType)
+			{
+			case EAccessorComponentType::Byte:
+				ReadComponents<int8>(Index, Values);
+				break;
+			case EAccessorComponentType::UnsignedByte:
+				ReadComponents<uint8>(Index, Values);
+				break;
+			case EAccessorComponentType::Short:
+				ReadComponents<int16>(Index, Values);
+				break;
+			case EAccessorComponentType::UnsignedShort:
+				ReadComponents<uint16>(Index, Values);
+				break;
+			default:
+				ReadComponents<float>(Index, Values);
+				break;
+			}
+		}
+
+		/* Column version of GetFloats: component C of element Indices[Index] goes to Columns[C][Index] */
+		void GetFloatColumns(const int64* Indices, const int32 Num, float* const* Columns) const
+		{
+			switch (ComponentType)
+			{
+			case EAccessorComponentType::Byte:
+				ReadColumns<int8>(Indices, Num, Columns);
+				break;
+			case EAccessorComponentType::UnsignedByte:
+				ReadColumns<uint8>(Indices, Num, Columns);
+				break;
+			case EAccessorComponentType::Short:
+				ReadColumns<int16>(Indices, Num, Columns);
+				break;
+			case EAccessorComponentType::UnsignedShort:
+				ReadColumns<uint16>(Indices, Num, Columns);
+				break;
+			default:
+				ReadColumns<float>(Indices, Num, Columns);
+				break;
+			}
+		}
+
+	private:
+		/* signed normalized values are clamped to -1 (-128 and -127 both map to -1), the lowest float leaves the others untouched */
+		FORCEINLINE float GetMinValue() const
+		{
+			return bNormalized ? -1.0f : TNumericLimits<float>::Lowest();
+		}
+
+		template<typename T>
+		void ReadColumns(const int64* Indices, const int32 Num, float* const* Columns) const
+		{
+			const float MinValue = GetMinValue();
+			for (int64 Component = 0; Component < Elements; Component++)
+			{
+				const uint8* Base = Data + Component * sizeof(T);
+				float* Column = Columns[Component];
+				for (int32 Index = 0; Index < Num; Index++)
+				{
+					T Value;
+					FMemory::Memcpy(&Value, Base + Indices[Index] * Stride, sizeof(T));
+					if constexpr (TIsIntegral<T>::Value && TIsSigned<T>::Value)
+					{
+						Column[Index] = FMath::Max(static_cast<float>(Value) * Scale, MinValue);
+					}
+					else
+					{
+						Column[Index] = static_cast<float>(Value) * Scale;
+					}
+				}
+			}
+		}
+
+		template<typename T>
+		FORCEINLINE void ReadComponents(const int64 Index, float* Values) const
+		{
+			const float MinValue = GetMinValue();
+			T Components[4];
+			FMemory::Memcpy(Components, Data + Index * Stride, sizeof(T) * Elements);
+			for (int64 Component = 0; Component < Elements; Component++)
+			{
+				if constexpr (TIsIntegral<T>::Value && TIsSigned<T>::Value)
+				{
+					Values[Component] = FMath::Max(static_cast<float>(Components[Component]) * Scale, MinValue);
+				}
+				else
+				{
+					Values[Component] = static_cast<float>(Components[Component]) * Scale;
+				}
+			}
+		}
+	};
+
+	/* Validated accessors of a mode 0 primitive, decoded straight into FLidarPointCloudPoint (or a column at a time when not indexed) */
+	struct FPointPrimitive
+	{
+		FAccessorView Position;
+		FAccessorView Color;
+		FAccessorView Normal;
+		FAccessorView Indices;
+		/* sources of the range filters, missing attributes are 0 */
+		TArray<FAccessorView> Ranges;
+
+		int64 NumPoints = 0;
+
+		bool Init(FglTFRuntimeParser& Parser, TSharedRef<FJsonObject> JsonPrimitiveObject, FMeshoptBufferViews& MeshoptBufferViews, const TArray<FglTFRuntimePointCloudRangeFilter>& RangeFilters)
+		{
+			// compressed primitives (e.g. KHR_draco_mesh_compression) are left to the parser
+			if (JsonPrimitiveObject->HasField(TEXT("extensions")))
+			{
+				return false;
+			}
+
+			const TSharedPtr<FJsonObject>* JsonAttributesObject = nullptr;
+			if (!JsonPrimitiveObject->TryGetObjectField(TEXT("attributes"), JsonAttributesObject))
+			{
+				return false;
+			}
+
+			int64 AccessorIndex = INDEX_NONE;
+			if (!(*JsonAttributesObject)->TryGetNumberField(TEXT("POSITION"), AccessorIndex) || !Position.Init(Parser, AccessorIndex, MeshoptBufferViews))
+			{
+				return false;
+			}
+
+			// quantized positions may be unnormalized (the dequantization transform lives in the nodes, like for the parser path)
+			if (!Position.IsFloatOrQuantized(true) || Position.Elements != 3)
+			{
+				return false;
+			}
+
+			if ((*JsonAttributesObject)->TryGetNumberField(TEXT("COLOR_0"), AccessorIndex))
+			{
+				if (!Color.Init(Parser, AccessorIndex, MeshoptBufferViews) || Color.Count < Position.Count || (Color.Elements != 3 && Color.Elements != 4))
+				{
+					return false;
+				}
+
+				if (Color.ComponentType != EAccessorComponentType::Float && !((Color.ComponentType == EAccessorComponentType::UnsignedByte || Color.ComponentType == EAccessorComponentType::UnsignedShort) && Color.bNormalized))
+				{
+					return false;
+				}
+			}
+
+			if ((*JsonAttributesObject)->TryGetNumberField(TEXT("NORMAL"), AccessorIndex))
+			{
+				if (!Normal.Init(Parser, AccessorIndex, MeshoptBufferViews) || Normal.Count < Position.Count || Normal.Elements != 3)
+				{
+					return false;
+				}
+
+				if (!Normal.IsFloatOrQuantized(false) || Normal.ComponentType == EAccessorComponentType::UnsignedByte || Normal.ComponentType == EAccessorComponentType::UnsignedShort)
+				{
+					return false;
+				}
+			}
+
+			for (const FglTFRuntimePointCloudRangeFilter& RangeFilter : RangeFilters)
+			{
+				FAccessorView& Range = Ranges.AddDefaulted_GetRef();
+				if ((*JsonAttributesObject)->TryGetNumberField(RangeFilter.Field, AccessorIndex))
+				{
+					if (!Range.Init(Parser, AccessorIndex, MeshoptBufferViews) || !Range.IsFloatOrQuantized(true))
+					{
+						return false;
+					}
+				}
+			}
+
+			NumPoints = Position.Count;
+
+			if (JsonPrimitiveObject->TryGetNumberField(TEXT("indices"), AccessorIndex))
+			{
+				if (!Indices.Init(Parser, AccessorIndex, MeshoptBufferViews) || Indices.Elements != 1)
+				{
+					return false;
+				}
+
+				if (Indices.ComponentType != EAccessorComponentType::UnsignedByte && Indices.ComponentType != EAccessorComponentType::UnsignedShort && Indices.ComponentType != EAccessorComponentType::UnsignedInt)
+				{
+					return false;
+				}
+
+				NumPoints = Indices.Count;
+			}
+
+			return true;
+		}
+
+		FORCEINLINE double GetRange(const int64 PointIndex, const int32 RangeIndex) const
+		{
+			const FAccessorView& Range = Ranges[RangeIndex];
+			const int64 VertexIndex = Indices.IsValid() ? Indices.GetIndex(PointIndex) : PointIndex;
+			if (!Range.IsValid() || VertexIndex >= Range.Count)
+			{
+				return 0;
+			}
+
+			float Values[4];
+			Range.GetFloats(VertexIndex, Values);
+			return Values[0];
+		}
+
+		bool CanDecodeColumns() const
+		{
+			return !Indices.IsValid();
+		}
+
+		/* Decodes the points staged in Columns (see CanDecodeColumns), uses 4 scratch columns */
+		void DecodeColumns(const FPointBasis& Basis, FPointColumns& Columns) const
+		{
+			const int64* PointIndices = Columns.Indices.GetData();
+			const int32 Num = Columns.Num;
+
+			float* const PositionColumns[3] = { Columns.X.GetData(), Columns.Y.GetData(), Columns.Z.GetData() };
+			Position.GetFloatColumns(PointIndices, Num, PositionColumns);
+			for (int32 Index = 0; Index < Num; Index++)
+			{
+				const float Values[3] = { PositionColumns[0][Index], PositionColumns[1][Index], PositionColumns[2][Index] };
+				const FVector3f Location = Basis.TransformPosition(Values);
+				PositionColumns[0][Index] = Location.X;
+				PositionColumns[1][Index] = Location.Y;
+				PositionColumns[2][Index] = Location.Z;
+			}
+
+			Columns.bHasColors = Color.IsValid();
+			if (Columns.bHasColors)
+			{
+				float* const ColorColumns[4] = { Columns.GetScratch(0), Columns.GetScratch(1), Columns.GetScratch(2), Columns.GetScratch(3) };
+				if (Color.Elements < 4)
+				{
+					for (int32 Index = 0; Index < Num; Index++)
+					{
+						ColorColumns[3][Index] = 1;
+					}
+				}
+				Color.GetFloatColumns(PointIndices, Num, ColorColumns);
+				for (int32 Index = 0; Index < Num; Index++)
+				{
+					Columns.Colors[Index] = LinearToSRGBColor(ColorColumns[0][Index], ColorColumns[1][Index], ColorColumns[2][Index], ColorColumns[3][Index]);
+				}
+			}
+
+			Columns.bHasNormals = Normal.IsValid();
+			if (Columns.bHasNormals)
+			{
+				float* const NormalColumns[3] = { Columns.NX.GetData(), Columns.NY.GetData(), Columns.NZ.GetData() };
+				Normal.GetFloatColumns(PointIndices, Num, NormalColumns);
+				for (int32 Index = 0; Index < Num; Index++)
+				{
+					const float Values[3] = { NormalColumns[0][Index], NormalColumns[1][Index], NormalColumns[2][Index] };
+					const FVector3f Direction = Basis.TransformNormal(Values);
+					NormalColumns[0][Index] = Direction.X;
+					NormalColumns[1][Index] = Direction.Y;
+					NormalColumns[2][Index] = Direction.Z;
+				}
+			}
+
+			// range sources may be shorter than the positions
+			for (int32 RangeIndex = 0; RangeIndex < Ranges.Num(); RangeIndex++)
+			{
+				double* Extra = Columns.GetExtra(RangeIndex);
+				for (int32 Index = 0; Index < Num; Index++)
+				{
+					Extra[Index] = GetRange(PointIndices[Index], RangeIndex);
+				}
+			}
+		}
+
+		/* Out of range indices produce default points (like the parser based path) */
+		void Decode(const FPointBasis& Basis, const int64 FirstPoint, const int64 LastPoint, FLidarPointCloudPoint* Points) const
+		{
+			for (int64 PointIndex = FirstPoint; PointIndex < LastPoint; PointIndex++)
+			{
+				FLidarPointCloudPoint& Point = Points[PointIndex - FirstPoint];
+				Point = FLidarPointCloudPoint();
+
+				const int64 VertexIndex = Indices.IsValid() ? Indices.GetIndex(PointIndex) : PointIndex;
+				if (VertexIndex >= Position.Count)
+				{
+					continue;
+				}
+
+				float Values[4];
+				Position.GetFloats(VertexIndex, Values);
+				Point.Location = Basis.TransformPosition(Values);
+
+				if (Color.IsValid())
+				{
+					Values[3] = 1;
+					Color.GetFloats(VertexIndex, Values);
+					Point.Color = LinearToSRGBColor(Values[0], Values[1], Values[2], Values[3]);
+				}
+
+				if (Normal.IsValid())
+				{
+					Normal.GetFloats(VertexIndex, Values);
+					Point.Normal = Basis.TransformNormal(Values);
+				}
+			}
+		}
+	};
+	/* Same as FPointPrimitive::Decode for primitives loaded by the parser (the fallback path) */
+	inline void DecodeParserPrimitive(const FglTFRuntimePrimitive& Primitive, const int64 FirstPoint, const int64 LastPoint, FLidarPointCloudPoint* Points)
+	{
+		for (int64 PointIndex = FirstPoint; PointIndex < LastPoint; PointIndex++)
+		{
+			FLidarPointCloudPoint& Point = Points[PointIndex - FirstPoint];
+			Point = FLidarPointCloudPoint();
+
+			const uint32 Index = Primitive.Indices[PointIndex];
+			if (Primitive.Positions.IsValidIndex(Index))
+			{
+				Point.Location = FVector3f(Primitive.Positions[Index]);
+			}
+			if (Primitive.Colors.IsValidIndex(Index))
+			{
+				Point.Color = LinearToSRGBColor(Primitive.Colors[Index]);
+			}
+			if (Primitive.Normals.IsValidIndex(Index))
+			{
+				Point.Normal = FVector3f(Primitive.Normals[Index]);
+			}
+		}
+	}
+}
@@ -0,0 +1,209 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+ * EXT_meshopt_compression decoder (ATTRIBUTES mode, bitstream version 0) and its filters.
+ */
+namespace glTFRuntimePointCloud
+{
+	namespace Meshopt
+	{
+		constexpr uint8 VertexHeader = 0xa0;
+		constexpr int64 VertexBlockSizeBytes = 8192;
+		constexpr int64 VertexBlockMaxSize = 256;
+		constexpr int64 ByteGroupSize = 16;
+		constexpr int64 ByteGroupDecodeLimit = 24;
+		constexpr int64 TailMaxSize = 32;
+
+		FORCEINLINE int64 GetVertexBlockSize(const int64 VertexSize)
+		{
+			const int64 BlockSize = (VertexBlockSizeBytes / VertexSize) & ~(ByteGroupSize - 1);
+			return BlockSize < VertexBlockMaxSize ? BlockSize : VertexBlockMaxSize;
+		}
+
+		/* 16 values packed with 2 or 4 bits, the all-ones value escapes to a full byte stored after the packed bits */
+		template<int32 Bits>
+		FORCEINLINE const uint8* DecodeBytesGroupPacked(const uint8* Data, uint8* Buffer)
+		{
+			constexpr int32 Escape = (1 << Bits) - 1;
+			constexpr int32 PackedBytes = ByteGroupSize * Bits / 8;
+			const uint8* Variable = Data + PackedBytes;
+
+			for (int32 ByteIndex = 0; ByteIndex < PackedBytes; ByteIndex++)
+			{
+				uint8 Byte = Data[ByteIndex];
+				for (int32 Value = 0; Value < 8 / Bits; Value++)
+				{
+					const uint8 Encoded = Byte >> (8 - Bits);
+					Byte <<= Bits;
+					const bool bEscaped = Encoded == Escape;
+					*Buffer++ = bEscaped ? *Variable : Encoded;
+					Variable += bEscaped ? 1 : 0;
+				}
+			}
+
+			return Variable;
+		}
+
+		FORCEINLINE const uint8* DecodeBytesGroup(const uint8* Data, uint8* Buffer, const int32 BitsLog2)
+		{
+			switch (BitsLog2)
+			{
+			case 0:
+				FMemory::Memzero(Buffer, ByteGroupSize);
+				return Data;
+			case 1:
+				return DecodeBytesGroupPacked<2>(Data, Buffer);
+			case 2:
+				return DecodeBytesGroupPacked<4>(Data, Buffer);
+			default:
+				FMemory::Memcpy(Buffer, Data, ByteGroupSize);
+				return Data + ByteGroupSize;
+			}
+		}
+
+		inline const uint8* DecodeBytes(const uint8* Data, const uint8* DataEnd, uint8* Buffer, const int64 BufferSize)
+		{
+			// 2 bits of header per group
+			const uint8* Header = Data;
+			const int64 HeaderSize = (BufferSize / ByteGroupSize + 3) / 4;
+			if (DataEnd - Data < HeaderSize)
+			{
+				return nullptr;
+			}
+
+			Data += HeaderSize;
+
+			for (int64 Offset = 0; Offset < BufferSize; Offset += ByteGroupSize)
+			{
+				// the limit guarantees that any group can be decoded without further checks
+				if (DataEnd - Data < ByteGroupDecodeLimit)
+				{
+					return nullptr;
+				}
+
+				const int64 Group = Offset / ByteGroupSize;
+				const int32 BitsLog2 = (Header[Group / 4] >> ((Group % 4) * 2)) & 3;
+				Data = DecodeBytesGroup(Data, Buffer + Offset, BitsLog2);
+			}
+
+			return Data;
+		}
+
+		inline const uint8* DecodeVertexBlock(const uint8* Data, const uint8* DataEnd, uint8* VertexData, const int64 VertexCount, const int64 VertexSize, uint8* LastVertex)
+		{
+			uint8 Buffer[VertexBlockMaxSize];
+			const int64 VertexCountAligned = (VertexCount + ByteGroupSize - 1) & ~(ByteGroupSize - 1);
+
+			// every byte of the vertex is stored as its own delta (from the previous vertex) and zigzag encoded stream
+			for (int64 ByteIndex = 0; ByteIndex < VertexSize; ByteIndex++)
+			{
+				Data = DecodeBytes(Data, DataEnd, Buffer, VertexCountAligned);
+				if (!Data)
+				{
+					return nullptr;
+				}
+
+				uint8 Previous = LastVertex[ByteIndex];
+				uint8* Output = VertexData + ByteIndex;
+				for (int64 VertexIndex = 0; VertexIndex < VertexCount; VertexIndex++)
+				{
+					const uint8 Encoded = Buffer[VertexIndex];
+					const uint8 Value = static_cast<uint8>((-(Encoded & 1)) ^ (Encoded >> 1)) + Previous;
+					*Output = Value;
+					Output += VertexSize;
+					Previous = Value;
+				}
+			}
+
+			FMemory::Memcpy(LastVertex, VertexData + VertexSize * (VertexCount - 1), VertexSize);
+			return Data;
+		}
+
+		/* Returns false on malformed data */
+		inline bool DecodeVertexBuffer(uint8* Destination, const int64 VertexCount, const int64 VertexSize, const uint8* Data, const int64 DataSize)
+		{
+			if (VertexSize <= 0 || VertexSize > 256 || VertexSize % 4 != 0)
+			{
+				return false;
+			}
+
+			const uint8* DataEnd = Data + DataSize;
+			if (DataSize < 1 + VertexSize)
+			{
+				return false;
+			}
+
+			const uint8 DataHeader = *Data++;
+			if ((DataHeader & 0xf0) != VertexHeader || (DataHeader & 0x0f) != 0)
+			{
+				return false;
+			}
+
+			// the first vertex is stored at the end of the tail
+			uint8 LastVertex[256];
+			FMemory::Memcpy(LastVertex, DataEnd - VertexSize, VertexSize);
+
+			const int64 VertexBlockSize = GetVertexBlockSize(VertexSize);
+
+			for (int64 VertexOffset = 0; VertexOffset < VertexCount; VertexOffset += VertexBlockSize)
+			{
+				const int64 BlockSize = FMath::Min(VertexBlockSize, VertexCount - VertexOffset);
+				Data = DecodeVertexBlock(Data, DataEnd, Destination + VertexOffset * VertexSize, BlockSize, VertexSize, LastVertex);
+				if (!Data)
+				{
+					return false;
+				}
+			}
+
+			return DataEnd - Data == FMath::Max(VertexSize, TailMaxSize);
+		}
+
+		/* Normals/tangents stored as octahedral 8 or 16 bit (4 components per element) */
+		template<typename T>
+		void DecodeFilterOctahedral(T* Data, const int64 Count)
+		{
+			const float MaxValue = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+
+			for (int64 Index = 0; Index < Count; Index++)
+			{
+				float X = Data[Index * 4];
+				float Y = Data[Index * 4 + 1];
+				const float Z = Data[Index * 4 + 2] - FMath::Abs(X) - FMath::Abs(Y);
+
+				const float T0 = Z >= 0 ? 0 : Z;
+				X += X >= 0 ? T0 : -T0;
+				Y += Y >= 0 ? T0 : -T0;
+
+				const float Scale = MaxValue / FMath::Sqrt(X * X + Y * Y + Z * Z);
+
+				Data[Index * 4] = static_cast<T>(static_cast<int32>(X * Scale + (X >= 0 ? 0.5f : -0.5f)));
+				Data[Index * 4 + 1] = static_cast<T>(static_cast<int32>(Y * Scale + (Y >= 0 ? 0.5f : -0.5f)));
+				Data[Index * 4 + 2] = static_cast<T>(static_cast<int32>(Z * Scale + (Z >= 0 ? 0.5f : -0.5f)));
+			}
+		}
+
+		/* 24 bit mantissa and 8 bit exponent to float (in place) */
+		inline void DecodeFilterExponential(uint8* Data, const int64 Count)
+		{
+			for (int64 Index = 0; Index < Count; Index++)
+			{
+				uint32 Value;
+				FMemory::Memcpy(&Value, Data + Index * 4, sizeof(uint32));
+
+				const int32 Mantissa = static_cast<int32>(Value << 8) >> 8;
+				const int32 Exponent = static_cast<int32>(Value) >> 24;
+
+				const uint32 PowerBits = static_cast<uint32>(Exponent + 127) << 23;
+				float Power;
+				FMemory::Memcpy(&Power, &PowerBits, sizeof(float));
+
+				const float Result = Power * static_cast<float>(Mantissa);
+				FMemory::Memcpy(Data + Index * 4, &Result, sizeof(float));
+			}
+		}
+	}
+}
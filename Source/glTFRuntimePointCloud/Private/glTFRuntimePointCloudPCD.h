@@ -0,0 +1,470 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "glTFRuntimePointCloudColumns.h"
+#include "glTFRuntimePointCloudParsing.h"
+
+namespace glTFRuntimePointCloud
+{
+	struct FPCDField
+	{
+		FString Name;
+		/* size in bytes of a single element */
+		int32 Size = 4;
+		/* 'F', 'U' or 'I' */
+		TCHAR Type = 'F';
+		int32 Count = 1;
+		/* byte offset in a binary point */
+		int64 Offset = 0;
+		/* first column in an ascii line */
+		int32 Column = 0;
+	};
+
+	struct FPCDHeader
+	{
+		TArray<FPCDField> Fields;
+		int64 Width = 0;
+		int64 Height = 1;
+		int64 NumberOfPoints = 0;
+		/* size of a binary point */
+		int64 PointSize = 0;
+		/* number of columns of an ascii line */
+		int32 NumColumns = 0;
+		FString DataType;
+		/* first byte after the DATA line */
+		int64 DataOffset = -1;
+		FTransform ViewPoint;
+
+		int32 FindField(const TCHAR* Name) const
+		{
+			for (int32 FieldIndex = 0; FieldIndex < Fields.Num(); FieldIndex++)
+			{
+				if (Fields[FieldIndex].Name == Name)
+				{
+					return FieldIndex;
+				}
+			}
+			return -1;
+		}
+
+		bool Parse(const TArray64<uint8>& Blob)
+		{
+			TMap<FString, TArray<FString>> HeaderFields;
+
+			const uint8* Data = Blob.GetData();
+			const uint8* End = Data + Blob.Num();
+			const uint8* Ptr = Data;
+
+			while (Ptr < End)
+			{
+				const uint8* LineEnd = FindNewLine(Ptr, End);
+
+				TArray<FString> Line;
+				ForEachToken(Ptr, LineEnd, -1, [&Line](const int32 TokenIndex, const uint8* TokenBegin, const uint8* TokenEnd)
+					{
+						Line.Add(FString(static_cast<int32>(TokenEnd - TokenBegin), reinterpret_cast<const ANSICHAR*>(TokenBegin)));
+					});
+
+				// skip the newline (a single \r\n pair too)
+				Ptr = LineEnd;
+				if (Ptr < End && *Ptr == '\r')
+				{
+					Ptr++;
+				}
+				if (Ptr < End && *Ptr == '\n')
+				{
+					Ptr++;
+				}
+
+				if (Line.Num() == 0 || Line[0].StartsWith("#"))
+				{
+					continue;
+				}
+
+				if (Line[0] == "DATA")
+				{
+					if (Line.Num() < 2)
+					{
+						return false;
+					}
+					DataType = Line[1];
+					DataOffset = Ptr - Data;
+					break;
+				}
+
+				HeaderFields.Add(Line[0], MoveTemp(Line));
+			}
+
+			if (DataOffset < 0)
+			{
+				return false;
+			}
+
+			const TArray<FString>* FieldsNames = HeaderFields.Find("FIELDS");
+			if (!FieldsNames)
+			{
+				return false;
+			}
+
+			const TArray<FString>* Sizes = HeaderFields.Find("SIZE");
+			const TArray<FString>* Types = HeaderFields.Find("TYPE");
+			const TArray<FString>* Counts = HeaderFields.Find("COUNT");
+
+			for (int32 Index = 1; Index < FieldsNames->Num(); Index++)
+			{
+				FPCDField Field;
+				Field.Name = (*FieldsNames)[Index];
+				if (Sizes && Sizes->IsValidIndex(Index))
+				{
+					Field.Size = FCString::Atoi(*((*Sizes)[Index]));
+				}
+				if (Types && Types->IsValidIndex(Index) && !(*Types)[Index].IsEmpty())
+				{
+					Field.Type = FChar::ToUpper((*Types)[Index][0]);
+				}
+				if (Counts && Counts->IsValidIndex(Index))
+				{
+					Field.Count = FMath::Max(1, FCString::Atoi(*((*Counts)[Index])));
+				}
+
+				if (Field.Size != 1 && Field.Size != 2 && Field.Size != 4 && Field.Size != 8)
+				{
+					return false;
+				}
+
+				Field.Offset = PointSize;
+				Field.Column = NumColumns;
+				PointSize += static_cast<int64>(Field.Size) * Field.Count;
+				NumColumns += Field.Count;
+				Fields.Add(Field);
+			}
+
+			if (const TArray<FString>* WidthField = HeaderFields.Find("WIDTH"))
+			{
+				if (WidthField->Num() > 1)
+				{
+					Width = FCString::Atoi64(*((*WidthField)[1]));
+				}
+			}
+
+			if (const TArray<FString>* HeightField = HeaderFields.Find("HEIGHT"))
+			{
+				if (HeightField->Num() > 1)
+				{
+					Height = FCString::Atoi64(*((*HeightField)[1]));
+				}
+			}
+
+			if (const TArray<FString>* PointsField = HeaderFields.Find("POINTS"))
+			{
+				if (PointsField->Num() > 1)
+				{
+					NumberOfPoints = FCString::Atoi64(*((*PointsField)[1]));
+				}
+			}
+
+			if (NumberOfPoints < (Width * Height))
+			{
+				NumberOfPoints = Width * Height;
+			}
+
+			// VIEWPOINT tx ty tz qw qx qy qz
+			if (const TArray<FString>* ViewPointField = HeaderFields.Find("VIEWPOINT"))
+			{
+				if (ViewPointField->Num() >= 8)
+				{
+					double Values[7];
+					for (int32 Index = 0; Index < 7; Index++)
+					{
+						Values[Index] = FCString::Atod(*((*ViewPointField)[Index + 1]));
+					}
+					ViewPoint.SetLocation(FVector(Values[0], Values[1], Values[2]));
+					ViewPoint.SetRotation(FQuat(Values[4], Values[5], Values[6], Values[3]).GetNormalized());
+				}
+			}
+
+			return true;
+		}
+	};
+
+	/* ascii packed colors are written either as the uint32 value or as the float sharing its bits */
+	FORCEINLINE uint32 ParsePCDPackedColor(const uint8* TokenBegin, const uint8* TokenEnd)
+	{
+		int64 IntValue = 0;
+		if (ParseInt64(TokenBegin, TokenEnd, IntValue) == TokenEnd)
+		{
+			return static_cast<uint32>(IntValue);
+		}
+
+		const float FloatValue = static_cast<float>(TokenToDouble(TokenBegin, TokenEnd));
+		uint32 Bits;
+		FMemory::Memcpy(&Bits, &FloatValue, sizeof(uint32));
+		return Bits;
+	}
+
+	/* intensity is mapped to the alpha channel, floats are expected in the 0-255 range (PCL/Velodyne convention) */
+	FORCEINLINE uint8 PCDIntensityToAlpha(const double Value, const FPCDField& Field)
+	{
+		if (Field.Type == 'F')
+		{
+			return static_cast<uint8>(FMath::Clamp(Value, 0.0, 255.0));
+		}
+		const int32 Shift = (Field.Size - 1) * 8;
+		return static_cast<uint8>(FMath::Clamp<int64>(static_cast<int64>(Value) >> Shift, 0, 255));
+	}
+
+	template<typename T>
+	FORCEINLINE double ReadPCDComponent(const uint8* Ptr)
+	{
+		T Value;
+		FMemory::Memcpy(&Value, Ptr, sizeof(T));
+		return static_cast<double>(Value);
+	}
+
+	using FPCDReadFunction = double(*)(const uint8*);
+
+	/* Converts through double like ReadPCDComponent, so both paths produce the same values */
+	template<typename T, typename OutType>
+	FORCEINLINE void ReadPCDColumn(const uint8* Base, const int64 Stride, const int64* Indices, const int32 Num, OutType* Output)
+	{
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			T Value;
+			FMemory::Memcpy(&Value, Base + Indices[Index] * Stride, sizeof(T));
+			Output[Index] = static_cast<OutType>(static_cast<double>(Value));
+		}
+	}
+
+	inline FPCDReadFunction GetPCDReadFunction(const FPCDField& Field)
+	{
+		switch (Field.Type)
+		{
+		case 'F':
+			return Field.Size == 8 ? &ReadPCDComponent<double> : (Field.Size == 4 ? &ReadPCDComponent<float> : nullptr);
+		case 'U':
+			switch (Field.Size)
+			{
+			case 1: return &ReadPCDComponent<uint8>;
+			case 2: return &ReadPCDComponent<uint16>;
+			case 4: return &ReadPCDComponent<uint32>;
+			case 8: return &ReadPCDComponent<uint64>;
+			}
+			break;
+		case 'I':
+			switch (Field.Size)
+			{
+			case 1: return &ReadPCDComponent<int8>;
+			case 2: return &ReadPCDComponent<int16>;
+			case 4: return &ReadPCDComponent<int32>;
+			case 8: return &ReadPCDComponent<int64>;
+			}
+			break;
+		}
+		return nullptr;
+	}
+
+	/* A field resolved to a (base offset, point stride, converter) triple, type and size select the column reader */
+	struct FPCDDecodeAttribute
+	{
+		int64 Offset = 0;
+		int64 Stride = 0;
+		FPCDReadFunction Read = nullptr;
+		TCHAR Type = 'F';
+		int32 Size = 4;
+
+		FORCEINLINE bool IsValid() const
+		{
+			return Read != nullptr;
+		}
+
+		FORCEINLINE const uint8* GetPtr(const uint8* Data, const int64 PointIndex) const
+		{
+			return Data + Offset + PointIndex * Stride;
+		}
+
+		FORCEINLINE double Get(const uint8* Data, const int64 PointIndex) const
+		{
+			return Read(GetPtr(Data, PointIndex));
+		}
+
+		/* Output[Index] is the value of point Indices[Index], missing fields are 0 */
+		template<typename OutType>
+		void ReadColumn(const uint8* Data, const int64* Indices, const int32 Num, OutType* Output) const
+		{
+			const uint8* Base = Data + Offset;
+			switch (IsValid() ? Type : 0)
+			{
+			case 'F':
+				if (Size == 8)
+				{
+					ReadPCDColumn<double>(Base, Stride, Indices, Num, Output);
+				}
+				else
+				{
+					ReadPCDColumn<float>(Base, Stride, Indices, Num, Output);
+				}
+				return;
+			case 'U':
+				switch (Size)
+				{
+				case 1: ReadPCDColumn<uint8>(Base, Stride, Indices, Num, Output); return;
+				case 2: ReadPCDColumn<uint16>(Base, Stride, Indices, Num, Output); return;
+				case 4: ReadPCDColumn<uint32>(Base, Stride, Indices, Num, Output); return;
+				default: ReadPCDColumn<uint64>(Base, Stride, Indices, Num, Output); return;
+				}
+			case 'I':
+				switch (Size)
+				{
+				case 1: ReadPCDColumn<int8>(Base, Stride, Indices, Num, Output); return;
+				case 2: ReadPCDColumn<int16>(Base, Stride, Indices, Num, Output); return;
+				case 4: ReadPCDColumn<int32>(Base, Stride, Indices, Num, Output); return;
+				default: ReadPCDColumn<int64>(Base, Stride, Indices, Num, Output); return;
+				}
+			default:
+				for (int32 Index = 0; Index < Num; Index++)
+				{
+					Output[Index] = 0;
+				}
+				return;
+			}
+		}
+	};
+
+	/*
+	 * The binary header compiled into a flat list of attributes, no lookup is required while decoding.
+	 * Both point-major (binary) and field-major (decompressed binary_compressed) layouts are supported, points are decoded a column at a time.
+	 */
+	struct FPCDDecodePlan
+	{
+		FPCDDecodeAttribute X;
+		FPCDDecodeAttribute Y;
+		FPCDDecodeAttribute Z;
+		FPCDDecodeAttribute NX;
+		FPCDDecodeAttribute NY;
+		FPCDDecodeAttribute NZ;
+		FPCDDecodeAttribute Intensity;
+		/* packed colors are always read as raw 32 bits */
+		int64 RGBOffset = -1;
+		int64 RGBStride = 0;
+		bool bRGBA = false;
+		bool bHasNormals = false;
+		FPCDField IntensityField;
+		/* sources of the range filters, missing fields are 0 */
+		TArray<FPCDDecodeAttribute> Ranges;
+
+		void Compile(const FPCDHeader& Header, const bool bFieldMajor, const TArray<FglTFRuntimePointCloudRangeFilter>& RangeFilters)
+		{
+			auto Resolve = [&](const TCHAR* Name, FPCDDecodeAttribute& Attribute)
+				{
+					const int32 FieldIndex = Header.FindField(Name);
+					if (FieldIndex < 0)
+					{
+						return;
+					}
+					const FPCDField& Field = Header.Fields[FieldIndex];
+					Attribute.Offset = bFieldMajor ? Field.Offset * Header.NumberOfPoints : Field.Offset;
+					Attribute.Stride = bFieldMajor ? static_cast<int64>(Field.Size) * Field.Count : Header.PointSize;
+					Attribute.Read = GetPCDReadFunction(Field);
+					Attribute.Type = Field.Type;
+					Attribute.Size = Field.Size;
+				};
+
+			Resolve(TEXT("x"), X);
+			Resolve(TEXT("y"), Y);
+			Resolve(TEXT("z"), Z);
+			Resolve(TEXT("normal_x"), NX);
+			Resolve(TEXT("normal_y"), NY);
+			Resolve(TEXT("normal_z"), NZ);
+			Resolve(TEXT("intensity"), Intensity);
+
+			for (const FglTFRuntimePointCloudRangeFilter& RangeFilter : RangeFilters)
+			{
+				Resolve(*RangeFilter.Field, Ranges.AddDefaulted_GetRef());
+			}
+
+			bHasNormals = NX.IsValid() || NY.IsValid() || NZ.IsValid();
+
+			if (Intensity.IsValid())
+			{
+				IntensityField = Header.Fields[Header.FindField(TEXT("intensity"))];
+			}
+
+			int32 RGBField = Header.FindField(TEXT("rgba"));
+			bRGBA = RGBField >= 0;
+			if (!bRGBA)
+			{
+				RGBField = Header.FindField(TEXT("rgb"));
+			}
+
+			if (RGBField >= 0 && Header.Fields[RGBField].Size == 4)
+			{
+				const FPCDField& Field = Header.Fields[RGBField];
+				RGBOffset = bFieldMajor ? Field.Offset * Header.NumberOfPoints : Field.Offset;
+				RGBStride = bFieldMajor ? static_cast<int64>(Field.Size) * Field.Count : Header.PointSize;
+			}
+			else
+			{
+				bRGBA = false;
+			}
+		}
+
+		/* Decodes the points staged in Columns, a field at a time */
+		void DecodeColumns(const uint8* Data, FPointColumns& Columns) const
+		{
+			const int64* Indices = Columns.Indices.GetData();
+			const int32 Num = Columns.Num;
+
+			X.ReadColumn(Data, Indices, Num, Columns.X.GetData());
+			Y.ReadColumn(Data, Indices, Num, Columns.Y.GetData());
+			Z.ReadColumn(Data, Indices, Num, Columns.Z.GetData());
+
+			Columns.bHasColors = RGBOffset >= 0 || Intensity.IsValid();
+			if (Columns.bHasColors)
+			{
+				const FColor DefaultColor = FLidarPointCloudPoint().Color;
+				FColor* Colors = Columns.Colors.GetData();
+
+				if (RGBOffset >= 0)
+				{
+					const uint8* Base = Data + RGBOffset;
+					for (int32 Index = 0; Index < Num; Index++)
+					{
+						uint32 Packed;
+						FMemory::Memcpy(&Packed, Base + Indices[Index] * RGBStride, sizeof(uint32));
+						Colors[Index] = FColor(static_cast<uint8>(Packed >> 16), static_cast<uint8>(Packed >> 8), static_cast<uint8>(Packed), bRGBA ? static_cast<uint8>(Packed >> 24) : DefaultColor.A);
+					}
+				}
+				else
+				{
+					for (int32 Index = 0; Index < Num; Index++)
+					{
+						Colors[Index] = DefaultColor;
+					}
+				}
+
+				if (!bRGBA && Intensity.IsValid())
+				{
+					for (int32 Index = 0; Index < Num; Index++)
+					{
+						Colors[Index].A = PCDIntensityToAlpha(Intensity.Get(Data, Indices[Index]), IntensityField);
+					}
+				}
+			}
+
+			Columns.bHasNormals = bHasNormals;
+			if (bHasNormals)
+			{
+				NX.ReadColumn(Data, Indices, Num, Columns.NX.GetData());
+				NY.ReadColumn(Data, Indices, Num, Columns.NY.GetData());
+				NZ.ReadColumn(Data, Indices, Num, Columns.NZ.GetData());
+			}
+
+			for (int32 RangeIndex = 0; RangeIndex < Ranges.Num(); RangeIndex++)
+			{
+				Ranges[RangeIndex].ReadColumn(Data, Indices, Num, Columns.GetExtra(RangeIndex));
+			}
+		}
+	};
+}
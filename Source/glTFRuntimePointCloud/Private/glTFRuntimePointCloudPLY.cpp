@@ -0,0 +1,246 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#include "glTFRuntimePointCloudLibrary.h"
+#include "Async/ParallelFor.h"
+#include "glTFRuntimePointCloudAsyncAction.h"
+#include "glTFRuntimePointCloudPLY.h"
+#include "glTFRuntimePointCloudSink.h"
+#include "glTFRuntimePointCloudStats.h"
+
+ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromPLY(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	return LoadPointCloudFromPLYWithBatchFilter(Asset, {}, nullptr, PointCloudConfig);
+}
+
+ULidarPointCloud* UglTFRuntimePointCloudLibrary::LoadPointCloudFromPLYWithBatchFilter(UglTFRuntimeAsset* Asset, const TArray<FString>& FilterProperties, FglTFRuntimePointCloudBatchFilter BatchFilter, const FglTFRuntimePointCloudConfig& PointCloudConfig)
+{
+	if (!Asset)
+	{
+		return nullptr;
+	}
+
+	FglTFRuntimePointCloudLoadContext Context(PointCloudConfig);
+	TArray64<FLidarPointCloudPoint> Points;
+	if (!LoadPointsFromPLYWithBatchFilter(Asset->GetParser().ToSharedRef(), FilterProperties, BatchFilter, Points, Context))
+	{
+		return nullptr;
+	}
+
+	return CreatePointCloud(Points, Context);
+}
+
+UglTFRuntimePointCloudAsyncAction* UglTFRuntimePointCloudLibrary::LoadPointCloudFromPLYAsync(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback)
+{
+	UglTFRuntimePointCloudAsyncAction* Action = UglTFRuntimePointCloudAsyncAction::AsyncLoadPointCloudFromPLY(Asset, PointCloudConfig);
+	Action->AsyncCallback = AsyncCallback;
+	Action->ProgressCallback = ProgressCallback;
+	Action->Activate();
+	return Action;
+}
+
+bool UglTFRuntimePointCloudLibrary::LoadPointsFromPLY(TSharedRef<FglTFRuntimeParser> Parser, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context)
+{
+	return LoadPointsFromPLYWithBatchFilter(Parser, {}, nullptr, Points, Context);
+}
+
+bool UglTFRuntimePointCloudLibrary::LoadPointsFromPLYWithBatchFilter(TSharedRef<FglTFRuntimeParser> Parser, const TArray<FString>& FilterProperties, FglTFRuntimePointCloudBatchFilter BatchFilter, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context)
+{
+	const TArray64<uint8>& Blob = Parser->GetBlob();
+
+	glTFRuntimePointCloud::FPLYHeader Header;
+	if (!Header.Parse(Blob))
+	{
+		UE_LOG(LogGLTFRuntime, Error, TEXT("Invalid PLY header"));
+		return false;
+	}
+
+	const int32 VertexElementIndex = Header.FindElement(TEXT("vertex"));
+	if (VertexElementIndex < 0)
+	{
+		UE_LOG(LogGLTFRuntime, Error, TEXT("PLY file without a vertex element"));
+		return false;
+	}
+
+	const glTFRuntimePointCloud::FPLYElement& VertexElement = Header.Elements[VertexElementIndex];
+	if (VertexElement.bHasLists)
+	{
+		UE_LOG(LogGLTFRuntime, Error, TEXT("List properties in the PLY vertex element are not supported"));
+		return false;
+	}
+
+	// elements are stored in header order, the ones before the vertices (if any) are skipped
+	int64 VertexOffset = Header.DataOffset;
+	for (int32 ElementIndex = 0; ElementIndex < VertexElementIndex && VertexOffset >= 0; ElementIndex++)
+	{
+		VertexOffset = glTFRuntimePointCloud::SkipPLYElement(Blob, Header.Format, Header.Elements[ElementIndex], VertexOffset);
+	}
+
+	if (VertexOffset < 0)
+	{
+		UE_LOG(LogGLTFRuntime, Error, TEXT("Truncated PLY data"));
+		return false;
+	}
+
+	// filter properties are decoded only when a filter consumes them
+	glTFRuntimePointCloud::FPLYDecodePlan DecodePlan;
+	DecodePlan.Compile(VertexElement, Header.Format, BatchFilter ? FilterProperties : TArray<FString>(), Context.Config.RangeFilters);
+	const int32 NumExtras = DecodePlan.Extras.Num();
+
+	const uint8* Data = Blob.GetData();
+
+	glTFRuntimePointCloud::FPointSink Sink(Points, Context.Config);
+
+	if (Header.Format == glTFRuntimePointCloud::EPLYFormat::Ascii)
+	{
+		// every vertex is a line, the vertex block ends after Count lines
+		const int64 VertexEnd = glTFRuntimePointCloud::SkipLines(Data, VertexOffset, Blob.Num(), VertexElement.Count);
+		if (VertexEnd < 0)
+		{
+			UE_LOG(LogGLTFRuntime, Error, TEXT("Truncated PLY data"));
+			return false;
+		}
+
+		TArray<glTFRuntimePointCloud::FLineChunk> Chunks;
+		const int64 TotalLines = glTFRuntimePointCloud::BuildLineChunks(Data, VertexOffset, VertexEnd, Chunks, Context);
+		if (TotalLines < 0)
+		{
+			return false;
+		}
+
+		Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::LineScan, 1, 1);
+
+		if (!Sink.Begin(TotalLines))
+		{
+			return false;
+		}
+
+		std::atomic<int64> ParsedLines = 0;
+
+		{
+			GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, Parse);
+			ParallelFor(Chunks.Num(), [&](const int32 ChunkIndex)
+				{
+					if (Context.IsCanceled())
+					{
+						return;
+					}
+
+					const glTFRuntimePointCloud::FLineChunk& Chunk = Chunks[ChunkIndex];
+					int64 PointIndex = Chunk.FirstLine;
+
+					TArray<double, TInlineAllocator<32>> Values;
+					Values.AddUninitialized(DecodePlan.NumProperties);
+
+					glTFRuntimePointCloud::FPointSink::FWriter Writer(Sink);
+					glTFRuntimePointCloud::FBatchBuilder BatchBuilder(Writer, BatchFilter, NumExtras);
+
+					glTFRuntimePointCloud::ForEachLine(Data, VertexOffset, VertexEnd, Chunk, [&](const uint8* LineBegin, const uint8* LineEnd)
+						{
+							const int64 LineIndex = PointIndex++;
+
+							// the batch filter sees every point (in the ranges), decimation is applied to its output
+							if (!BatchFilter && !Writer.Accepts(LineIndex))
+							{
+								return;
+							}
+
+							DecodePlan.ParseLine(LineBegin, LineEnd, Values.GetData());
+
+							if (Sink.HasRanges() && !Writer.AcceptsRanges([&](const int32 RangeIndex) { return DecodePlan.GetRange(Values.GetData(), RangeIndex); }))
+							{
+								return;
+							}
+
+							if (BatchFilter)
+							{
+								BatchBuilder.Add(LineIndex, DecodePlan.Decode(Values.GetData()), [&](const int32 ExtraIndex) { return DecodePlan.GetExtra(Values.GetData(), ExtraIndex); });
+							}
+							else
+							{
+								Writer.Add(LineIndex, DecodePlan.Decode(Values.GetData()));
+							}
+						});
+
+					BatchBuilder.Flush();
+
+					Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, ParsedLines += Chunk.NumLines, TotalLines);
+				});
+		}
+	}
+	else
+	{
+		const int64 NumberOfPoints = VertexElement.Count;
+		const int64 Stride = VertexElement.Stride;
+
+		if (Stride <= 0 || NumberOfPoints > (Blob.Num() - VertexOffset) / Stride)
+		{
+			UE_LOG(LogGLTFRuntime, Error, TEXT("Truncated PLY data"));
+			return false;
+		}
+
+		const uint8* VertexData = Data + VertexOffset;
+
+		if (!Sink.Begin(NumberOfPoints))
+		{
+			return false;
+		}
+
+		constexpr int64 PointsPerBlock = 64 * 1024;
+		const int32 NumBlocks = static_cast<int32>((NumberOfPoints + PointsPerBlock - 1) / PointsPerBlock);
+		std::atomic<int64> DecodedPoints = 0;
+
+		{
+			GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, Parse);
+			ParallelFor(NumBlocks, [&](const int32 BlockIndex)
+				{
+					if (Context.IsCanceled())
+					{
+						return;
+					}
+
+					const int64 FirstPoint = BlockIndex * PointsPerBlock;
+					const int64 LastPoint = FMath::Min(FirstPoint + PointsPerBlock, NumberOfPoints);
+
+					glTFRuntimePointCloud::FPointSink::FWriter Writer(Sink);
+					glTFRuntimePointCloud::FBatchBuilder BatchBuilder(Writer, BatchFilter, NumExtras);
+
+					for (int64 PointIndex = FirstPoint; PointIndex < LastPoint; PointIndex++)
+					{
+						if (!BatchFilter && !Writer.Accepts(PointIndex))
+						{
+							continue;
+						}
+
+						const uint8* Record = VertexData + PointIndex * Stride;
+
+						if (Sink.HasRanges() && !Writer.AcceptsRanges([&](const int32 RangeIndex) { return DecodePlan.GetRange(Record, RangeIndex); }))
+						{
+							continue;
+						}
+
+						if (BatchFilter)
+						{
+							BatchBuilder.Add(PointIndex, DecodePlan.Decode(Record), [&](const int32 ExtraIndex) { return DecodePlan.GetExtra(Record, ExtraIndex); });
+						}
+						else
+						{
+							Writer.Add(PointIndex, DecodePlan.Decode(Record));
+						}
+					}
+
+					BatchBuilder.Flush();
+
+					Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, DecodedPoints += LastPoint - FirstPoint, NumberOfPoints);
+				});
+		}
+	}
+
+	if (!Sink.End(Context))
+	{
+		return false;
+	}
+
+	Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::Parse, 1, 1);
+
+	return true;
+}
@@ -0,0 +1,592 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "glTFRuntimePointCloudColor.h"
+#include "glTFRuntimePointCloudLibrary.h"
+#include "glTFRuntimePointCloudParsing.h"
+#include "Misc/ByteSwap.h"
+
+namespace glTFRuntimePointCloud
+{
+	enum class EPLYFormat : uint8
+	{
+		Ascii,
+		BinaryLittleEndian,
+		BinaryBigEndian
+	};
+
+	struct FPLYProperty
+	{
+		FString Name;
+		/* size in bytes of the value (of the items for lists) */
+		int32 Size = 4;
+		/* 'F', 'U' or 'I' (same convention of PCD) */
+		TCHAR Type = 'F';
+		/* byte offset in a fixed size binary record */
+		int64 Offset = 0;
+		bool bList = false;
+		int32 CountSize = 0;
+		TCHAR CountType = 'U';
+	};
+
+	struct FPLYElement
+	{
+		FString Name;
+		int64 Count = 0;
+		TArray<FPLYProperty> Properties;
+		/* size of a binary record (meaningful only without lists) */
+		int64 Stride = 0;
+		bool bHasLists = false;
+
+		int32 FindProperty(const TCHAR* Name) const
+		{
+			for (int32 PropertyIndex = 0; PropertyIndex < Properties.Num(); PropertyIndex++)
+			{
+				if (Properties[PropertyIndex].Name == Name)
+				{
+					return PropertyIndex;
+				}
+			}
+			return -1;
+		}
+	};
+
+	/* both the PLY 1.0 names (char, uchar, ...) and the sized ones (int8, uint8, ...) are accepted */
+	inline bool ParsePLYType(const FString& Name, TCHAR& Type, int32& Size)
+	{
+		static const struct
+		{
+			const TCHAR* Name;
+			TCHAR Type;
+			int32 Size;
+		} Types[] =
+		{
+			{ TEXT("char"), 'I', 1 }, { TEXT("int8"), 'I', 1 },
+			{ TEXT("uchar"), 'U', 1 }, { TEXT("uint8"), 'U', 1 },
+			{ TEXT("short"), 'I', 2 }, { TEXT("int16"), 'I', 2 },
+			{ TEXT("ushort"), 'U', 2 }, { TEXT("uint16"), 'U', 2 },
+			{ TEXT("int"), 'I', 4 }, { TEXT("int32"), 'I', 4 },
+			{ TEXT("uint"), 'U', 4 }, { TEXT("uint32"), 'U', 4 },
+			{ TEXT("float"), 'F', 4 }, { TEXT("float32"), 'F', 4 },
+			{ TEXT("double"), 'F', 8 }, { TEXT("float64"), 'F', 8 }
+		};
+
+		for (const auto& Candidate : Types)
+		{
+			if (Name == Candidate.Name)
+			{
+				Type = Candidate.Type;
+				Size = Candidate.Size;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	struct FPLYHeader
+	{
+		EPLYFormat Format = EPLYFormat::Ascii;
+		TArray<FPLYElement> Elements;
+		/* first byte after the end_header line */
+		int64 DataOffset = -1;
+
+		int32 FindElement(const TCHAR* Name) const
+		{
+			for (int32 ElementIndex = 0; ElementIndex < Elements.Num(); ElementIndex++)
+			{
+				if (Elements[ElementIndex].Name == Name)
+				{
+					return ElementIndex;
+				}
+			}
+			return -1;
+		}
+
+		bool Parse(const TArray64<uint8>& Blob)
+		{
+			const uint8* Data = Blob.GetData();
+			const uint8* End = Data + Blob.Num();
+			const uint8* Ptr = Data;
+
+			if (Blob.Num() < 4 || FMemory::Memcmp(Data, "ply", 3) != 0 || !IsNewLine(Data[3]))
+			{
+				return false;
+			}
+
+			bool bHasFormat = false;
+
+			while (Ptr < End)
+			{
+				const uint8* LineEnd = FindNewLine(Ptr, End);
+
+				TArray<FString> Line;
+				ForEachToken(Ptr, LineEnd, -1, [&Line](const int32 TokenIndex, const uint8* TokenBegin, const uint8* TokenEnd)
+					{
+						Line.Add(FString(static_cast<int32>(TokenEnd - TokenBegin), reinterpret_cast<const ANSICHAR*>(TokenBegin)));
+					});
+
+				// the binary data starts right after the end_header newline (a single \r\n pair too)
+				Ptr = LineEnd;
+				if (Ptr < End && *Ptr == '\r')
+				{
+					Ptr++;
+				}
+				if (Ptr < End && *Ptr == '\n')
+				{
+					Ptr++;
+				}
+
+				if (Line.Num() == 0 || Line[0] == "comment" || Line[0] == "obj_info" || Line[0] == "ply")
+				{
+					continue;
+				}
+
+				if (Line[0] == "end_header")
+				{
+					DataOffset = Ptr - Data;
+					break;
+				}
+
+				if (Line[0] == "format")
+				{
+					if (Line.Num() < 2)
+					{
+						return false;
+					}
+
+					if (Line[1] == "ascii")
+					{
+						Format = EPLYFormat::Ascii;
+					}
+					else if (Line[1] == "binary_little_endian")
+					{
+						Format = EPLYFormat::BinaryLittleEndian;
+					}
+					else if (Line[1] == "binary_big_endian")
+					{
+						Format = EPLYFormat::BinaryBigEndian;
+					}
+					else
+					{
+						return false;
+					}
+					bHasFormat = true;
+				}
+				else if (Line[0] == "element")
+				{
+					if (Line.Num() < 3)
+					{
+						return false;
+					}
+
+					FPLYElement Element;
+					Element.Name = Line[1];
+					Element.Count = FCString::Atoi64(*Line[2]);
+					if (Element.Count < 0)
+					{
+						return false;
+					}
+					Elements.Add(MoveTemp(Element));
+				}
+				else if (Line[0] == "property")
+				{
+					if (Elements.Num() == 0 || Line.Num() < 3)
+					{
+						return false;
+					}
+
+					FPLYElement& Element = Elements.Last();
+					FPLYProperty Property;
+
+					if (Line[1] == "list")
+					{
+						// property list <count type> <item type> <name>
+						if (Line.Num() < 5 || !ParsePLYType(Line[2], Property.CountType, Property.CountSize) || !ParsePLYType(Line[3], Property.Type, Property.Size) || Property.CountType == 'F')
+						{
+							return false;
+						}
+						Property.bList = true;
+						Property.Name = Line[4];
+						Element.bHasLists = true;
+					}
+					else
+					{
+						if (!ParsePLYType(Line[1], Property.Type, Property.Size))
+						{
+							return false;
+						}
+						Property.Name = Line[2];
+						Property.Offset = Element.Stride;
+						Element.Stride += Property.Size;
+					}
+
+					Element.Properties.Add(MoveTemp(Property));
+				}
+			}
+
+			return bHasFormat && DataOffset >= 0;
+		}
+	};
+
+	/* binary values are read in their file endianness, swapping costs a single bswap per value */
+	template<typename T, bool bSwap>
+	FORCEINLINE double ReadPLYComponent(const uint8* Ptr)
+	{
+		T Value;
+		if constexpr (bSwap && sizeof(T) == 2)
+		{
+			uint16 Bits;
+			FMemory::Memcpy(&Bits, Ptr, sizeof(uint16));
+			Bits = BYTESWAP_ORDER16(Bits);
+			FMemory::Memcpy(&Value, &Bits, sizeof(T));
+		}
+		else if constexpr (bSwap && sizeof(T) == 4)
+		{
+			uint32 Bits;
+			FMemory::Memcpy(&Bits, Ptr, sizeof(uint32));
+			Bits = BYTESWAP_ORDER32(Bits);
+			FMemory::Memcpy(&Value, &Bits, sizeof(T));
+		}
+		else if constexpr (bSwap && sizeof(T) == 8)
+		{
+			uint64 Bits;
+			FMemory::Memcpy(&Bits, Ptr, sizeof(uint64));
+			Bits = BYTESWAP_ORDER64(Bits);
+			FMemory::Memcpy(&Value, &Bits, sizeof(T));
+		}
+		else
+		{
+			FMemory::Memcpy(&Value, Ptr, sizeof(T));
+		}
+		return static_cast<double>(Value);
+	}
+
+	using FPLYReadFunction = double(*)(const uint8*);
+
+	template<bool bSwap>
+	FPLYReadFunction GetPLYReadFunction(const TCHAR Type, const int32 Size)
+	{
+		switch (Type)
+		{
+		case 'F':
+			return Size == 8 ? &ReadPLYComponent<double, bSwap> : &ReadPLYComponent<float, bSwap>;
+		case 'U':
+			switch (Size)
+			{
+			case 1: return &ReadPLYComponent<uint8, bSwap>;
+			case 2: return &ReadPLYComponent<uint16, bSwap>;
+			case 4: return &ReadPLYComponent<uint32, bSwap>;
+			}
+			break;
+		case 'I':
+			switch (Size)
+			{
+			case 1: return &ReadPLYComponent<int8, bSwap>;
+			case 2: return &ReadPLYComponent<int16, bSwap>;
+			case 4: return &ReadPLYComponent<int32, bSwap>;
+			}
+			break;
+		}
+		return nullptr;
+	}
+
+	inline FPLYReadFunction GetPLYReadFunction(const EPLYFormat Format, const TCHAR Type, const int32 Size)
+	{
+		return Format == EPLYFormat::BinaryBigEndian ? GetPLYReadFunction<true>(Type, Size) : GetPLYReadFunction<false>(Type, Size);
+	}
+
+	/*
+	 * Returns the offset of the first byte after Count instances of Element starting at Offset or -1 on truncated data.
+	 * Fixed size binary elements are skipped in one step, lists require a walk of every instance.
+	 */
+	inline int64 SkipPLYElement(const TArray64<uint8>& Blob, const EPLYFormat Format, const FPLYElement& Element, int64 Offset)
+	{
+		const int64 Size = Blob.Num();
+
+		if (Format == EPLYFormat::Ascii)
+		{
+			return SkipLines(Blob.GetData(), Offset, Size, Element.Count);
+		}
+
+		if (!Element.bHasLists)
+		{
+			return Element.Count <= (Size - Offset) / FMath::Max<int64>(Element.Stride, 1) ? Offset + Element.Count * Element.Stride : -1;
+		}
+
+		for (int64 Index = 0; Index < Element.Count; Index++)
+		{
+			for (const FPLYProperty& Property : Element.Properties)
+			{
+				if (!Property.bList)
+				{
+					Offset += Property.Size;
+					continue;
+				}
+
+				if (Offset + Property.CountSize > Size)
+				{
+					return -1;
+				}
+
+				const int64 Count = static_cast<int64>(GetPLYReadFunction(Format, Property.CountType, Property.CountSize)(Blob.GetData() + Offset));
+				if (Count < 0)
+				{
+					return -1;
+				}
+				Offset += Property.CountSize + Count * Property.Size;
+			}
+
+			if (Offset > Size)
+			{
+				return -1;
+			}
+		}
+
+		return Offset;
+	}
+
+	/* A vertex property resolved to its index (ascii) and its (offset, converter) pair (binary) */
+	struct FPLYDecodeAttribute
+	{
+		int32 Property = -1;
+		int64 Offset = 0;
+		FPLYReadFunction Read = nullptr;
+
+		FORCEINLINE bool IsValid() const
+		{
+			return Property >= 0;
+		}
+
+		FORCEINLINE double Get(const uint8* Record) const
+		{
+			return Read(Record + Offset);
+		}
+	};
+
+	/* The vertex element compiled into a flat list of attributes, no lookup is required while decoding */
+	struct FPLYDecodePlan
+	{
+		enum EField
+		{
+			X, Y, Z,
+			R, G, B, A,
+			NX, NY, NZ,
+			NumFields
+		};
+
+		FPLYDecodeAttribute Fields[NumFields];
+		/* per channel scale mapping the stored range to 0-255 */
+		float ColorScales[4] = { 1, 1, 1, 1 };
+		TArray<FPLYDecodeAttribute> Extras;
+		/* sources of the range filters, missing properties are 0 */
+		TArray<FPLYDecodeAttribute> Ranges;
+		/* ascii properties converted while scanning a line (the others are only skipped) */
+		TArray<bool> UsedProperties;
+		int32 NumProperties = 0;
+		bool bFloatXYZ = false;
+
+		void Compile(const FPLYElement& Element, const EPLYFormat Format, const TArray<FString>& ExtraProperties, const TArray<FglTFRuntimePointCloudRangeFilter>& RangeFilters)
+		{
+			NumProperties = Element.Properties.Num();
+			UsedProperties.Init(false, NumProperties);
+
+			auto Resolve = [&](const int32 PropertyIndex, FPLYDecodeAttribute& Attribute)
+				{
+					if (PropertyIndex < 0)
+					{
+						return;
+					}
+					const FPLYProperty& Property = Element.Properties[PropertyIndex];
+					Attribute.Property = PropertyIndex;
+					Attribute.Offset = Property.Offset;
+					Attribute.Read = GetPLYReadFunction(Format, Property.Type, Property.Size);
+					UsedProperties[PropertyIndex] = true;
+				};
+
+			auto ResolveField = [&](const EField Field, std::initializer_list<const TCHAR*> Names)
+				{
+					for (const TCHAR* Name : Names)
+					{
+						const int32 PropertyIndex = Element.FindProperty(Name);
+						if (PropertyIndex >= 0)
+						{
+							Resolve(PropertyIndex, Fields[Field]);
+							return;
+						}
+					}
+				};
+
+			ResolveField(X, { TEXT("x") });
+			ResolveField(Y, { TEXT("y") });
+			ResolveField(Z, { TEXT("z") });
+			ResolveField(R, { TEXT("red"), TEXT("r"), TEXT("diffuse_red") });
+			ResolveField(G, { TEXT("green"), TEXT("g"), TEXT("diffuse_green") });
+			ResolveField(B, { TEXT("blue"), TEXT("b"), TEXT("diffuse_blue") });
+			ResolveField(A, { TEXT("alpha"), TEXT("a"), TEXT("diffuse_alpha") });
+			ResolveField(NX, { TEXT("nx"), TEXT("normal_x") });
+			ResolveField(NY, { TEXT("ny"), TEXT("normal_y") });
+			ResolveField(NZ, { TEXT("nz"), TEXT("normal_z") });
+
+			// floats are in the 0-1 range, integers use their whole range
+			for (int32 Channel = 0; Channel < 4; Channel++)
+			{
+				const FPLYDecodeAttribute& Attribute = Fields[R + Channel];
+				if (Attribute.IsValid())
+				{
+					const FPLYProperty& Property = Element.Properties[Attribute.Property];
+					ColorScales[Channel] = Property.Type == 'F' ? 255.0f : static_cast<float>(255.0 / ((1ull << (Property.Size * 8)) - 1));
+				}
+			}
+
+			for (const FString& Name : ExtraProperties)
+			{
+				FPLYDecodeAttribute& Attribute = Extras.AddDefaulted_GetRef();
+				Resolve(Element.FindProperty(*Name), Attribute);
+			}
+
+			for (const FglTFRuntimePointCloudRangeFilter& RangeFilter : RangeFilters)
+			{
+				FPLYDecodeAttribute& Attribute = Ranges.AddDefaulted_GetRef();
+				Resolve(Element.FindProperty(*RangeFilter.Field), Attribute);
+			}
+
+			auto IsLittleEndianFloat = [&](const FPLYDecodeAttribute& Attribute)
+				{
+					return Attribute.Read == &ReadPLYComponent<float, false>;
+				};
+			bFloatXYZ = IsLittleEndianFloat(Fields[X]) && IsLittleEndianFloat(Fields[Y]) && IsLittleEndianFloat(Fields[Z]);
+		}
+
+		/* Decodes a binary vertex record */
+		FORCEINLINE FLidarPointCloudPoint Decode(const uint8* Record) const
+		{
+			if (bFloatXYZ)
+			{
+				FLidarPointCloudPoint Point = BuildPoint<false>([this, Record](const int32 Field) { return Fields[Field].Get(Record); });
+				FMemory::Memcpy(&Point.Location.X, Record + Fields[X].Offset, sizeof(float));
+				FMemory::Memcpy(&Point.Location.Y, Record + Fields[Y].Offset, sizeof(float));
+				FMemory::Memcpy(&Point.Location.Z, Record + Fields[Z].Offset, sizeof(float));
+				return Point;
+			}
+			return BuildPoint<true>([this, Record](const int32 Field) { return Fields[Field].Get(Record); });
+		}
+
+		FORCEINLINE float GetExtra(const uint8* Record, const int32 ExtraIndex) const
+		{
+			const FPLYDecodeAttribute& Attribute = Extras[ExtraIndex];
+			return Attribute.IsValid() ? static_cast<float>(Attribute.Get(Record)) : 0;
+		}
+
+		FORCEINLINE double GetRange(const uint8* Record, const int32 RangeIndex) const
+		{
+			const FPLYDecodeAttribute& Attribute = Ranges[RangeIndex];
+			return Attribute.IsValid() ? Attribute.Get(Record) : 0;
+		}
+
+		/* Parses the used properties of an ascii vertex line into Values (NumProperties elements, missing ones are 0) */
+		FORCEINLINE void ParseLine(const uint8* LineBegin, const uint8* LineEnd, double* Values) const
+		{
+			FMemory::Memzero(Values, sizeof(double) * NumProperties);
+			ForEachToken(LineBegin, LineEnd, NumProperties, [this, Values](const int32 TokenIndex, const uint8* TokenBegin, const uint8* TokenEnd)
+				{
+					if (UsedProperties[TokenIndex])
+					{
+						Values[TokenIndex] = TokenToDouble(TokenBegin, TokenEnd);
+					}
+				});
+		}
+
+		/* Builds a point from the values of an ascii line (as filled by ParseLine) */
+		FORCEINLINE FLidarPointCloudPoint Decode(const double* Values) const
+		{
+			return BuildPoint<true>([this, Values](const int32 Field) { return Values[Fields[Field].Property]; });
+		}
+
+		FORCEINLINE float GetExtra(const double* Values, const int32 ExtraIndex) const
+		{
+			const FPLYDecodeAttribute& Attribute = Extras[ExtraIndex];
+			return Attribute.IsValid() ? static_cast<float>(Values[Attribute.Property]) : 0;
+		}
+
+		FORCEINLINE double GetRange(const double* Values, const int32 RangeIndex) const
+		{
+			const FPLYDecodeAttribute& Attribute = Ranges[RangeIndex];
+			return Attribute.IsValid() ? Values[Attribute.Property] : 0;
+		}
+
+	private:
+		template<bool bWithLocation, typename GetterType>
+		FORCEINLINE FLidarPointCloudPoint BuildPoint(GetterType Get) const
+		{
+			FLidarPointCloudPoint Point;
+
+			if constexpr (bWithLocation)
+			{
+				if (Fields[X].IsValid())
+				{
+					Point.Location.X = Get(X);
+				}
+				if (Fields[Y].IsValid())
+				{
+					Point.Location.Y = Get(Y);
+				}
+				if (Fields[Z].IsValid())
+				{
+					Point.Location.Z = Get(Z);
+				}
+			}
+
+			auto GetChannel = [&](const int32 Channel)
+				{
+					return static_cast<float>(Get(R + Channel)) * ColorScales[Channel];
+				};
+
+			if (Fields[R].IsValid() && Fields[G].IsValid() && Fields[B].IsValid())
+			{
+				// values are already scaled, a missing alpha is opaque
+				Point.Color = QuantizeColor(GetChannel(0), GetChannel(1), GetChannel(2), Fields[A].IsValid() ? GetChannel(3) : 255.0f, 1.0f);
+			}
+			else
+			{
+				if (Fields[R].IsValid())
+				{
+					Point.Color.R = QuantizeColorChannel(GetChannel(0), 1.0f);
+				}
+				if (Fields[G].IsValid())
+				{
+					Point.Color.G = QuantizeColorChannel(GetChannel(1), 1.0f);
+				}
+				if (Fields[B].IsValid())
+				{
+					Point.Color.B = QuantizeColorChannel(GetChannel(2), 1.0f);
+				}
+				if (Fields[A].IsValid())
+				{
+					Point.Color.A = QuantizeColorChannel(GetChannel(3), 1.0f);
+				}
+			}
+
+			if (Fields[NX].IsValid() || Fields[NY].IsValid() || Fields[NZ].IsValid())
+			{
+				FVector3f Normal = FVector3f::ZeroVector;
+				if (Fields[NX].IsValid())
+				{
+					Normal.X = Get(NX);
+				}
+				if (Fields[NY].IsValid())
+				{
+					Normal.Y = Get(NY);
+				}
+				if (Fields[NZ].IsValid())
+				{
+					Normal.Z = Get(NZ);
+				}
+				Point.Normal = Normal;
+			}
+
+			return Point;
+		}
+	};
+}
@@ -0,0 +1,624 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/ParallelFor.h"
+#include "glTFRuntimePointCloudColor.h"
+#include "glTFRuntimePointCloudLibrary.h"
+#include "glTFRuntimePointCloudStats.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <emmintrin.h>
+#endif
+
+/*
+ * Locale-free, allocation-free helpers for parsing ASCII point clouds straight from the blob bytes.
+ * Numbers follow the strtod/atof rules: the longest valid prefix of a token is parsed, garbage gives 0.
+ */
+namespace glTFRuntimePointCloud
+{
+	FORCEINLINE bool IsSpace(const uint8 Char)
+	{
+		return Char == ' ' || Char == '\t';
+	}
+
+	FORCEINLINE bool IsNewLine(const uint8 Char)
+	{
+		return Char == '\r' || Char == '\n';
+	}
+
+	FORCEINLINE bool IsDigit(const uint8 Char)
+	{
+		return static_cast<uint8>(Char - '0') < 10;
+	}
+
+	/* slow path for the (rare) numbers that cannot be exactly computed from a 53 bits mantissa */
+	inline double ParseDoubleFallback(const uint8* Begin, const uint8* End)
+	{
+		ANSICHAR Buffer[128];
+		const int64 Len = FMath::Min<int64>(End - Begin, UE_ARRAY_COUNT(Buffer) - 1);
+		FMemory::Memcpy(Buffer, Begin, Len);
+		Buffer[Len] = 0;
+		return FCStringAnsi::Atod(Buffer);
+	}
+
+	/* Parses a decimal floating point number, returns the pointer after the last consumed char (Begin when no number is found) */
+	inline const uint8* ParseDouble(const uint8* Begin, const uint8* End, double& Value)
+	{
+		static const double Pow10[] =
+		{
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+			1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		const uint8* Ptr = Begin;
+		bool bNegative = false;
+		if (Ptr < End && (*Ptr == '-' || *Ptr == '+'))
+		{
+			bNegative = *Ptr == '-';
+			Ptr++;
+		}
+
+		uint64 Mantissa = 0;
+		int32 SignificantDigits = 0;
+		int32 Exponent = 0;
+		bool bHasDigits = false;
+		bool bExact = true;
+
+		while (Ptr < End && IsDigit(*Ptr))
+		{
+			bHasDigits = true;
+			if (SignificantDigits < 19)
+			{
+				Mantissa = Mantissa * 10 + (*Ptr - '0');
+				SignificantDigits += Mantissa > 0 ? 1 : 0;
+			}
+			else
+			{
+				Exponent++;
+				bExact = false;
+			}
+			Ptr++;
+		}
+
+		if (Ptr < End && *Ptr == '.')
+		{
+			Ptr++;
+			while (Ptr < End && IsDigit(*Ptr))
+			{
+				bHasDigits = true;
+				if (SignificantDigits < 19)
+				{
+					Mantissa = Mantissa * 10 + (*Ptr - '0');
+					SignificantDigits += Mantissa > 0 ? 1 : 0;
+					Exponent--;
+				}
+				else
+				{
+					bExact = false;
+				}
+				Ptr++;
+			}
+		}
+
+		if (!bHasDigits)
+		{
+			// inf/nan and friends
+			if (Ptr < End && (*Ptr == 'i' || *Ptr == 'I' || *Ptr == 'n' || *Ptr == 'N'))
+			{
+				Value = ParseDoubleFallback(Begin, End);
+				return End;
+			}
+			Value = 0;
+			return Begin;
+		}
+
+		if (Ptr < End && (*Ptr == 'e' || *Ptr == 'E'))
+		{
+			const uint8* ExponentPtr = Ptr + 1;
+			bool bNegativeExponent = false;
+			if (ExponentPtr < End && (*ExponentPtr == '-' || *ExponentPtr == '+'))
+			{
+				bNegativeExponent = *ExponentPtr == '-';
+				ExponentPtr++;
+			}
+
+			if (ExponentPtr < End && IsDigit(*ExponentPtr))
+			{
+				int32 ExplicitExponent = 0;
+				while (ExponentPtr < End && IsDigit(*ExponentPtr))
+				{
+					if (ExplicitExponent < 100000)
+					{
+						ExplicitExponent = ExplicitExponent * 10 + (*ExponentPtr - '0');
+					}
+					ExponentPtr++;
+				}
+				Exponent += bNegativeExponent ? -ExplicitExponent : ExplicitExponent;
+				Ptr = ExponentPtr;
+			}
+		}
+
+		if (Mantissa == 0 && bExact)
+		{
+			Value = bNegative ? -0.0 : 0.0;
+			return Ptr;
+		}
+
+		if (bExact && Mantissa <= (1ULL << 53) && Exponent >= -22 && Exponent <= 22)
+		{
+			const double Result = Exponent < 0 ? static_cast<double>(Mantissa) / Pow10[-Exponent] : static_cast<double>(Mantissa) * Pow10[Exponent];
+			Value = bNegative ? -Result : Result;
+			return Ptr;
+		}
+
+		Value = ParseDoubleFallback(Begin, Ptr);
+		return Ptr;
+	}
+
+	/* Parses a decimal integer, returns the pointer after the last consumed char (Begin when no number is found) */
+	inline const uint8* ParseInt64(const uint8* Begin, const uint8* End, int64& Value)
+	{
+		const uint8* Ptr = Begin;
+		bool bNegative = false;
+		if (Ptr < End && (*Ptr == '-' || *Ptr == '+'))
+		{
+			bNegative = *Ptr == '-';
+			Ptr++;
+		}
+
+		if (Ptr >= End || !IsDigit(*Ptr))
+		{
+			Value = 0;
+			return Begin;
+		}
+
+		uint64 Result = 0;
+		while (Ptr < End && IsDigit(*Ptr))
+		{
+			Result = Result * 10 + (*Ptr - '0');
+			Ptr++;
+		}
+
+		Value = bNegative ? -static_cast<int64>(Result) : static_cast<int64>(Result);
+		return Ptr;
+	}
+
+	FORCEINLINE double TokenToDouble(const uint8* Begin, const uint8* End)
+	{
+		double Value = 0;
+		ParseDouble(Begin, End, Value);
+		return Value;
+	}
+
+	/*
+	 * Calls Callback(TokenIndex, TokenBegin, TokenEnd) for every space/tab separated token of the line.
+	 * Scanning stops after MaxTokens tokens (unless negative). Returns the number of tokens found.
+	 */
+	template<typename CallbackType>
+	FORCEINLINE int32 ForEachToken(const uint8* Ptr, const uint8* End, const int32 MaxTokens, CallbackType&& Callback)
+	{
+		int32 TokenIndex = 0;
+		while (Ptr < End && (MaxTokens < 0 || TokenIndex < MaxTokens))
+		{
+			while (Ptr < End && IsSpace(*Ptr))
+			{
+				Ptr++;
+			}
+
+			if (Ptr >= End)
+			{
+				break;
+			}
+
+			const uint8* TokenBegin = Ptr;
+			while (Ptr < End && !IsSpace(*Ptr))
+			{
+				Ptr++;
+			}
+
+			Callback(TokenIndex++, TokenBegin, Ptr);
+		}
+		return TokenIndex;
+	}
+
+	/* Returns the first '\r' or '\n' in [Ptr, End), or End */
+	FORCEINLINE const uint8* FindNewLine(const uint8* Ptr, const uint8* End)
+	{
+#if PLATFORM_CPU_X86_FAMILY
+		const __m128i CR = _mm_set1_epi8('\r');
+		const __m128i LF = _mm_set1_epi8('\n');
+		while (End - Ptr >= 16)
+		{
+			const __m128i Bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Ptr));
+			const uint32 Mask = static_cast<uint32>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(Bytes, CR), _mm_cmpeq_epi8(Bytes, LF))));
+			if (Mask)
+			{
+				return Ptr + FMath::CountTrailingZeros(Mask);
+			}
+			Ptr += 16;
+		}
+#else
+		// SWAR: a byte is zero in (Word ^ Pattern) when it matches
+		constexpr uint64 Low = 0x0101010101010101ULL;
+		constexpr uint64 High = 0x8080808080808080ULL;
+		while (End - Ptr >= 8)
+		{
+			uint64 Word;
+			FMemory::Memcpy(&Word, Ptr, 8);
+			const uint64 CR = Word ^ (Low * '\r');
+			const uint64 LF = Word ^ (Low * '\n');
+			if (((CR - Low) & ~CR & High) | ((LF - Low) & ~LF & High))
+			{
+				break;
+			}
+			Ptr += 8;
+		}
+#endif
+		while (Ptr < End && !IsNewLine(*Ptr))
+		{
+			Ptr++;
+		}
+		return Ptr;
+	}
+
+	/* Counts the lines starting in [Begin, End): a line starts at any non-newline byte preceded by a newline (or by nothing when bPrevIsNewLine) */
+	inline int64 CountLineStarts(const uint8* Begin, const uint8* End, const bool bPrevIsNewLine)
+	{
+		int64 NumLines = 0;
+		const uint8* Ptr = Begin;
+		bool bPrevNewLine = bPrevIsNewLine;
+
+#if PLATFORM_CPU_X86_FAMILY
+		const __m128i CR = _mm_set1_epi8('\r');
+		const __m128i LF = _mm_set1_epi8('\n');
+		uint32 Carry = bPrevNewLine ? 1 : 0;
+		while (End - Ptr >= 16)
+		{
+			const __m128i Bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Ptr));
+			const uint32 Mask = static_cast<uint32>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(Bytes, CR), _mm_cmpeq_epi8(Bytes, LF))));
+			const uint32 Starts = ~Mask & ((Mask << 1) | Carry) & 0xFFFF;
+			NumLines += FMath::CountBits(Starts);
+			Carry = (Mask >> 15) & 1;
+			Ptr += 16;
+		}
+		bPrevNewLine = Carry != 0;
+#endif
+
+		while (Ptr < End)
+		{
+			const bool bNewLine = IsNewLine(*Ptr);
+			NumLines += (!bNewLine && bPrevNewLine) ? 1 : 0;
+			bPrevNewLine = bNewLine;
+			Ptr++;
+		}
+
+		return NumLines;
+	}
+
+	/* A slice of the blob, it owns every line starting in [Begin, End) even if the line ends after End */
+	struct FLineChunk
+	{
+		int64 Begin;
+		int64 End;
+		int64 NumLines;
+		int64 FirstLine;
+	};
+
+	/*
+	 * Splits [Begin, End) of Data in per-core chunks and counts the lines of each one in parallel.
+	 * Scan progress is reported as ProgressBase + scanned bytes of ProgressTotal (the size of the range when negative).
+	 * Returns the total number of lines or -1 on cancellation.
+	 */
+	inline int64 BuildLineChunks(const uint8* Data, const int64 Begin, const int64 End, TArray<FLineChunk>& Chunks, FglTFRuntimePointCloudLoadContext& Context, const int64 ProgressBase = 0, const int64 ProgressTotal = -1)
+	{
+		GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, LineScan);
+
+		constexpr int64 MinChunkSize = 256 * 1024;
+		const int64 Size = End - Begin;
+		const int64 MaxChunks = FMath::Max<int64>(1, FPlatformMisc::NumberOfCoresIncludingHyperthreads() * 8);
+		const int64 NumChunks = FMath::Clamp<int64>(Size / MinChunkSize, 1, MaxChunks);
+		const int64 ChunkSize = (Size + NumChunks - 1) / NumChunks;
+
+		Chunks.Reset(NumChunks);
+		for (int64 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+		{
+			FLineChunk Chunk;
+			Chunk.Begin = FMath::Min(Begin + ChunkIndex * ChunkSize, End);
+			Chunk.End = FMath::Min(Chunk.Begin + ChunkSize, End);
+			Chunk.NumLines = 0;
+			Chunk.FirstLine = 0;
+			Chunks.Add(Chunk);
+		}
+
+		std::atomic<int64> ScannedBytes = ProgressBase;
+		const int64 TotalBytes = ProgressTotal < 0 ? Size : ProgressTotal;
+
+		ParallelFor(Chunks.Num(), [&](const int32 ChunkIndex)
+			{
+				if (Context.IsCanceled())
+				{
+					return;
+				}
+
+				FLineChunk& Chunk = Chunks[ChunkIndex];
+				const bool bPrevIsNewLine = Chunk.Begin == Begin || IsNewLine(Data[Chunk.Begin - 1]);
+				Chunk.NumLines = CountLineStarts(Data + Chunk.Begin, Data + Chunk.End, bPrevIsNewLine);
+
+				Context.ReportProgress(EglTFRuntimePointCloudLoadPhase::LineScan, ScannedBytes += Chunk.End - Chunk.Begin, TotalBytes);
+			});
+
+		if (Context.IsCanceled())
+		{
+			return -1;
+		}
+
+		int64 NumLines = 0;
+		for (FLineChunk& Chunk : Chunks)
+		{
+			Chunk.FirstLine = NumLines;
+			NumLines += Chunk.NumLines;
+		}
+
+		return NumLines;
+	}
+
+	/* Calls Callback(LineBegin, LineEnd) for every line owned by the chunk, DataEnd is the end of the whole parsable region */
+	template<typename CallbackType>
+	FORCEINLINE void ForEachLine(const uint8* Data, const int64 DataBegin, const int64 DataEnd, const FLineChunk& Chunk, CallbackType&& Callback)
+	{
+		const uint8* Ptr = Data + Chunk.Begin;
+		const uint8* ChunkEnd = Data + Chunk.End;
+		const uint8* End = Data + DataEnd;
+
+		// resync: a line crossing the chunk start belongs to the previous chunk
+		if (Chunk.Begin > DataBegin && !IsNewLine(Data[Chunk.Begin - 1]))
+		{
+			Ptr = FindNewLine(Ptr, End);
+		}
+
+		for (;;)
+		{
+			while (Ptr < ChunkEnd && IsNewLine(*Ptr))
+			{
+				Ptr++;
+			}
+
+			if (Ptr >= ChunkEnd)
+			{
+				break;
+			}
+
+			const uint8* LineEnd = FindNewLine(Ptr, End);
+			Callback(Ptr, LineEnd);
+			Ptr = LineEnd;
+		}
+	}
+
+	/* Skips the first NumLines (non empty) lines, returns the offset of the following byte or -1 if there are not enough lines */
+	inline int64 SkipLines(const uint8* Data, const int64 Begin, const int64 End, const int64 NumLines)
+	{
+		const uint8* Ptr = Data + Begin;
+		const uint8* DataEnd = Data + End;
+		for (int64 LineIndex = 0; LineIndex < NumLines; LineIndex++)
+		{
+			while (Ptr < DataEnd && IsNewLine(*Ptr))
+			{
+				Ptr++;
+			}
+
+			if (Ptr >= DataEnd)
+			{
+				return -1;
+			}
+
+			Ptr = FindNewLine(Ptr, DataEnd);
+		}
+		return Ptr - Data;
+	}
+
+	/* Prepares the line chunks of an ASCII blob after skipping its first LinesToSkip lines, returns the number of lines or -1 on error/cancellation */
+	inline int64 BuildLineChunksSkippingLines(const TArray64<uint8>& Blob, const int32 LinesToSkip, int64& DataBegin, TArray<FLineChunk>& Chunks, FglTFRuntimePointCloudLoadContext& Context)
+	{
+		if (LinesToSkip < 0)
+		{
+			return -1;
+		}
+
+		DataBegin = SkipLines(Blob.GetData(), 0, Blob.Num(), LinesToSkip);
+		if (DataBegin < 0)
+		{
+			return -1;
+		}
+
+		return BuildLineChunks(Blob.GetData(), DataBegin, Blob.Num(), Chunks, Context);
+	}
+
+	/* Maps the configured ASCII columns (plus any extra or range filter column) to value slots, so that unused columns are skipped without being converted */
+	struct FASCIIColumns
+	{
+		enum EField
+		{
+			X, Y, Z,
+			R, G, B,
+			NX, NY, NZ,
+			A,
+			NumFields
+		};
+
+		int32 FieldColumns[NumFields];
+		int32 FieldSlots[NumFields];
+		TArray<int32> ExtraColumns;
+		TArray<int32> ExtraSlots;
+		TArray<int32> RangeColumns;
+		TArray<int32> RangeSlots;
+		TArray<int32> ColumnToSlot;
+		int32 NumSlots;
+		float ColorScale;
+
+		FASCIIColumns(const FglTFRuntimeASCIIPointCloudConfig& Config, const TArray<int32>& InExtraColumns, const TArray<FglTFRuntimePointCloudRangeFilter>& RangeFilters)
+		{
+			const int32 Columns[NumFields] =
+			{
+				Config.XYZColumns.X, Config.XYZColumns.Y, Config.XYZColumns.Z,
+				Config.RGBColumns.X, Config.RGBColumns.Y, Config.RGBColumns.Z,
+				Config.NormalColumns.X, Config.NormalColumns.Y, Config.NormalColumns.Z,
+				Config.AlphaColumn
+			};
+
+			NumSlots = 0;
+			ColorScale = Config.bFloatColors ? 255 : 1;
+
+			for (int32 Field = 0; Field < NumFields; Field++)
+			{
+				FieldColumns[Field] = Columns[Field];
+				FieldSlots[Field] = AddColumn(Columns[Field]);
+			}
+
+			ExtraColumns = InExtraColumns;
+			for (const int32 Column : ExtraColumns)
+			{
+				ExtraSlots.Add(AddColumn(Column));
+			}
+
+			for (const FglTFRuntimePointCloudRangeFilter& RangeFilter : RangeFilters)
+			{
+				RangeColumns.Add(RangeFilter.Column);
+				RangeSlots.Add(AddColumn(RangeFilter.Column));
+			}
+		}
+
+		int32 AddColumn(const int32 Column)
+		{
+			if (Column < 0)
+			{
+				return -1;
+			}
+
+			while (ColumnToSlot.Num() <= Column)
+			{
+				ColumnToSlot.Add(-1);
+			}
+
+			if (ColumnToSlot[Column] < 0)
+			{
+				ColumnToSlot[Column] = NumSlots++;
+			}
+
+			return ColumnToSlot[Column];
+		}
+
+		/* Parses only the mapped columns of a line into Values (NumSlots elements), returns the number of scanned tokens */
+		FORCEINLINE int32 ParseLine(const uint8* LineBegin, const uint8* LineEnd, double* Values) const
+		{
+			return ForEachToken(LineBegin, LineEnd, ColumnToSlot.Num(), [this, Values](const int32 TokenIndex, const uint8* TokenBegin, const uint8* TokenEnd)
+				{
+					const int32 Slot = ColumnToSlot[TokenIndex];
+					if (Slot >= 0)
+					{
+						Values[Slot] = TokenToDouble(TokenBegin, TokenEnd);
+					}
+				});
+		}
+
+		FORCEINLINE bool HasColumn(const int32 Column, const int32 NumTokens) const
+		{
+			return Column >= 0 && Column < NumTokens;
+		}
+
+		FORCEINLINE double GetExtra(const double* Values, const int32 ExtraIndex, const int32 NumTokens) const
+		{
+			return HasColumn(ExtraColumns[ExtraIndex], NumTokens) ? Values[ExtraSlots[ExtraIndex]] : 0;
+		}
+
+		FORCEINLINE double GetRange(const double* Values, const int32 RangeIndex, const int32 NumTokens) const
+		{
+			return HasColumn(RangeColumns[RangeIndex], NumTokens) ? Values[RangeSlots[RangeIndex]] : 0;
+		}
+
+		/* Builds a point from slot values (as filled by ParseLine) */
+		FORCEINLINE FLidarPointCloudPoint BuildPoint(const double* Values, const int32 NumTokens) const
+		{
+			return BuildPointInternal(NumTokens, [this, Values](const int32 Field) { return Values[FieldSlots[Field]]; });
+		}
+
+		/* Builds a point from a fully parsed line (one value per column) */
+		FORCEINLINE FLidarPointCloudPoint BuildPointFromColumns(const double* Line, const int32 NumTokens) const
+		{
+			return BuildPointInternal(NumTokens, [this, Line](const int32 Field) { return Line[FieldColumns[Field]]; });
+		}
+
+	private:
+		template<typename GetterType>
+		FORCEINLINE FLidarPointCloudPoint BuildPointInternal(const int32 NumTokens, GetterType Get) const
+		{
+			FLidarPointCloudPoint Point;
+
+			if (HasColumn(FieldColumns[X], NumTokens))
+			{
+				Point.Location.X = Get(X);
+			}
+
+			if (HasColumn(FieldColumns[Y], NumTokens))
+			{
+				Point.Location.Y = Get(Y);
+			}
+
+			if (HasColumn(FieldColumns[Z], NumTokens))
+			{
+				Point.Location.Z = Get(Z);
+			}
+
+			const bool bHasAlpha = HasColumn(FieldColumns[A], NumTokens);
+
+			if (HasColumn(FieldColumns[R], NumTokens) && HasColumn(FieldColumns[G], NumTokens) && HasColumn(FieldColumns[B], NumTokens))
+			{
+				// a missing alpha maps to 255 after scaling
+				Point.Color = QuantizeColor(static_cast<float>(Get(R)), static_cast<float>(Get(G)), static_cast<float>(Get(B)), bHasAlpha ? static_cast<float>(Get(A)) : 255.0f / ColorScale, ColorScale);
+			}
+			else
+			{
+				if (HasColumn(FieldColumns[R], NumTokens))
+				{
+					Point.Color.R = QuantizeColorChannel(static_cast<float>(Get(R)), ColorScale);
+				}
+
+				if (HasColumn(FieldColumns[G], NumTokens))
+				{
+					Point.Color.G = QuantizeColorChannel(static_cast<float>(Get(G)), ColorScale);
+				}
+
+				if (HasColumn(FieldColumns[B], NumTokens))
+				{
+					Point.Color.B = QuantizeColorChannel(static_cast<float>(Get(B)), ColorScale);
+				}
+
+				if (bHasAlpha)
+				{
+					Point.Color.A = QuantizeColorChannel(static_cast<float>(Get(A)), ColorScale);
+				}
+			}
+
+			if (HasColumn(FieldColumns[NX], NumTokens) || HasColumn(FieldColumns[NY], NumTokens) || HasColumn(FieldColumns[NZ], NumTokens))
+			{
+				FVector3f Normal = FVector3f::ZeroVector;
+				if (HasColumn(FieldColumns[NX], NumTokens))
+				{
+					Normal.X = Get(NX);
+				}
+				if (HasColumn(FieldColumns[NY], NumTokens))
+				{
+					Normal.Y = Get(NY);
+				}
+				if (HasColumn(FieldColumns[NZ], NumTokens))
+				{
+					Normal.Z = Get(NZ);
+				}
+				Point.Normal = Normal;
+			}
+
+			return Point;
+		}
+	};
+}
@@ -0,0 +1,571 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/ParallelFor.h"
+#include "glTFRuntimePointCloudFilter.h"
+#include "glTFRuntimePointCloudLibrary.h"
+#include "glTFRuntimePointCloudStats.h"
+#include "Misc/ScopeLock.h"
+
+namespace glTFRuntimePointCloud
+{
+	/* Running sums of the points falling in a voxel */
+	struct FVoxel
+	{
+		FVector Location = FVector::ZeroVector;
+		FVector3f Normal = FVector3f::ZeroVector;
+		uint64 Color[4] = {};
+		int64 Count = 0;
+		uint8 ClassificationID = 0;
+
+		FORCEINLINE void Add(const FLidarPointCloudPoint& Point)
+		{
+			if (Count == 0)
+			{
+				ClassificationID = Point.ClassificationID;
+			}
+			Location += FVector(Point.Location);
+			Normal += Point.Normal.ToVector();
+			Color[0] += Point.Color.R;
+			Color[1] += Point.Color.G;
+			Color[2] += Point.Color.B;
+			Color[3] += Point.Color.A;
+			Count++;
+		}
+
+		void Merge(const FVoxel& Other)
+		{
+			if (Count == 0)
+			{
+				ClassificationID = Other.ClassificationID;
+			}
+			Location += Other.Location;
+			Normal += Other.Normal;
+			for (int32 Channel = 0; Channel < 4; Channel++)
+			{
+				Color[Channel] += Other.Color[Channel];
+			}
+			Count += Other.Count;
+		}
+
+		FLidarPointCloudPoint ToPoint() const
+		{
+			FLidarPointCloudPoint Point;
+			Point.Location = FVector3f(Location / static_cast<double>(Count));
+			Point.Color = FColor(
+				static_cast<uint8>((Color[0] + Count / 2) / Count),
+				static_cast<uint8>((Color[1] + Count / 2) / Count),
+				static_cast<uint8>((Color[2] + Count / 2) / Count),
+				static_cast<uint8>((Color[3] + Count / 2) / Count));
+			Point.Normal = Normal.GetSafeNormal();
+			Point.ClassificationID = ClassificationID;
+			return Point;
+		}
+	};
+
+	/*
+	 * Destination of the decoded points of a loader, it applies the decimation and the filters of the load configuration.
+	 * Stride and target count decimation map input indices to output ones, so rejected points are never decoded.
+	 * Stride remainder keeps the complement of Stride: the two passes of a progressive load decode every point exactly once.
+	 * Voxel-grid decimation accumulates per worker cells merged in a sharded grid, memory follows the output size.
+	 * When filtering, every writer collects its (ordered) segment of accepted points, segments are joined in input order at the end.
+	 */
+	class FPointSink
+	{
+	public:
+		FPointSink(TArray64<FLidarPointCloudPoint>& InPoints, const FglTFRuntimePointCloudConfig& Config) : Points(InPoints), Filter(Config)
+		{
+			Mode = Config.Decimation;
+			Stride = FMath::Max(1, Config.DecimationStride);
+			TargetPointCount = FMath::Max(0, Config.DecimationTargetPointCount);
+			InvVoxelSize = Config.DecimationVoxelSize > 0 ? 1.0 / Config.DecimationVoxelSize : 0;
+
+			if ((Mode == EglTFRuntimePointCloudDecimation::Stride && Stride == 1) || (Mode == EglTFRuntimePointCloudDecimation::VoxelGrid && InvVoxelSize <= 0))
+			{
+				Mode = EglTFRuntimePointCloudDecimation::None;
+			}
+
+			bCompact = Filter.IsEnabled() && Mode != EglTFRuntimePointCloudDecimation::VoxelGrid;
+		}
+
+		/* Must be called before decoding, the output is preallocated for all of the modes except the voxel grid */
+		bool Begin(const int64 InNumInputPoints)
+		{
+			NumInputPoints = InNumInputPoints;
+			NumPointsBefore = Points.Num();
+
+			if (Mode == EglTFRuntimePointCloudDecimation::TargetPointCount && TargetPointCount >= NumInputPoints)
+			{
+				Mode = EglTFRuntimePointCloudDecimation::None;
+			}
+
+			int64 NumOutputPoints = NumInputPoints;
+			switch (Mode)
+			{
+			case EglTFRuntimePointCloudDecimation::Stride:
+				NumOutputPoints = (NumInputPoints + Stride - 1) / Stride;
+				break;
+			case EglTFRuntimePointCloudDecimation::StrideRemainder:
+				NumOutputPoints = NumInputPoints - (NumInputPoints + Stride - 1) / Stride;
+				break;
+			case EglTFRuntimePointCloudDecimation::TargetPointCount:
+				NumOutputPoints = TargetPointCount;
+				break;
+			case EglTFRuntimePointCloudDecimation::VoxelGrid:
+				NumOutputPoints = 0;
+				break;
+			default:
+				break;
+			}
+
+			// InputIndex * TargetPointCount must fit in 64 bits: input indices are grouped by 2^TargetShift and only the first of a group is selected
+			TargetShift = 0;
+			if (Mode == EglTFRuntimePointCloudDecimation::TargetPointCount && TargetPointCount > 0)
+			{
+				while (((NumInputPoints - 1) >> TargetShift) > MAX_int64 / TargetPointCount)
+				{
+					TargetShift++;
+				}
+			}
+			TargetMask = (static_cast<int64>(1) << TargetShift) - 1;
+			TargetInputPoints = NumInputPoints > 0 ? ((NumInputPoints - 1) >> TargetShift) + 1 : 0;
+
+			// the size of the filtered output is known only at the end
+			if (bCompact)
+			{
+				NumOutputPoints = 0;
+			}
+
+			FirstOutputPoint = Points.AddUninitialized(NumOutputPoints);
+			return true;
+		}
+
+		/* Without decimation and filters every point is stored at its input index */
+		bool IsPassthrough() const
+		{
+			return Mode == EglTFRuntimePointCloudDecimation::None && !bCompact;
+		}
+
+		bool HasRanges() const
+		{
+			return Filter.HasRanges();
+		}
+
+		FLidarPointCloudPoint* GetOutput(const int64 InputIndex)
+		{
+			return Points.GetData() + FirstOutputPoint + InputIndex;
+		}
+
+		FORCEINLINE bool Accepts(const int64 InputIndex) const
+		{
+			switch (Mode)
+			{
+			case EglTFRuntimePointCloudDecimation::Stride:
+				return InputIndex % Stride == 0;
+			case EglTFRuntimePointCloudDecimation::StrideRemainder:
+				return InputIndex % Stride != 0;
+			case EglTFRuntimePointCloudDecimation::TargetPointCount:
+				// the first input index of every output point, exactly TargetPointCount evenly spread points
+				return (InputIndex & TargetMask) == 0 && ((InputIndex >> TargetShift) * TargetPointCount) % TargetInputPoints < TargetPointCount;
+			default:
+				return true;
+			}
+		}
+
+		/* Builds the voxel grid points or joins the filtered segments (nothing to do for the other modes) and updates the load report */
+		bool End(FglTFRuntimePointCloudLoadContext& Context)
+		{
+			GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, Filter);
+
+			const bool bSuccess = Finalize(Context);
+
+			const int64 NumOutputPoints = Points.Num() - NumPointsBefore;
+			Context.Report.NumInputPoints += NumInputPoints;
+			Context.Report.NumAcceptedPoints += NumOutputPoints;
+			Context.Report.BytesAllocated += NumOutputPoints * static_cast<int64>(sizeof(FLidarPointCloudPoint));
+
+			return bSuccess;
+		}
+
+		/* Per task front end of the sink, voxels are accumulated locally and merged when flushed (or destroyed) */
+		class FWriter
+		{
+		public:
+			FWriter(FPointSink& InSink) : Sink(InSink)
+			{
+			}
+
+			~FWriter()
+			{
+				Flush();
+			}
+
+			FORCEINLINE bool Accepts(const int64 InputIndex) const
+			{
+				return Sink.Accepts(InputIndex);
+			}
+
+			/* Evaluates the range filters (see FPointFilter::AcceptsRanges), call it only when the sink HasRanges() */
+			template<typename GetterType>
+			FORCEINLINE bool AcceptsRanges(GetterType GetValue)
+			{
+				if (Sink.Filter.AcceptsRanges(GetValue))
+				{
+					return true;
+				}
+				NumRejectedPoints++;
+				return false;
+			}
+
+			/* Column version of AcceptsRanges (see FPointFilter::MaskRanges), call it only when the sink HasRanges() */
+			void MaskRanges(const double* Values, const int32 ColumnStride, const int32 NumPoints, uint8* Mask)
+			{
+				Sink.Filter.MaskRanges(Values, ColumnStride, NumPoints, Mask);
+				for (int32 PointIndex = 0; PointIndex < NumPoints; PointIndex++)
+				{
+					NumRejectedPoints += 1 - Mask[PointIndex];
+				}
+			}
+
+			/* InputIndex must be accepted, input indices must be increasing */
+			FORCEINLINE void Add(const int64 InputIndex, const FLidarPointCloudPoint& Point)
+			{
+				if (Sink.Filter.HasCropBox() && !Sink.Filter.AcceptsLocation(Point.Location))
+				{
+					NumRejectedPoints++;
+					return;
+				}
+
+				if (Sink.bCompact)
+				{
+					if (Segment.Num() == 0)
+					{
+						SegmentFirstInputIndex = InputIndex;
+					}
+					Segment.Add(Point);
+					return;
+				}
+
+				switch (Sink.Mode)
+				{
+				case EglTFRuntimePointCloudDecimation::Stride:
+					Sink.Points[Sink.FirstOutputPoint + InputIndex / Sink.Stride] = Point;
+					break;
+				case EglTFRuntimePointCloudDecimation::StrideRemainder:
+					Sink.Points[Sink.FirstOutputPoint + InputIndex - InputIndex / Sink.Stride - 1] = Point;
+					break;
+				case EglTFRuntimePointCloudDecimation::TargetPointCount:
+					Sink.Points[Sink.FirstOutputPoint + ((InputIndex >> Sink.TargetShift) * Sink.TargetPointCount) / Sink.TargetInputPoints] = Point;
+					break;
+				case EglTFRuntimePointCloudDecimation::VoxelGrid:
+					AddToVoxel(Point);
+					break;
+				default:
+					Sink.Points[Sink.FirstOutputPoint + InputIndex] = Point;
+					break;
+				}
+			}
+
+			void Flush()
+			{
+				if (NumRejectedPoints > 0)
+				{
+					Sink.NumRejectedPoints += NumRejectedPoints;
+					NumRejectedPoints = 0;
+				}
+
+				if (Segment.Num() > 0)
+				{
+					FScopeLock Lock(&Sink.SegmentsLock);
+					Sink.Segments.Add({ SegmentFirstInputIndex, MoveTemp(Segment) });
+				}
+
+				if (Cells.Num() == 0)
+				{
+					return;
+				}
+
+				TArray<TPair<FIntVector, FVoxel>> Buckets[NumShards];
+				for (const TPair<FIntVector, FVoxel>& Pair : Cells)
+				{
+					Buckets[GetTypeHash(Pair.Key) % NumShards].Add(Pair);
+				}
+				Cells.Reset();
+
+				for (int32 ShardIndex = 0; ShardIndex < NumShards; ShardIndex++)
+				{
+					if (Buckets[ShardIndex].Num() == 0)
+					{
+						continue;
+					}
+
+					FShard& Shard = Sink.Shards[ShardIndex];
+					FScopeLock Lock(&Shard.Lock);
+					for (const TPair<FIntVector, FVoxel>& Pair : Buckets[ShardIndex])
+					{
+						Shard.Cells.FindOrAdd(Pair.Key).Merge(Pair.Value);
+					}
+				}
+			}
+
+		private:
+			/* bounds the local grid of tasks covering huge ranges */
+			static constexpr int32 MaxLocalCells = 64 * 1024;
+
+			FPointSink& Sink;
+			TMap<FIntVector, FVoxel> Cells;
+			TArray64<FLidarPointCloudPoint> Segment;
+			int64 SegmentFirstInputIndex = 0;
+			int64 NumRejectedPoints = 0;
+
+			FORCEINLINE void AddToVoxel(const FLidarPointCloudPoint& Point)
+			{
+				const FIntVector Key(
+					FMath::FloorToInt(Point.Location.X * Sink.InvVoxelSize),
+					FMath::FloorToInt(Point.Location.Y * Sink.InvVoxelSize),
+					FMath::FloorToInt(Point.Location.Z * Sink.InvVoxelSize));
+
+				Cells.FindOrAdd(Key).Add(Point);
+
+				if (Cells.Num() >= MaxLocalCells)
+				{
+					Flush();
+				}
+			}
+		};
+
+	private:
+		static constexpr int32 NumShards = 64;
+
+		struct FShard
+		{
+			FCriticalSection Lock;
+			TMap<FIntVector, FVoxel> Cells;
+		};
+
+		struct FSegment
+		{
+			int64 FirstInputIndex;
+			TArray64<FLidarPointCloudPoint> Points;
+		};
+
+		bool Finalize(FglTFRuntimePointCloudLoadContext& Context)
+		{
+			if (Filter.IsEnabled())
+			{
+				Context.NumRejectedPoints += NumRejectedPoints;
+				UE_LOG(LogGLTFRuntime, Log, TEXT("Filtered out %lld points"), NumRejectedPoints.load());
+			}
+
+			if (Context.IsCanceled())
+			{
+				return false;
+			}
+
+			if (bCompact)
+			{
+				return JoinSegments();
+			}
+
+			if (Mode != EglTFRuntimePointCloudDecimation::VoxelGrid)
+			{
+				return true;
+			}
+
+			int64 ShardOffsets[NumShards];
+			int64 NumOutputPoints = 0;
+			for (int32 ShardIndex = 0; ShardIndex < NumShards; ShardIndex++)
+			{
+				ShardOffsets[ShardIndex] = NumOutputPoints;
+				NumOutputPoints += Shards[ShardIndex].Cells.Num();
+			}
+
+			FirstOutputPoint = Points.AddUninitialized(NumOutputPoints);
+
+			ParallelFor(NumShards, [&](const int32 ShardIndex)
+				{
+					FLidarPointCloudPoint* Output = Points.GetData() + FirstOutputPoint + ShardOffsets[ShardIndex];
+					for (const TPair<FIntVector, FVoxel>& Pair : Shards[ShardIndex].Cells)
+					{
+						*Output++ = Pair.Value.ToPoint();
+					}
+					Shards[ShardIndex].Cells.Empty();
+				});
+
+			return true;
+		}
+
+		bool JoinSegments()
+		{
+			Segments.Sort([](const FSegment& A, const FSegment& B) { return A.FirstInputIndex < B.FirstInputIndex; });
+
+			TArray<int64> SegmentOffsets;
+			SegmentOffsets.AddUninitialized(Segments.Num());
+			int64 NumOutputPoints = 0;
+			for (int32 SegmentIndex = 0; SegmentIndex < Segments.Num(); SegmentIndex++)
+			{
+				SegmentOffsets[SegmentIndex] = NumOutputPoints;
+				NumOutputPoints += Segments[SegmentIndex].Points.Num();
+			}
+
+			FirstOutputPoint = Points.AddUninitialized(NumOutputPoints);
+
+			ParallelFor(Segments.Num(), [&](const int32 SegmentIndex)
+				{
+					TArray64<FLidarPointCloudPoint>& SegmentPoints = Segments[SegmentIndex].Points;
+					FMemory::Memcpy(Points.GetData() + FirstOutputPoint + SegmentOffsets[SegmentIndex], SegmentPoints.GetData(), SegmentPoints.Num() * sizeof(FLidarPointCloudPoint));
+					SegmentPoints.Empty();
+				});
+
+			Segments.Empty();
+
+			return true;
+		}
+
+		TArray64<FLidarPointCloudPoint>& Points;
+		EglTFRuntimePointCloudDecimation Mode = EglTFRuntimePointCloudDecimation::None;
+		int64 Stride = 1;
+		int64 TargetPointCount = 0;
+		double InvVoxelSize = 0;
+		int64 NumInputPoints = 0;
+		int32 TargetShift = 0;
+		int64 TargetMask = 0;
+		int64 TargetInputPoints = 0;
+		int64 FirstOutputPoint = 0;
+		int64 NumPointsBefore = 0;
+		FShard Shards[NumShards];
+		FPointFilter Filter;
+		bool bCompact = false;
+		FCriticalSection SegmentsLock;
+		TArray<FSegment> Segments;
+		std::atomic<int64> NumRejectedPoints = 0;
+	};
+
+	/*
+	 * Groups consecutive input points in batches for a FglTFRuntimePointCloudBatchFilter.
+	 * The filter runs on a local copy of the batch, filtered points are then passed to the sink writer.
+	 */
+	class FBatchBuilder
+	{
+	public:
+		FBatchBuilder(FPointSink::FWriter& InWriter, const FglTFRuntimePointCloudBatchFilter& InBatchFilter, const int32 InNumExtras) : Writer(InWriter), BatchFilter(InBatchFilter), NumExtras(InNumExtras)
+		{
+			if (BatchFilter)
+			{
+				BatchPoints.AddUninitialized(FglTFRuntimePointCloudBatch::MaxPoints);
+				ColumnsData.AddUninitialized(NumExtras * FglTFRuntimePointCloudBatch::MaxPoints);
+			}
+		}
+
+		/* Input indices must be increasing, a gap (a point dropped by the range filters) starts a new batch */
+		template<typename GetterType>
+		FORCEINLINE void Add(const int64 InputIndex, const FLidarPointCloudPoint& Point, GetterType GetExtra)
+		{
+			if (BatchNum > 0 && InputIndex != FirstPointIndex + BatchNum)
+			{
+				Flush();
+			}
+
+			if (BatchNum == 0)
+			{
+				FirstPointIndex = InputIndex;
+			}
+
+			BatchPoints[BatchNum] = Point;
+			for (int32 ExtraIndex = 0; ExtraIndex < NumExtras; ExtraIndex++)
+			{
+				ColumnsData[ExtraIndex * FglTFRuntimePointCloudBatch::MaxPoints + BatchNum] = GetExtra(ExtraIndex);
+			}
+
+			if (++BatchNum == FglTFRuntimePointCloudBatch::MaxPoints)
+			{
+				Flush();
+			}
+		}
+
+		void Flush()
+		{
+			if (BatchNum == 0)
+			{
+				return;
+			}
+
+			FglTFRuntimePointCloudBatch Batch;
+			Batch.FirstPointIndex = FirstPointIndex;
+			Batch.Points = TArrayView<FLidarPointCloudPoint>(BatchPoints.GetData(), BatchNum);
+			for (int32 ExtraIndex = 0; ExtraIndex < NumExtras; ExtraIndex++)
+			{
+				Batch.Columns.Add(TArrayView<const float>(ColumnsData.GetData() + ExtraIndex * FglTFRuntimePointCloudBatch::MaxPoints, BatchNum));
+			}
+			BatchFilter(Batch);
+
+			for (int32 PointIndex = 0; PointIndex < BatchNum; PointIndex++)
+			{
+				if (Writer.Accepts(FirstPointIndex + PointIndex))
+				{
+					Writer.Add(FirstPointIndex + PointIndex, BatchPoints[PointIndex]);
+				}
+			}
+
+			BatchNum = 0;
+		}
+
+	private:
+		FPointSink::FWriter& Writer;
+		const FglTFRuntimePointCloudBatchFilter& BatchFilter;
+		const int32 NumExtras;
+		TArray64<FLidarPointCloudPoint> BatchPoints;
+		/* structure of arrays: ColumnsData[ExtraIndex * MaxPoints + PointIndexInBatch] */
+		TArray<float> ColumnsData;
+		int64 FirstPointIndex = 0;
+		int32 BatchNum = 0;
+	};
+
+	/*
+	 * Configuration of a window of a streamed load (points [FirstPoint, FirstPoint + NumPoints) of NumTotalPoints).
+	 * The target point count is split between the windows proportionally to their size, the other modes apply per window.
+	 */
+	inline FglTFRuntimePointCloudConfig MakeWindowConfig(const FglTFRuntimePointCloudConfig& Config, const int64 FirstPoint, const int64 NumPoints, const int64 NumTotalPoints)
+	{
+		FglTFRuntimePointCloudConfig WindowConfig = Config;
+		if (Config.Decimation == EglTFRuntimePointCloudDecimation::TargetPointCount && NumTotalPoints > 0)
+		{
+			const double TargetPointCount = FMath::Max(0, Config.DecimationTargetPointCount);
+			const int64 LastTarget = static_cast<int64>(TargetPointCount * (FirstPoint + NumPoints) / NumTotalPoints);
+			const int64 FirstTarget = static_cast<int64>(TargetPointCount * FirstPoint / NumTotalPoints);
+			WindowConfig.DecimationTargetPointCount = static_cast<int32>(LastTarget - FirstTarget);
+		}
+		return WindowConfig;
+	}
+
+	/* Appends the config values changing the loaded points to a cache key configuration */
+	inline void AppendConfigurationKey(const FglTFRuntimePointCloudConfig& Config, TArray<int32>& Configuration)
+	{
+		int32 VoxelSizeBits;
+		FMemory::Memcpy(&VoxelSizeBits, &Config.DecimationVoxelSize, sizeof(int32));
+
+		Configuration.Add(static_cast<int32>(Config.Decimation));
+		Configuration.Add(Config.DecimationStride);
+		Configuration.Add(Config.DecimationTargetPointCount);
+		Configuration.Add(VoxelSizeBits);
+
+		if (Config.CropBox.IsValid)
+		{
+			const FVector Values[] = { Config.CropBox.Min, Config.CropBox.Max, Config.CropBoxTransform.GetLocation(), Config.CropBoxTransform.GetRotation().Euler(), Config.CropBoxTransform.GetScale3D() };
+			for (const FVector& Value : Values)
+			{
+				Configuration.Add(static_cast<int32>(GetTypeHash(Value)));
+			}
+		}
+
+		for (const FglTFRuntimePointCloudRangeFilter& RangeFilter : Config.RangeFilters)
+		{
+			Configuration.Add(RangeFilter.Column);
+			Configuration.Add(static_cast<int32>(GetTypeHash(RangeFilter.Field)));
+			Configuration.Add(static_cast<int32>(GetTypeHash(RangeFilter.Min)));
+			Configuration.Add(static_cast<int32>(GetTypeHash(RangeFilter.Max)));
+		}
+	}
+}
@@ -0,0 +1,235 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/ParallelFor.h"
+#include "glTFRuntimePointCloudLibrary.h"
+#include "glTFRuntimePointCloudStats.h"
+
+/*
+ * Morton (Z) order of the points: consecutive points fall in the same octree nodes, so the octree build walks memory sequentially.
+ * Keys are 16 bits per axis of a cube enclosing the bounds, sorted with a stable parallel LSD radix sort (8 bits per pass) moving the input indices with the keys.
+ *
+ * Peak extra memory while sorting: 24 bytes per point (two 8 bytes keys and two 4 bytes indices), the points are not duplicated.
+ * The build time gain depends on the input order and on the hardware, measure it with the benchmark commandlet:
+ * -run=glTFRuntimePointCloudBenchmark -Sizes=20M,100M with and without -Sort, comparing phases.sort + phases.octree_build and peak_used_physical.
+ * No measurement has been recorded yet, so bSortPoints stays off by default.
+ */
+namespace glTFRuntimePointCloud
+{
+	constexpr int64 SortPointsPerBlock = 256 * 1024;
+	constexpr int32 SortRadixBits = 8;
+	constexpr int32 SortRadixBuckets = 1 << SortRadixBits;
+	constexpr int32 SortMortonBitsPerAxis = 16;
+
+	/* Inserts two zero bits before every one of the low 16 bits */
+	FORCEINLINE uint64 SpreadMortonBits(uint64 Value)
+	{
+		Value &= 0xFFFF;
+		Value = (Value | (Value << 32)) & 0x1F00000000FFFFull;
+		Value = (Value | (Value << 16)) & 0x1F0000FF0000FFull;
+		Value = (Value | (Value << 8)) & 0x100F00F00F00F00Full;
+		Value = (Value | (Value << 4)) & 0x10C30C30C30C30C3ull;
+		Value = (Value | (Value << 2)) & 0x1249249249249249ull;
+		return Value;
+	}
+
+	/* Maps the bounds to the 16 bits cells of every axis, 0 when all of the points are in the same place */
+	FORCEINLINE float GetMortonScale(const FBox3f& Bounds)
+	{
+		const float Size = Bounds.GetSize().GetMax();
+		return Size > 0 ? ((1 << SortMortonBitsPerAxis) - 1) / Size : 0;
+	}
+
+	FORCEINLINE uint64 GetMortonKey(const FVector3f& Location, const FVector3f& Min, const float Scale)
+	{
+		const FVector3f Cell = (Location - Min) * Scale;
+		return
+			SpreadMortonBits(static_cast<uint64>(Cell.X)) |
+			(SpreadMortonBits(static_cast<uint64>(Cell.Y)) << 1) |
+			(SpreadMortonBits(static_cast<uint64>(Cell.Z)) << 2);
+	}
+
+	inline FBox3f ComputePointsBounds(const TArray64<FLidarPointCloudPoint>& Points)
+	{
+		const int32 NumBlocks = static_cast<int32>((Points.Num() + SortPointsPerBlock - 1) / SortPointsPerBlock);
+		TArray<FBox3f> BlocksBounds;
+		BlocksBounds.Init(FBox3f(ForceInit), NumBlocks);
+
+		ParallelFor(NumBlocks, [&](const int32 BlockIndex)
+			{
+				const int64 FirstPoint = BlockIndex * SortPointsPerBlock;
+				const int64 LastPoint = FMath::Min(FirstPoint + SortPointsPerBlock, Points.Num());
+				FBox3f& Bounds = BlocksBounds[BlockIndex];
+				for (int64 PointIndex = FirstPoint; PointIndex < LastPoint; PointIndex++)
+				{
+					Bounds += Points[PointIndex].Location;
+				}
+			});
+
+		FBox3f Bounds(ForceInit);
+		for (const FBox3f& BlockBounds : BlocksBounds)
+		{
+			Bounds += BlockBounds;
+		}
+		return Bounds;
+	}
+
+	/*
+	 * Stable LSD radix sort of the keys carrying the input index of their point, the points are then moved once following the permutation.
+	 * The extra memory is two keys and two indices per point, the points are never duplicated.
+	 */
+	template<typename IndexType>
+	bool SortPointsByMortonKey(TArray64<FLidarPointCloudPoint>& Points, const FBox3f& Bounds, FglTFRuntimePointCloudLoadContext& Context)
+	{
+		const int64 NumPoints = Points.Num();
+		const float Scale = GetMortonScale(Bounds);
+
+		const int32 NumBlocks = static_cast<int32>((NumPoints + SortPointsPerBlock - 1) / SortPointsPerBlock);
+
+		TArray64<uint64> Keys;
+		Keys.SetNumUninitialized(NumPoints);
+		TArray64<uint64> SortedKeys;
+		SortedKeys.SetNumUninitialized(NumPoints);
+		/* the input index of the point of every (sorted) key */
+		TArray64<IndexType> Order;
+		Order.SetNumUninitialized(NumPoints);
+		TArray64<IndexType> SortedOrder;
+		SortedOrder.SetNumUninitialized(NumPoints);
+
+		Context.Report.BytesAllocated += NumPoints * static_cast<int64>(sizeof(uint64) * 2 + sizeof(IndexType) * 2);
+
+		// the per block histograms of a pass, Histograms[BlockIndex * SortRadixBuckets + Digit] becomes the block output offset of the digit
+		TArray64<int64> Histograms;
+		Histograms.SetNumUninitialized(static_cast<int64>(NumBlocks) * SortRadixBuckets);
+
+		ParallelFor(NumBlocks, [&](const int32 BlockIndex)
+			{
+				const int64 FirstPoint = BlockIndex * SortPointsPerBlock;
+				const int64 LastPoint = FMath::Min(FirstPoint + SortPointsPerBlock, NumPoints);
+				for (int64 PointIndex = FirstPoint; PointIndex < LastPoint; PointIndex++)
+				{
+					Keys[PointIndex] = GetMortonKey(Points[PointIndex].Location, Bounds.Min, Scale);
+					Order[PointIndex] = static_cast<IndexType>(PointIndex);
+				}
+			});
+
+		constexpr int32 KeyBits = SortMortonBitsPerAxis * 3;
+		for (int32 Shift = 0; Shift < KeyBits; Shift += SortRadixBits)
+		{
+			if (Context.IsCanceled())
+			{
+				return false;
+			}
+
+			ParallelFor(NumBlocks, [&](const int32 BlockIndex)
+				{
+					int64* Histogram = Histograms.GetData() + static_cast<int64>(BlockIndex) * SortRadixBuckets;
+					FMemory::Memzero(Histogram, SortRadixBuckets * sizeof(int64));
+
+					const int64 FirstPoint = BlockIndex * SortPointsPerBlock;
+					const int64 LastPoint = FMath::Min(FirstPoint + SortPointsPerBlock, NumPoints);
+					for (int64 PointIndex = FirstPoint; PointIndex < LastPoint; PointIndex++)
+					{
+						Histogram[(Keys[PointIndex] >> Shift) & (SortRadixBuckets - 1)]++;
+					}
+				});
+
+			// digit major, block minor: the scatter is stable
+			int64 Offset = 0;
+			bool bSingleDigit = false;
+			for (int32 Digit = 0; Digit < SortRadixBuckets; Digit++)
+			{
+				const int64 DigitOffset = Offset;
+				for (int32 BlockIndex = 0; BlockIndex < NumBlocks; BlockIndex++)
+				{
+					int64& Count = Histograms[static_cast<int64>(BlockIndex) * SortRadixBuckets + Digit];
+					const int64 BlockCount = Count;
+					Count = Offset;
+					Offset += BlockCount;
+				}
+				bSingleDigit |= Offset - DigitOffset == NumPoints;
+			}
+
+			// all of the points share the digit, the pass would not change the order
+			if (bSingleDigit)
+			{
+				continue;
+			}
+
+			ParallelFor(NumBlocks, [&](const int32 BlockIndex)
+				{
+					int64* BlockOffsets = Histograms.GetData() + static_cast<int64>(BlockIndex) * SortRadixBuckets;
+
+					const int64 FirstPoint = BlockIndex * SortPointsPerBlock;
+					const int64 LastPoint = FMath::Min(FirstPoint + SortPointsPerBlock, NumPoints);
+					for (int64 PointIndex = FirstPoint; PointIndex < LastPoint; PointIndex++)
+					{
+						const uint64 Key = Keys[PointIndex];
+						const int64 OutputIndex = BlockOffsets[(Key >> Shift) & (SortRadixBuckets - 1)]++;
+						SortedKeys[OutputIndex] = Key;
+						SortedOrder[OutputIndex] = Order[PointIndex];
+					}
+				});
+
+			Swap(Keys, SortedKeys);
+			Swap(Order, SortedOrder);
+		}
+
+		Keys.Empty();
+		SortedKeys.Empty();
+		SortedOrder.Empty();
+
+		if (Context.IsCanceled())
+		{
+			return false;
+		}
+
+		// in place permutation: every cycle is walked once, a visited position gets its own index
+		for (int64 FirstPoint = 0; FirstPoint < NumPoints; FirstPoint++)
+		{
+			if (Order[FirstPoint] == static_cast<IndexType>(FirstPoint))
+			{
+				continue;
+			}
+
+			const FLidarPointCloudPoint FirstPointValue = Points[FirstPoint];
+			int64 Destination = FirstPoint;
+			for (;;)
+			{
+				const int64 Source = static_cast<int64>(Order[Destination]);
+				Order[Destination] = static_cast<IndexType>(Destination);
+				if (Source == FirstPoint)
+				{
+					Points[Destination] = FirstPointValue;
+					break;
+				}
+				Points[Destination] = Points[Source];
+				Destination = Source;
+			}
+		}
+
+		return true;
+	}
+
+	/* Sorts the points in place, stable: points with the same key keep their order (false when canceled, the order is then undefined) */
+	inline bool SortPointsByMortonKey(TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context)
+	{
+		GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, Sort);
+
+		if (Points.Num() < 2)
+		{
+			return true;
+		}
+
+		const FBox3f Bounds = ComputePointsBounds(Points);
+
+		// 32 bits indices cover all of the practical sizes with 24 extra bytes per point
+		if (Points.Num() <= MAX_uint32)
+		{
+			return SortPointsByMortonKey<uint32>(Points, Bounds, Context);
+		}
+		return SortPointsByMortonKey<int64>(Points, Bounds, Context);
+	}
+}
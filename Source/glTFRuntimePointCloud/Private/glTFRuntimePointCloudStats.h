@@ -0,0 +1,38 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "glTFRuntimePointCloudLibrary.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+namespace glTFRuntimePointCloud
+{
+	/* Adds the duration of a phase to the load report and samples the process memory when the phase ends */
+	class FLoadPhaseScope
+	{
+	public:
+		FLoadPhaseScope(FglTFRuntimePointCloudLoadContext& InContext, double FglTFRuntimePointCloudLoadReport::* InPhaseTime) : Context(InContext), PhaseTime(InPhaseTime)
+		{
+			StartTime = FPlatformTime::Seconds();
+		}
+
+		~FLoadPhaseScope()
+		{
+			Context.Report.*PhaseTime += FPlatformTime::Seconds() - StartTime;
+			Context.Report.PeakUsedPhysical = FMath::Max<int64>(Context.Report.PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+		}
+
+	private:
+		FglTFRuntimePointCloudLoadContext& Context;
+		double FglTFRuntimePointCloudLoadReport::* PhaseTime;
+		double StartTime;
+	};
+}
+
+/* Times a phase of a load (LineScan, Parse, Decompress, Filter or OctreeBuild) in the report, the profiler trace and the memory tracker */
+#define GLTFRUNTIME_POINTCLOUD_PHASE_SCOPE(Context, Phase) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(glTFRuntimePointCloud_##Phase); \
+	LLM_SCOPE_BYNAME(TEXT("glTFRuntimePointCloud/" #Phase)); \
+	glTFRuntimePointCloud::FLoadPhaseScope LoadPhaseScope_##Phase(Context, &FglTFRuntimePointCloudLoadReport::Phase##Time)
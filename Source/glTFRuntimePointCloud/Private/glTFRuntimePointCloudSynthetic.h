@@ -0,0 +1,238 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/ParallelFor.h"
+#include "LidarPointCloudShared.h"
+
+/*
+ * Deterministic synthetic point clouds and their encodings, used by the benchmark commandlet and the automation tests.
+ * Every point only depends on the seed and on its index, so the data does not change with the number of threads.
+ * Coordinates are multiples of 1/8 written with 3 decimals: they survive the ASCII round trip exactly.
+ */
+namespace glTFRuntimePointCloud
+{
+	constexpr int64 SyntheticPointsPerBlock = 64 * 1024;
+
+	/* splitmix64 finalizer */
+	FORCEINLINE uint64 SyntheticHash(uint64 Value)
+	{
+		Value += 0x9E3779B97F4A7C15ull;
+		Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+		Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+		return Value ^ (Value >> 31);
+	}
+
+	/* 20 bits of Bits as a signed number of eighths (+-65536) */
+	FORCEINLINE float SyntheticCoordinate(const uint64 Bits)
+	{
+		return static_cast<float>(static_cast<int32>(Bits & 0xFFFFF) - (1 << 19)) / 8.0f;
+	}
+
+	inline void GenerateSyntheticPoints(const uint64 Seed, const int64 NumPoints, TArray64<FLidarPointCloudPoint>& Points)
+	{
+		Points.SetNumUninitialized(NumPoints);
+
+		ParallelFor(static_cast<int32>((NumPoints + SyntheticPointsPerBlock - 1) / SyntheticPointsPerBlock), [&](const int32 BlockIndex)
+			{
+				const int64 FirstPoint = BlockIndex * SyntheticPointsPerBlock;
+				const int64 LastPoint = FMath::Min(FirstPoint + SyntheticPointsPerBlock, NumPoints);
+
+				for (int64 PointIndex = FirstPoint; PointIndex < LastPoint; PointIndex++)
+				{
+					const uint64 LocationBits = SyntheticHash(Seed ^ SyntheticHash(PointIndex * 2));
+					const uint64 ColorBits = SyntheticHash(Seed ^ SyntheticHash(PointIndex * 2 + 1));
+
+					FLidarPointCloudPoint Point;
+					Point.Location = FVector3f(SyntheticCoordinate(LocationBits), SyntheticCoordinate(LocationBits >> 20), SyntheticCoordinate(LocationBits >> 40));
+					Point.Color = FColor(static_cast<uint8>(ColorBits), static_cast<uint8>(ColorBits >> 8), static_cast<uint8>(ColorBits >> 16), static_cast<uint8>(ColorBits >> 24));
+					Points[PointIndex] = Point;
+				}
+			});
+	}
+
+	FORCEINLINE void AppendSyntheticUInt(TArray64<uint8>& Text, uint64 Value)
+	{
+		uint8 Digits[20];
+		int32 NumDigits = 0;
+		do
+		{
+			Digits[NumDigits++] = '0' + Value % 10;
+			Value /= 10;
+		} while (Value > 0);
+
+		while (NumDigits > 0)
+		{
+			Text.Add(Digits[--NumDigits]);
+		}
+	}
+
+	/* Writes a multiple of 1/8 with 3 decimals */
+	FORCEINLINE void AppendSyntheticCoordinate(TArray64<uint8>& Text, const float Value)
+	{
+		int64 Eighths = FMath::RoundToInt64(Value * 8.0f);
+		if (Eighths < 0)
+		{
+			Text.Add('-');
+			Eighths = -Eighths;
+		}
+
+		AppendSyntheticUInt(Text, Eighths / 8);
+		Text.Add('.');
+
+		const int32 Thousandths = static_cast<int32>(Eighths % 8) * 125;
+		Text.Add('0' + Thousandths / 100);
+		Text.Add('0' + (Thousandths / 10) % 10);
+		Text.Add('0' + Thousandths % 10);
+	}
+
+	/* Formats the lines of every block in parallel and appends them to Blob in order */
+	template<typename LineWriterType>
+	void WriteSyntheticLines(const TArray64<FLidarPointCloudPoint>& Points, TArray64<uint8>& Blob, LineWriterType LineWriter)
+	{
+		const int32 NumBlocks = static_cast<int32>((Points.Num() + SyntheticPointsPerBlock - 1) / SyntheticPointsPerBlock);
+		TArray<TArray64<uint8>> Blocks;
+		Blocks.AddDefaulted(NumBlocks);
+
+		ParallelFor(NumBlocks, [&](const int32 BlockIndex)
+			{
+				const int64 FirstPoint = BlockIndex * SyntheticPointsPerBlock;
+				const int64 LastPoint = FMath::Min(FirstPoint + SyntheticPointsPerBlock, Points.Num());
+
+				TArray64<uint8>& Text = Blocks[BlockIndex];
+				Text.Reserve((LastPoint - FirstPoint) * 48);
+				for (int64 PointIndex = FirstPoint; PointIndex < LastPoint; PointIndex++)
+				{
+					LineWriter(Text, Points[PointIndex]);
+					Text.Add('\n');
+				}
+			});
+
+		for (TArray64<uint8>& Text : Blocks)
+		{
+			Blob.Append(Text);
+			Text.Empty();
+		}
+	}
+
+	/* "x y z r g b" lines, matching the default FglTFRuntimeASCIIPointCloudConfig (alpha is not written, so it loads as 255) */
+	inline void WriteSyntheticXYZ(const TArray64<FLidarPointCloudPoint>& Points, TArray64<uint8>& Blob)
+	{
+		Blob.Reset();
+		WriteSyntheticLines(Points, Blob, [](TArray64<uint8>& Text, const FLidarPointCloudPoint& Point)
+			{
+				AppendSyntheticCoordinate(Text, Point.Location.X);
+				Text.Add(' ');
+				AppendSyntheticCoordinate(Text, Point.Location.Y);
+				Text.Add(' ');
+				AppendSyntheticCoordinate(Text, Point.Location.Z);
+				Text.Add(' ');
+				AppendSyntheticUInt(Text, Point.Color.R);
+				Text.Add(' ');
+				AppendSyntheticUInt(Text, Point.Color.G);
+				Text.Add(' ');
+				AppendSyntheticUInt(Text, Point.Color.B);
+			});
+	}
+
+	/* ascii PCD with x y z and the packed rgba as an integer (the binary variants are written by WritePointsToPCD) */
+	inline void WriteSyntheticPCDASCII(const TArray64<FLidarPointCloudPoint>& Points, TArray64<uint8>& Blob)
+	{
+		const FString Header = FString::Printf(TEXT("# .PCD v0.7 - Point Cloud Data file format\nVERSION 0.7\nFIELDS x y z rgba\nSIZE 4 4 4 4\nTYPE F F F U\nCOUNT 1 1 1 1\nWIDTH %lld\nHEIGHT 1\nVIEWPOINT 0 0 0 1 0 0 0\nPOINTS %lld\nDATA ascii\n"),
+			Points.Num(), Points.Num());
+		FTCHARToUTF8 HeaderUTF8(*Header);
+
+		Blob.Reset();
+		Blob.Append(reinterpret_cast<const uint8*>(HeaderUTF8.Get()), HeaderUTF8.Length());
+		WriteSyntheticLines(Points, Blob, [](TArray64<uint8>& Text, const FLidarPointCloudPoint& Point)
+			{
+				AppendSyntheticCoordinate(Text, Point.Location.X);
+				Text.Add(' ');
+				AppendSyntheticCoordinate(Text, Point.Location.Y);
+				Text.Add(' ');
+				AppendSyntheticCoordinate(Text, Point.Location.Z);
+				Text.Add(' ');
+				AppendSyntheticUInt(Text, (static_cast<uint32>(Point.Color.A) << 24) | (static_cast<uint32>(Point.Color.R) << 16) | (static_cast<uint32>(Point.Color.G) << 8) | Point.Color.B);
+			});
+	}
+
+	/* Binary glTF with a single mode 0 primitive: float POSITION and normalized unsigned byte COLOR_0 */
+	inline bool WriteSyntheticGLB(const TArray64<FLidarPointCloudPoint>& Points, TArray64<uint8>& Blob)
+	{
+		const int64 NumPoints = Points.Num();
+		const int64 PositionsSize = NumPoints * 12;
+		const int64 ColorsSize = NumPoints * 4;
+		const int64 BinarySize = PositionsSize + ColorsSize;
+
+		FBox3f Bounds(ForceInit);
+		for (const FLidarPointCloudPoint& Point : Points)
+		{
+			Bounds += Point.Location;
+		}
+		if (!Bounds.IsValid)
+		{
+			Bounds = FBox3f(FVector3f::ZeroVector, FVector3f::ZeroVector);
+		}
+
+		const FString Json = FString::Printf(TEXT("{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],")
+			TEXT("\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"COLOR_0\":1},\"mode\":0}]}],")
+			TEXT("\"buffers\":[{\"byteLength\":%lld}],")
+			TEXT("\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%lld},{\"buffer\":0,\"byteOffset\":%lld,\"byteLength\":%lld}],")
+			TEXT("\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":%lld,\"type\":\"VEC3\",\"min\":[%f,%f,%f],\"max\":[%f,%f,%f]},")
+			TEXT("{\"bufferView\":1,\"componentType\":5121,\"normalized\":true,\"count\":%lld,\"type\":\"VEC4\"}]}"),
+			BinarySize, PositionsSize, PositionsSize, ColorsSize,
+			NumPoints, Bounds.Min.X, Bounds.Min.Y, Bounds.Min.Z, Bounds.Max.X, Bounds.Max.Y, Bounds.Max.Z,
+			NumPoints);
+		FTCHARToUTF8 JsonUTF8(*Json);
+
+		const int64 JsonChunkSize = Align(JsonUTF8.Length(), 4);
+		const int64 TotalSize = 12 + 8 + JsonChunkSize + 8 + BinarySize;
+		if (TotalSize > MAX_uint32)
+		{
+			return false;
+		}
+
+		Blob.Reset(TotalSize);
+
+		auto AppendUInt32 = [&Blob](const uint32 Value)
+			{
+				Blob.Append(reinterpret_cast<const uint8*>(&Value), sizeof(uint32));
+			};
+
+		AppendUInt32(0x46546C67); // glTF
+		AppendUInt32(2);
+		AppendUInt32(static_cast<uint32>(TotalSize));
+
+		AppendUInt32(static_cast<uint32>(JsonChunkSize));
+		AppendUInt32(0x4E4F534A); // JSON
+		Blob.Append(reinterpret_cast<const uint8*>(JsonUTF8.Get()), JsonUTF8.Length());
+		while (Blob.Num() < 20 + JsonChunkSize)
+		{
+			Blob.Add(' ');
+		}
+
+		AppendUInt32(static_cast<uint32>(BinarySize));
+		AppendUInt32(0x004E4942); // BIN
+
+		const int64 BinaryOffset = Blob.AddUninitialized(BinarySize);
+		uint8* Positions = Blob.GetData() + BinaryOffset;
+		uint8* Colors = Positions + PositionsSize;
+
+		ParallelFor(static_cast<int32>((NumPoints + SyntheticPointsPerBlock - 1) / SyntheticPointsPerBlock), [&](const int32 BlockIndex)
+			{
+				const int64 FirstPoint = BlockIndex * SyntheticPointsPerBlock;
+				const int64 LastPoint = FMath::Min(FirstPoint + SyntheticPointsPerBlock, NumPoints);
+
+				for (int64 PointIndex = FirstPoint; PointIndex < LastPoint; PointIndex++)
+				{
+					const FLidarPointCloudPoint& Point = Points[PointIndex];
+					FMemory::Memcpy(Positions + PointIndex * 12, &Point.Location.X, 12);
+					const uint8 RGBA[4] = { Point.Color.R, Point.Color.G, Point.Color.B, Point.Color.A };
+					FMemory::Memcpy(Colors + PointIndex * 4, RGBA, 4);
+				}
+			});
+
+		return true;
+	}
+}
@@ -0,0 +1,142 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "glTFRuntimePointCloudLibrary.h"
+#include "glTFRuntimePointCloudAsyncAction.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FglTFRuntimePointCloudAsyncActionLoaded, ULidarPointCloud*, PointCloud);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FglTFRuntimePointCloudAsyncActionProgress, const EglTFRuntimePointCloudLoadPhase, Phase, const float, Progress);
+
+/**
+ * Runs a point cloud loader in the thread pool and builds the octree asynchronously.
+ * Progress and completion are always notified in the game thread.
+ */
+UCLASS()
+class GLTFRUNTIMEPOINTCLOUD_API UglTFRuntimePointCloudAsyncAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintAssignable)
+	FglTFRuntimePointCloudAsyncActionLoaded Completed;
+
+	UPROPERTY(BlueprintAssignable)
+	FglTFRuntimePointCloudAsyncActionLoaded Failed;
+
+	UPROPERTY(BlueprintAssignable)
+	FglTFRuntimePointCloudAsyncActionProgress Progress;
+
+	/* Progressive loads only: the sampled points are in the octree, the remaining ones are being added to the same point cloud */
+	UPROPERTY(BlueprintAssignable)
+	FglTFRuntimePointCloudAsyncActionLoaded Preview;
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (BlueprintInternalUseOnly = "true", AutoCreateRefTerm = "PointCloudConfig"))
+	static UglTFRuntimePointCloudAsyncAction* AsyncLoadPointCloudFromMesh(UglTFRuntimeAsset* Asset, const int32 MeshIndex, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (BlueprintInternalUseOnly = "true", AutoCreateRefTerm = "PointCloudConfig"))
+	static UglTFRuntimePointCloudAsyncAction* AsyncLoadPointCloudFromMeshes(UglTFRuntimeAsset* Asset, const TArray<int32>& MeshIndices, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (BlueprintInternalUseOnly = "true", AutoCreateRefTerm = "ASCIIPointCloudConfig,PointCloudConfig"))
+	static UglTFRuntimePointCloudAsyncAction* AsyncLoadPointCloudFromXYZ(UglTFRuntimeAsset* Asset, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (BlueprintInternalUseOnly = "true", AutoCreateRefTerm = "PointCloudConfig"))
+	static UglTFRuntimePointCloudAsyncAction* AsyncLoadPointCloudFromPCD(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (BlueprintInternalUseOnly = "true", AutoCreateRefTerm = "PointCloudConfig"))
+	static UglTFRuntimePointCloudAsyncAction* AsyncLoadPointCloudFromLAS(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (BlueprintInternalUseOnly = "true", AutoCreateRefTerm = "PointCloudConfig"))
+	static UglTFRuntimePointCloudAsyncAction* AsyncLoadPointCloudFromPLY(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (BlueprintInternalUseOnly = "true", AutoCreateRefTerm = "PointCloudConfig"))
+	static UglTFRuntimePointCloudAsyncAction* AsyncLoadPointCloudFromLASFile(const FString& Filename, const int32 MemoryBudgetMB, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (BlueprintInternalUseOnly = "true", AutoCreateRefTerm = "ASCIIPointCloudConfig,PointCloudConfig"))
+	static UglTFRuntimePointCloudAsyncAction* AsyncLoadPointCloudFromXYZFile(const FString& Filename, const int32 MemoryBudgetMB, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	/* PreviewFraction of the points (one every 1 / PreviewFraction) is loaded first, the others are streamed in the same point cloud */
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (BlueprintInternalUseOnly = "true", AutoCreateRefTerm = "PointCloudConfig"))
+	static UglTFRuntimePointCloudAsyncAction* AsyncLoadPointCloudFromMeshesProgressive(UglTFRuntimeAsset* Asset, const TArray<int32>& MeshIndices, const float PreviewFraction, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (BlueprintInternalUseOnly = "true", AutoCreateRefTerm = "ASCIIPointCloudConfig,PointCloudConfig"))
+	static UglTFRuntimePointCloudAsyncAction* AsyncLoadPointCloudFromXYZProgressive(UglTFRuntimeAsset* Asset, const float PreviewFraction, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (BlueprintInternalUseOnly = "true", AutoCreateRefTerm = "PointCloudConfig"))
+	static UglTFRuntimePointCloudAsyncAction* AsyncLoadPointCloudFromPCDProgressive(UglTFRuntimeAsset* Asset, const float PreviewFraction, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	/* Stops the loader as soon as possible, Failed will be notified with a null PointCloud */
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud")
+	void Cancel();
+
+	UFUNCTION(BlueprintPure, Category = "glTFRuntime|PointCloud")
+	bool IsRunning() const;
+
+	/* Points dropped by the crop box and the range filters of the last load */
+	UFUNCTION(BlueprintPure, Category = "glTFRuntime|PointCloud")
+	int64 GetNumRejectedPoints() const;
+
+	/* Timings, counts and memory of the last load (the octree build included) */
+	UFUNCTION(BlueprintPure, Category = "glTFRuntime|PointCloud")
+	FglTFRuntimePointCloudLoadReport GetLoadReport() const;
+
+	/* LAS loads only: the center of the LAS bounds, points are relative to it */
+	UFUNCTION(BlueprintPure, Category = "glTFRuntime|PointCloud")
+	FVector GetOrigin() const;
+
+	/* PCD loads only: the VIEWPOINT of the header */
+	UFUNCTION(BlueprintPure, Category = "glTFRuntime|PointCloud")
+	FTransform GetViewPoint() const;
+
+	virtual void Activate() override;
+
+	/* The actual loader, invoked in the thread pool */
+	TFunction<bool(FglTFRuntimePointCloudLoadContext& Context, TArray64<FLidarPointCloudPoint>& Points)> Loader;
+
+	/* Streaming loader, invoked in the thread pool: it inserts the points directly in the (game thread created) point cloud */
+	TFunction<bool(FglTFRuntimePointCloudLoadContext& Context, ULidarPointCloud* PointCloud)> StreamLoader;
+
+	FglTFRuntimePointCloudAsync AsyncCallback;
+	FglTFRuntimePointCloudAsyncProgress ProgressCallback;
+	FglTFRuntimePointCloudAsync PreviewCallback;
+
+	/* When greater than 1 the Loader runs twice: one point every ProgressiveStride for the preview, then all of the others */
+	int32 ProgressiveStride = 0;
+
+	/* The ProgressiveStride of a fraction of the points (0 disables progressive loading) */
+	static int32 GetProgressiveStride(const float PreviewFraction);
+
+	/* Copied in the load context on activation */
+	FglTFRuntimePointCloudConfig PointCloudConfig;
+
+	static UglTFRuntimePointCloudAsyncAction* CreateAction(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig, TFunction<bool(FglTFRuntimePointCloudLoadContext& Context, TArray64<FLidarPointCloudPoint>& Points)> InLoader);
+
+	static UglTFRuntimePointCloudAsyncAction* CreateStreamAction(const FglTFRuntimePointCloudConfig& PointCloudConfig, TFunction<bool(FglTFRuntimePointCloudLoadContext& Context, ULidarPointCloud* PointCloud)> InStreamLoader);
+
+protected:
+	UPROPERTY()
+	UglTFRuntimeAsset* Asset;
+
+	UPROPERTY()
+	ULidarPointCloud* PointCloud;
+
+	TSharedPtr<FglTFRuntimePointCloudLoadContext, ESPMode::ThreadSafe> Context;
+
+	int64 NumRejectedPoints = 0;
+
+	FglTFRuntimePointCloudLoadReport LoadReport;
+
+	FVector Origin = FVector::ZeroVector;
+
+	FTransform ViewPoint = FTransform::Identity;
+
+	void NotifyProgress(const EglTFRuntimePointCloudLoadPhase Phase, const float Value);
+	void Finish(ULidarPointCloud* LoadedPointCloud);
+	void BuildOctree(TSharedRef<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe> Points);
+	void Stream();
+	void Progressive();
+	void Refine(TSharedRef<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe> PreviewPoints, const FBox3f& Bounds);
+	void Merge(TSharedRef<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe> PreviewPoints, TSharedRef<TArray64<FLidarPointCloudPoint>, ESPMode::ThreadSafe> Points, const FBox3f& RebuildBounds);
+};
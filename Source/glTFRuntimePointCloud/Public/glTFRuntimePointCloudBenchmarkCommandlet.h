@@ -0,0 +1,25 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "glTFRuntimePointCloudBenchmarkCommandlet.generated.h"
+
+/**
+ * Headless benchmark and correctness check of the loaders on deterministic synthetic point clouds.
+ * Every loaded point is compared with the generated ones, the load reports are written as JSON for trend tracking.
+ *
+ * -run=glTFRuntimePointCloudBenchmark [-Sizes=1K,1M,100M] [-Formats=xyz,xyz_file,pcd_ascii,pcd_binary,pcd_binary_compressed,gltf]
+ *     [-Seed=1] [-Iterations=1] [-NoOctree] [-Sort] [-Output=Report.json]
+ */
+UCLASS()
+class GLTFRUNTIMEPOINTCLOUD_API UglTFRuntimePointCloudBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UglTFRuntimePointCloudBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,25 @@
+// Copyright 2022-2024, Roberto De Ioris.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * LZF codec (the format used by PCD binary_compressed).
+ */
+struct GLTFRUNTIMEPOINTCLOUD_API FglTFRuntimePointCloudLZF
+{
+	/* Returns the number of bytes written in Output or -1 on corrupted data (or not enough room in Output) */
+	static int64 Decompress(const uint8* Input, const int64 InputSize, uint8* Output, const int64 OutputSize);
+
+	/* Returns the number of bytes written in Output or -1 if the compressed data does not fit in OutputSize */
+	static int64 Compress(const uint8* Input, const int64 InputSize, uint8* Output, const int64 OutputSize);
+
+	/* Worst case size of the compressed data (incompressible input) */
+	static int64 GetCompressBound(const int64 InputSize)
+	{
+		return InputSize + (InputSize / 32) + 1;
+	}
+
+	static bool Compress(const uint8* Input, const int64 InputSize, TArray64<uint8>& Output);
+};
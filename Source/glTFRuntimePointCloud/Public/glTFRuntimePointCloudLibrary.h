@@ -4,10 +4,215 @@
 
 #include "CoreMinimal.h"
 #include "glTFRuntimeAsset.h"
+#include "HAL/ThreadSafeBool.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "LidarPointCloud.h"
+#include <atomic>
 #include "glTFRuntimePointCloudLibrary.generated.h"
 
+UENUM(BlueprintType)
+enum class EglTFRuntimePointCloudLoadPhase : uint8
+{
+	LineScan,
+	Parse,
+	Decompress,
+	OctreeBuild
+};
+
+UENUM(BlueprintType)
+enum class EglTFRuntimePointCloudDecimation : uint8
+{
+	None,
+	/* keep one point every DecimationStride */
+	Stride,
+	/* keep DecimationTargetPointCount points evenly spread over the input */
+	TargetPointCount,
+	/* one point per DecimationVoxelSize cell, with averaged location, color and normal */
+	VoxelGrid,
+	/* the points skipped by Stride, used by the refinement pass of the progressive loads */
+	StrideRemainder UMETA(Hidden)
+};
+
+/* Keeps the points whose value is in [Min, Max], missing values are 0 */
+USTRUCT(BlueprintType)
+struct FglTFRuntimePointCloudRangeFilter
+{
+	GENERATED_BODY()
+
+	/* column of the XYZ loaders */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime|PointCloud")
+	int32 Column;
+
+	/* PCD field, PLY property, glTF attribute (first component) or LAS intensity/classification of the other loaders */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime|PointCloud")
+	FString Field;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime|PointCloud")
+	float Min;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime|PointCloud")
+	float Max;
+
+	FglTFRuntimePointCloudRangeFilter()
+	{
+		Column = -1;
+		Min = -MAX_flt;
+		Max = MAX_flt;
+	}
+};
+
+/* Options shared by every loader, applied while the points are decoded */
+USTRUCT(BlueprintType)
+struct FglTFRuntimePointCloudConfig
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime|PointCloud")
+	EglTFRuntimePointCloudDecimation Decimation;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime|PointCloud")
+	int32 DecimationStride;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime|PointCloud")
+	int32 DecimationTargetPointCount;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime|PointCloud")
+	float DecimationVoxelSize;
+
+	/* when valid, only the points inside of the box (in CropBoxTransform space) are loaded */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime|PointCloud")
+	FBox CropBox;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime|PointCloud")
+	FTransform CropBoxTransform;
+
+	/* all of the ranges must match, evaluated before the batch filters */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime|PointCloud")
+	TArray<FglTFRuntimePointCloudRangeFilter> RangeFilters;
+
+	/* the LoadPointClouds* functions split the points in multiple clouds of at most this size */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime|PointCloud")
+	int64 MaxPointsPerCloud;
+
+	/* sort the points in Morton (Z) order before building the octree: faster builds for inputs not spatially ordered, at the cost of 24 bytes per point while sorting (ignored by the memory bounded file loaders) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "glTFRuntime|PointCloud")
+	bool bSortPoints;
+
+	FglTFRuntimePointCloudConfig()
+	{
+		Decimation = EglTFRuntimePointCloudDecimation::None;
+		DecimationStride = 1;
+		DecimationTargetPointCount = 0;
+		DecimationVoxelSize = 10;
+		CropBox.Init();
+		MaxPointsPerCloud = MAX_int32;
+		bSortPoints = false;
+	}
+};
+
+DECLARE_DYNAMIC_DELEGATE_OneParam(FglTFRuntimePointCloudAsync, ULidarPointCloud*, PointCloud);
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FglTFRuntimePointCloudAsyncProgress, const EglTFRuntimePointCloudLoadPhase, Phase, const float, Progress);
+
+/* Timings (in seconds), memory and point counters of a load, tokenizing, decoding and range filtering run in a single Parse pass */
+USTRUCT(BlueprintType)
+struct FglTFRuntimePointCloudLoadReport
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "glTFRuntime|PointCloud")
+	double LineScanTime = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "glTFRuntime|PointCloud")
+	double ParseTime = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "glTFRuntime|PointCloud")
+	double DecompressTime = 0;
+
+	/* voxel grid build and filtered segments join */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "glTFRuntime|PointCloud")
+	double FilterTime = 0;
+
+	/* Morton order of the points (see bSortPoints) */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "glTFRuntime|PointCloud")
+	double SortTime = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "glTFRuntime|PointCloud")
+	double OctreeBuildTime = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "glTFRuntime|PointCloud")
+	double TotalTime = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "glTFRuntime|PointCloud")
+	int64 NumInputPoints = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "glTFRuntime|PointCloud")
+	int64 NumAcceptedPoints = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "glTFRuntime|PointCloud")
+	int64 NumRejectedPoints = 0;
+
+	/* point and decompression buffers */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "glTFRuntime|PointCloud")
+	int64 BytesAllocated = 0;
+
+	/* highest process physical memory usage sampled at the end of every phase */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "glTFRuntime|PointCloud")
+	int64 PeakUsedPhysical = 0;
+};
+
+/**
+ * Shared state between a loader and its caller: configuration, cancellation flag and throttled (1%) progress reporting.
+ * Loaders can run on any thread, so the ProgressCallback can be invoked from worker threads.
+ */
+struct GLTFRUNTIMEPOINTCLOUD_API FglTFRuntimePointCloudLoadContext
+{
+	FThreadSafeBool bCanceled;
+	TFunction<void(const EglTFRuntimePointCloudLoadPhase Phase, const float Progress)> ProgressCallback;
+	FglTFRuntimePointCloudConfig Config;
+	/* points dropped by the crop box and the range filters */
+	std::atomic<int64> NumRejectedPoints = 0;
+	/* filled by the thread running the loader, see GetReport() */
+	FglTFRuntimePointCloudLoadReport Report;
+	/* filled by the LAS loaders (center of the bounds) and the PCD loaders (VIEWPOINT header) */
+	FVector Origin = FVector::ZeroVector;
+	FTransform ViewPoint = FTransform::Identity;
+	double StartTime;
+
+	FglTFRuntimePointCloudLoadContext()
+	{
+		StartTime = FPlatformTime::Seconds();
+		for (std::atomic<int32>& Percent : LastPercent)
+		{
+			Percent = -1;
+		}
+	}
+
+	explicit FglTFRuntimePointCloudLoadContext(const FglTFRuntimePointCloudConfig& InConfig) : FglTFRuntimePointCloudLoadContext()
+	{
+		Config = InConfig;
+	}
+
+	bool IsCanceled() const
+	{
+		return bCanceled;
+	}
+
+	void Cancel()
+	{
+		bCanceled = true;
+	}
+
+	void ReportProgress(const EglTFRuntimePointCloudLoadPhase Phase, const int64 Done, const int64 Total);
+
+	/* The report with the rejected points and the time elapsed since the context creation */
+	FglTFRuntimePointCloudLoadReport GetReport() const;
+
+	void LogReport() const;
+
+private:
+	std::atomic<int32> LastPercent[static_cast<int32>(EglTFRuntimePointCloudLoadPhase::OctreeBuild) + 1];
+};
+
 USTRUCT(BlueprintType)
 struct FglTFRuntimeASCIIPointCloudConfig
 {
@@ -58,6 +263,29 @@ struct FglTFRuntimeASCIIPointCloudConfig
 	}
 };
 
+/**
+ * A block of consecutive points passed to a batch filter.
+ * Columns are in structure-of-arrays layout: Columns[N][I] is the value of the N-th requested column for Points[I] (0 when missing).
+ */
+struct FglTFRuntimePointCloudBatch
+{
+	static constexpr int32 MaxPoints = 1024;
+
+	TArrayView<FLidarPointCloudPoint> Points;
+	TArray<TArrayView<const float>, TInlineAllocator<8>> Columns;
+	int64 FirstPointIndex = 0;
+};
+
+/* Called (concurrently from multiple threads) once per batch of at most FglTFRuntimePointCloudBatch::MaxPoints points */
+using FglTFRuntimePointCloudBatchFilter = TFunction<void(FglTFRuntimePointCloudBatch& Batch)>;
+
+class UglTFRuntimePointCloudAsyncAction;
+
+namespace glTFRuntimePointCloud
+{
+	struct FPCDHeader;
+}
+
 /**
  *
  */
@@ -70,18 +298,139 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud")
 	static bool HasPointCloud(UglTFRuntimeAsset* Asset, const int32 MeshIndex);
 
-	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud")
-	static ULidarPointCloud* LoadPointCloudFromMesh(UglTFRuntimeAsset* Asset, const int32 MeshIndex);
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig"))
+	static ULidarPointCloud* LoadPointCloudFromMesh(UglTFRuntimeAsset* Asset, const int32 MeshIndex, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig"))
+	static ULidarPointCloud* LoadPointCloudFromMeshes(UglTFRuntimeAsset* Asset, const TArray<int32>& MeshIndices, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "ASCIIPointCloudConfig,PointCloudConfig"))
+	static ULidarPointCloud* LoadPointCloudFromXYZ(UglTFRuntimeAsset* Asset, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig"))
+	static ULidarPointCloud* LoadPointCloudFromPCD(UglTFRuntimeAsset* Asset, FTransform& ViewPoint, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "ASCIIPointCloudConfig,PointCloudConfig"))
+	static TArray<ULidarPointCloud*> LoadPointCloudsFromXYZ(UglTFRuntimeAsset* Asset, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig"))
+	static TArray<ULidarPointCloud*> LoadPointCloudsFromPCD(UglTFRuntimeAsset* Asset, FTransform& ViewPoint, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig,ProgressCallback"))
+	static UglTFRuntimePointCloudAsyncAction* LoadPointCloudFromMeshAsync(UglTFRuntimeAsset* Asset, const int32 MeshIndex, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback);
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig,ProgressCallback"))
+	static UglTFRuntimePointCloudAsyncAction* LoadPointCloudFromMeshesAsync(UglTFRuntimeAsset* Asset, const TArray<int32>& MeshIndices, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback);
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "ASCIIPointCloudConfig,PointCloudConfig,ProgressCallback"))
+	static UglTFRuntimePointCloudAsyncAction* LoadPointCloudFromXYZAsync(UglTFRuntimeAsset* Asset, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback);
+
+	/* The ViewPoint is available from GetViewPoint() of the returned action when the callback runs */
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig,ProgressCallback"))
+	static UglTFRuntimePointCloudAsyncAction* LoadPointCloudFromPCDAsync(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback);
+
+	/* PreviewFraction of the points is loaded first and notified to PreviewCallback, the others are then streamed in the same point cloud (decimation is ignored) */
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig,PreviewCallback,ProgressCallback"))
+	static UglTFRuntimePointCloudAsyncAction* LoadPointCloudFromMeshesProgressiveAsync(UglTFRuntimeAsset* Asset, const TArray<int32>& MeshIndices, const float PreviewFraction, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& PreviewCallback, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback);
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "ASCIIPointCloudConfig,PointCloudConfig,PreviewCallback,ProgressCallback"))
+	static UglTFRuntimePointCloudAsyncAction* LoadPointCloudFromXYZProgressiveAsync(UglTFRuntimeAsset* Asset, const float PreviewFraction, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& PreviewCallback, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback);
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig,PreviewCallback,ProgressCallback"))
+	static UglTFRuntimePointCloudAsyncAction* LoadPointCloudFromPCDProgressiveAsync(UglTFRuntimeAsset* Asset, const float PreviewFraction, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& PreviewCallback, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback);
+
+	/* Origin is the center of the LAS bounds, points are relative to it */
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig"))
+	static ULidarPointCloud* LoadPointCloudFromLAS(UglTFRuntimeAsset* Asset, FVector& Origin, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	/* The Origin is available from GetOrigin() of the returned action when the callback runs */
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig,ProgressCallback"))
+	static UglTFRuntimePointCloudAsyncAction* LoadPointCloudFromLASAsync(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback);
+
+	/* ascii, binary_little_endian and binary_big_endian vertex elements */
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig"))
+	static ULidarPointCloud* LoadPointCloudFromPLY(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig,ProgressCallback"))
+	static UglTFRuntimePointCloudAsyncAction* LoadPointCloudFromPLYAsync(UglTFRuntimeAsset* Asset, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback);
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "ASCIIPointCloudConfig,PointCloudConfig"))
+	static ULidarPointCloud* LoadPointCloudFromXYZWithCache(UglTFRuntimeAsset* Asset, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FString& CacheFilename, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig"))
+	static ULidarPointCloud* LoadPointCloudFromPCDWithCache(UglTFRuntimeAsset* Asset, const FString& CacheFilename, FTransform& ViewPoint, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "ASCIIPointCloudConfig,PointCloudConfig,ProgressCallback"))
+	static UglTFRuntimePointCloudAsyncAction* LoadPointCloudFromXYZWithCacheAsync(UglTFRuntimeAsset* Asset, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FString& CacheFilename, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback);
+
+	/* The ViewPoint is available from GetViewPoint() of the returned action when the callback runs */
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig,ProgressCallback"))
+	static UglTFRuntimePointCloudAsyncAction* LoadPointCloudFromPCDWithCacheAsync(UglTFRuntimeAsset* Asset, const FString& CacheFilename, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback);
+
+	/* Out-of-core loading: the file is read in windows of about MemoryBudgetMB (file bytes plus decoded points) inserted one at a time in the octree */
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig"))
+	static ULidarPointCloud* LoadPointCloudFromLASFile(const FString& Filename, FVector& Origin, const int32 MemoryBudgetMB, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	/* The Origin is available from GetOrigin() of the returned action when the callback runs */
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "PointCloudConfig,ProgressCallback"))
+	static UglTFRuntimePointCloudAsyncAction* LoadPointCloudFromLASFileAsync(const FString& Filename, const int32 MemoryBudgetMB, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback);
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "ASCIIPointCloudConfig,PointCloudConfig"))
+	static ULidarPointCloud* LoadPointCloudFromXYZFile(const FString& Filename, const int32 MemoryBudgetMB, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "ASCIIPointCloudConfig,PointCloudConfig,ProgressCallback"))
+	static UglTFRuntimePointCloudAsyncAction* LoadPointCloudFromXYZFileAsync(const FString& Filename, const int32 MemoryBudgetMB, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback);
 
 	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud")
-	static ULidarPointCloud* LoadPointCloudFromMeshes(UglTFRuntimeAsset* Asset, const TArray<int32>& MeshIndices);
+	static bool SavePointCloudToPCD(ULidarPointCloud* PointCloud, const FString& Filename, const bool bBinaryCompressed = true);
+
+	static ULidarPointCloud* LoadPointCloudFromXYZWithFilter(UglTFRuntimeAsset* Asset, TFunction<void(FLidarPointCloudPoint&, const TArray<FString>&, const FglTFRuntimeASCIIPointCloudConfig&) > StringFilter, TFunction<void(FLidarPointCloudPoint&, const TArray<double>&, const TArray<double>&, const TArray<double>&, const FglTFRuntimeASCIIPointCloudConfig&)> FloatFilter, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	/* FilterColumns are the only extra columns parsed, the filter receives them as float arrays */
+	static ULidarPointCloud* LoadPointCloudFromXYZWithBatchFilter(UglTFRuntimeAsset* Asset, const TArray<int32>& FilterColumns, FglTFRuntimePointCloudBatchFilter BatchFilter, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	/* FilterProperties are vertex property names (e.g. scalar_intensity or f_dc_0), missing ones are passed as 0 */
+	static ULidarPointCloud* LoadPointCloudFromPLYWithBatchFilter(UglTFRuntimeAsset* Asset, const TArray<FString>& FilterProperties, FglTFRuntimePointCloudBatchFilter BatchFilter, const FglTFRuntimePointCloudConfig& PointCloudConfig = FglTFRuntimePointCloudConfig());
+
+	static UglTFRuntimePointCloudAsyncAction* LoadPointCloudFromXYZWithFilterAsync(UglTFRuntimeAsset* Asset, TFunction<void(FLidarPointCloudPoint&, const TArray<FString>&, const FglTFRuntimeASCIIPointCloudConfig&) > StringFilter, TFunction<void(FLidarPointCloudPoint&, const TArray<double>&, const TArray<double>&, const TArray<double>&, const FglTFRuntimeASCIIPointCloudConfig&)> FloatFilter, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FglTFRuntimePointCloudConfig& PointCloudConfig, const FglTFRuntimePointCloudAsync& AsyncCallback, const FglTFRuntimePointCloudAsyncProgress& ProgressCallback);
+
+	/* Thread-safe loaders: they only fill the Points array (applying Context.Config), the octree is built by the caller */
+	static bool LoadPointsFromMeshes(TSharedRef<FglTFRuntimeParser> Parser, const TArray<int32>& MeshIndices, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context);
+
+	static bool LoadPointsFromXYZ(TSharedRef<FglTFRuntimeParser> Parser, TFunction<void(FLidarPointCloudPoint&, const TArray<FString>&, const FglTFRuntimeASCIIPointCloudConfig&) > StringFilter, TFunction<void(FLidarPointCloudPoint&, const TArray<double>&, const TArray<double>&, const TArray<double>&, const FglTFRuntimeASCIIPointCloudConfig&)> FloatFilter, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context);
+
+	static bool LoadPointsFromXYZWithBatchFilter(TSharedRef<FglTFRuntimeParser> Parser, const TArray<int32>& FilterColumns, FglTFRuntimePointCloudBatchFilter BatchFilter, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context);
+
+	static bool LoadPointsFromPCD(TSharedRef<FglTFRuntimeParser> Parser, FTransform& ViewPoint, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context);
+
+	static bool LoadPointsFromLAS(TSharedRef<FglTFRuntimeParser> Parser, FVector& Origin, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context);
+
+	static bool LoadPointsFromPLY(TSharedRef<FglTFRuntimeParser> Parser, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context);
+
+	static bool LoadPointsFromPLYWithBatchFilter(TSharedRef<FglTFRuntimeParser> Parser, const TArray<FString>& FilterProperties, FglTFRuntimePointCloudBatchFilter BatchFilter, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context);
+
+	/* Map CacheFilename when it matches the blob and configuration, otherwise parse the blob and (re)write the cache */
+	static bool LoadPointsFromXYZWithCache(TSharedRef<FglTFRuntimeParser> Parser, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, const FString& CacheFilename, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context);
+
+	static bool LoadPointsFromPCDWithCache(TSharedRef<FglTFRuntimeParser> Parser, const FString& CacheFilename, FTransform& ViewPoint, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context);
+
+	/*
+	 * Streaming loaders: a first pass scans the file for the bounds (and the LAS color ranges), then every window is decoded and inserted in PointCloud.
+	 * Decimation is applied per window (the target point count is split proportionally), the caller refreshes the bounds and the rendering.
+	 */
+	static bool StreamPointsFromLASFile(const FString& Filename, const int64 MemoryBudget, FVector& Origin, ULidarPointCloud* PointCloud, FglTFRuntimePointCloudLoadContext& Context);
+
+	static bool StreamPointsFromXYZFile(const FString& Filename, const int64 MemoryBudget, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig, ULidarPointCloud* PointCloud, FglTFRuntimePointCloudLoadContext& Context);
+
+	/* Builds the octree of the loaded points (sorted first when Config.bSortPoints), its time is added to the load report of Context (logged at the end) */
+	static ULidarPointCloud* CreatePointCloud(TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context);
 
-	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "ASCIIPointCloudConfig"))
-	static ULidarPointCloud* LoadPointCloudFromXYZ(UglTFRuntimeAsset* Asset, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig);
+	/* Consecutive runs of at most Config.MaxPointsPerCloud points (a single cloud when it is <= 0), in input order or in Morton order (compact clouds) when Config.bSortPoints */
+	static TArray<ULidarPointCloud*> CreatePointClouds(TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context);
 
-	UFUNCTION(BlueprintCallable, Category = "glTFRuntime|PointCloud", meta = (AutoCreateRefTerm = "ASCIIPointCloudConfig"))
-	static ULidarPointCloud* LoadPointCloudFromPCD(UglTFRuntimeAsset* Asset, FTransform& ViewPoint);
+	static bool WritePointsToPCD(const TArray64<FLidarPointCloudPoint>& Points, const bool bBinaryCompressed, TArray64<uint8>& Blob);
 
-	static ULidarPointCloud* LoadPointCloudFromXYZWithFilter(UglTFRuntimeAsset* Asset, TFunction<void(FLidarPointCloudPoint&, const TArray<FString>&, const FglTFRuntimeASCIIPointCloudConfig&) > StringFilter, TFunction<void(FLidarPointCloudPoint&, const TArray<double>&, const TArray<double>&, const TArray<double>&, const FglTFRuntimeASCIIPointCloudConfig&)> FloatFilter, const FglTFRuntimeASCIIPointCloudConfig& ASCIIPointCloudConfig);
+protected:
+	static bool LoadPointsFromPCDASCII(const TArray64<uint8>& Blob, const glTFRuntimePointCloud::FPCDHeader& Header, TArray64<FLidarPointCloudPoint>& Points, FglTFRuntimePointCloudLoadContext& Context);
 
 };
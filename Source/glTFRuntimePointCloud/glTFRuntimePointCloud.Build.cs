@@ -37,6 +37,7 @@ public class glTFRuntimePointCloud : ModuleRules
 				"CoreUObject",
 				"Engine",
 				"glTFRuntime",
+				"Json",
 				"LidarPointCloudRuntime"
 				// ... add private dependencies that you statically link with here ...	
 			}